@@ -0,0 +1,112 @@
+#include "bench_positions.h"
+
+#include <battlesnake/rules/errors.h>
+#include <battlesnake/rules/random.h>
+
+#include <string>
+
+namespace battlesnake {
+namespace bench {
+
+using namespace battlesnake::rules;
+
+namespace {
+
+static constexpr Move kMoves[] = {Move::Up, Move::Down, Move::Left,
+                                  Move::Right};
+
+// Random move of every snake that doesn't hit a wall or a body, if any.
+JointMove SafeJointMove(const BoardState& state, RandomGenerator& random) {
+  JointMove joint_move = 0;
+  for (int i = 0; i < state.snakes.size(); ++i) {
+    const Snake& snake = state.snakes[i];
+    if (snake.IsEliminated()) {
+      continue;
+    }
+
+    Move safe_moves[4];
+    int safe_moves_count = 0;
+    for (Move move : kMoves) {
+      const Point p =
+          snake.Head().Moved(move, snake.body.WrappedBoardSizePtr());
+      if (state.InBounds(p) && !state.Bodies().Get(p)) {
+        safe_moves[safe_moves_count++] = move;
+      }
+    }
+    const Move move = safe_moves_count == 0
+                          ? kMoves[random.Uniform(4)]
+                          : safe_moves[random.Uniform(safe_moves_count)];
+    SetSnakeMove(joint_move, i, move);
+  }
+  return joint_move;
+}
+
+}  // namespace
+
+std::vector<Position> CreateMidGamePositions(StandardRuleset& ruleset,
+                                             StringPool& pool,
+                                             Coordinate board_size,
+                                             int snakes_count, int count) {
+  std::vector<SnakeId> ids;
+  for (int i = 0; i < snakes_count; ++i) {
+    ids.push_back(pool.Add("snake" + std::to_string(i)));
+  }
+  const StringWrapper squads[] = {pool.Add("red"), pool.Add("blue")};
+
+  RandomGenerator random(1);
+  std::vector<Position> result;
+  const int turns = board_size * 2;
+  for (int game = 0; game < count; ++game) {
+    ruleset.SetRandomSeed(game + 1);
+    BoardState state{};
+    try {
+      state = ruleset.CreateInitialBoardState(board_size, board_size, ids);
+    } catch (const RulesetException&) {
+      // Too many snakes for this board.
+      return result;
+    }
+    for (int i = 0; i < state.snakes.size(); ++i) {
+      state.snakes[i].name = ids[i];
+      state.snakes[i].squad = squads[i % 2];
+    }
+
+    // Games that end early, e.g. squad games with shared elimination, give
+    // their last position before the end.
+    Position position{
+        .state = state,
+        .turn = 1,
+        .joint_move = SafeJointMove(state, random),
+    };
+    for (int turn = 1; turn < turns; ++turn) {
+      BoardState next{};
+      ruleset.CreateNextBoardStateJoint(position.state, position.joint_move,
+                                        turn, next);
+      if (ruleset.IsGameOver(next)) {
+        break;
+      }
+      position = Position{
+          .state = next,
+          .turn = turn + 1,
+          .joint_move = SafeJointMove(next, random),
+      };
+    }
+    result.push_back(position);
+  }
+  return result;
+}
+
+GameState CreateGameState(const Position& position, StringPool& pool) {
+  return GameState{
+      .game{
+          .id = pool.Add("benchmark-game-id"),
+          .ruleset{.name = pool.Add("standard"), .version = pool.Add("v1.0.0")},
+          .timeout = 500,
+      },
+      .turn = position.turn,
+      .board = position.state,
+      .you = position.state.snakes[0],
+  };
+}
+
+}  // namespace bench
+}  // namespace battlesnake
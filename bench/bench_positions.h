@@ -0,0 +1,32 @@
+#pragma once
+
+#include <battlesnake/rules/ruleset.h>
+#include <battlesnake/rules/standard_ruleset.h>
+
+#include <vector>
+
+namespace battlesnake {
+namespace bench {
+
+// A mid-game position and a joint move that doesn't kill any snake at once.
+struct Position {
+  battlesnake::rules::BoardState state;
+  int turn;
+  battlesnake::rules::JointMove joint_move;
+};
+
+// Plays `count` seeded games with random moves that avoid walls and bodies,
+// and stops each one in the middle, after 2 turns per board cell of width or
+// right before the game ends. Snakes are split into two squads. Returns no
+// positions if games with this many snakes can't be created on this board.
+std::vector<Position> CreateMidGamePositions(
+    battlesnake::rules::StandardRuleset& ruleset,
+    battlesnake::rules::StringPool& pool,
+    battlesnake::rules::Coordinate board_size, int snakes_count, int count);
+
+// Game state of a position as sent to the first snake.
+battlesnake::rules::GameState CreateGameState(
+    const Position& position, battlesnake::rules::StringPool& pool);
+
+}  // namespace bench
+}  // namespace battlesnake
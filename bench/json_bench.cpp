@@ -0,0 +1,121 @@
+#include <battlesnake/json/converter.h>
+#include <battlesnake/rules/standard_ruleset.h>
+#include <benchmark/benchmark.h>
+
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "allocation_scope.h"
+#include "bench_positions.h"
+
+namespace battlesnake {
+namespace bench {
+
+namespace {
+
+using namespace battlesnake::rules;
+using namespace battlesnake::json;
+
+constexpr int kPositionsCount = 32;
+
+// Game states of mid-game positions, as JSON texts.
+std::vector<std::string> CreateGameStateTexts(Coordinate board_size,
+                                              int snakes_count) {
+  StandardRuleset ruleset;
+  StringPool pool;
+  std::vector<std::string> result;
+  for (const Position& position : CreateMidGamePositions(
+           ruleset, pool, board_size, snakes_count, kPositionsCount)) {
+    result.push_back(CreateJson(CreateGameState(position, pool)).dump());
+  }
+  return result;
+}
+
+// Arguments: board size, snakes count.
+void BM_ParseJsonGameState(benchmark::State& state) {
+  std::vector<nlohmann::json> jsons;
+  for (const std::string& text :
+       CreateGameStateTexts(state.range(0), state.range(1))) {
+    jsons.push_back(nlohmann::json::parse(text));
+  }
+  if (jsons.empty()) {
+    state.SkipWithError("No positions for this board size and snakes count");
+    return;
+  }
+
+  int i = 0;
+  for (auto _ : state) {
+    StringPool pool;
+    GameState game_state = ParseJsonGameState(jsons[i], pool);
+    benchmark::DoNotOptimize(game_state);
+    i = (i + 1) % jsons.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Same as BM_ParseJsonGameState, including parsing of the text, the way the
+// server does it.
+void BM_ParseJsonGameStateText(benchmark::State& state) {
+  const std::vector<std::string> texts =
+      CreateGameStateTexts(state.range(0), state.range(1));
+  if (texts.empty()) {
+    state.SkipWithError("No positions for this board size and snakes count");
+    return;
+  }
+
+  int64_t bytes = 0;
+  int i = 0;
+  allocations::AllocationScope allocations;
+  for (auto _ : state) {
+    StringPool pool;
+    GameState game_state =
+        ParseJsonGameState(nlohmann::json::parse(texts[i]), pool);
+    benchmark::DoNotOptimize(game_state);
+    bytes += texts[i].size();
+    i = (i + 1) % texts.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(bytes);
+  state.counters["allocs"] = benchmark::Counter(
+      allocations.Count(), benchmark::Counter::kAvgIterations);
+}
+
+// Arguments: board size, snakes count.
+void BM_CreateJsonGameState(benchmark::State& state) {
+  StandardRuleset ruleset;
+  StringPool pool;
+  std::vector<GameState> game_states;
+  for (const Position& position : CreateMidGamePositions(
+           ruleset, pool, state.range(0), state.range(1), kPositionsCount)) {
+    game_states.push_back(CreateGameState(position, pool));
+  }
+  if (game_states.empty()) {
+    state.SkipWithError("No positions for this board size and snakes count");
+    return;
+  }
+
+  int i = 0;
+  for (auto _ : state) {
+    std::string text = CreateJson(game_states[i]).dump();
+    benchmark::DoNotOptimize(text);
+    i = (i + 1) % game_states.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+#define BENCHMARK_JSON(function)                          \
+  BENCHMARK(function)                                     \
+      ->ArgNames({"size", "snakes"})                      \
+      ->ArgsProduct({{kBoardSizeSmall, kBoardSizeMedium,  \
+                      kBoardSizeLarge},                   \
+                     {2, 4, 8}})
+
+BENCHMARK_JSON(BM_ParseJsonGameState);
+BENCHMARK_JSON(BM_ParseJsonGameStateText);
+BENCHMARK_JSON(BM_CreateJsonGameState);
+
+}  // namespace
+
+}  // namespace bench
+}  // namespace battlesnake
@@ -0,0 +1,240 @@
+#include <battlesnake/rules/board_bits_ops.h>
+#include <battlesnake/rules/constrictor_ruleset.h>
+#include <battlesnake/rules/royale_ruleset.h>
+#include <battlesnake/rules/sized_standard_ruleset.h>
+#include <battlesnake/rules/solo_ruleset.h>
+#include <battlesnake/rules/squad_ruleset.h>
+#include <battlesnake/rules/standard_ruleset.h>
+#include <battlesnake/rules/wrapped_ruleset.h>
+#include <benchmark/benchmark.h>
+
+#include <bit>
+#include <type_traits>
+#include <vector>
+
+#include "battlesnake/rules/random.h"
+
+#include "allocation_scope.h"
+#include "bench_positions.h"
+
+namespace battlesnake {
+namespace bench {
+
+namespace {
+
+using namespace battlesnake::rules;
+
+constexpr int kPositionsCount = 32;
+
+// Arguments: board size, snakes count.
+template <class RulesetT>
+void BM_CreateNextBoardState(benchmark::State& state) {
+  RulesetT ruleset;
+  StringPool pool;
+  const std::vector<Position> positions = CreateMidGamePositions(
+      ruleset, pool, state.range(0), state.range(1), kPositionsCount);
+  if (positions.empty()) {
+    state.SkipWithError("No positions for this board size and snakes count");
+    return;
+  }
+
+  BoardState next{};
+  int i = 0;
+  allocations::AllocationScope allocations;
+  for (auto _ : state) {
+    const Position& position = positions[i];
+    ruleset.CreateNextBoardStateJoint(position.state, position.joint_move,
+                                      position.turn, next);
+    benchmark::DoNotOptimize(next);
+    i = (i + 1) % positions.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["allocs"] = benchmark::Counter(
+      allocations.Count(), benchmark::Counter::kAvgIterations);
+}
+
+#define BENCHMARK_RULESET(RulesetT)                         \
+  BENCHMARK_TEMPLATE(BM_CreateNextBoardState, RulesetT)     \
+      ->ArgNames({"size", "snakes"})                        \
+      ->ArgsProduct({{kBoardSizeSmall, kBoardSizeMedium,    \
+                      kBoardSizeLarge},                     \
+                     {2, 4, 8}})
+
+BENCHMARK_RULESET(StandardRuleset);
+BENCHMARK_RULESET(SoloRuleset);
+BENCHMARK_RULESET(RoyaleRuleset);
+BENCHMARK_RULESET(ConstrictorRuleset);
+BENCHMARK_RULESET(SquadRuleset);
+BENCHMARK_RULESET(WrappedRuleset);
+
+using MediumRuleset = StandardRulesetT<kBoardSizeMedium, kBoardSizeMedium,
+                                       kSnakesCountStandard>;
+
+// Mid game states of 11x11 games with 4 snakes, as RulesetT::State.
+template <class RulesetT>
+std::vector<typename RulesetT::State> MediumStates(
+    RulesetT& ruleset, StringPool& pool, std::vector<Position>& positions) {
+  using StateT = typename RulesetT::State;
+  positions = CreateMidGamePositions(ruleset, pool, kBoardSizeMedium,
+                                     kSnakesCountStandard, kPositionsCount);
+  std::vector<StateT> result;
+  for (const Position& position : positions) {
+    if constexpr (std::is_same_v<StateT, BoardState>) {
+      result.push_back(position.state);
+    } else {
+      result.push_back(StateT::FromBoardState(position.state));
+    }
+  }
+  return result;
+}
+
+// Copy of a state, as made by searches for every child. Compares BoardState
+// with the state specialized for the board size, see sized_board_state.h.
+template <class RulesetT>
+void BM_BoardStateCopy(benchmark::State& state) {
+  using StateT = typename RulesetT::State;
+  RulesetT ruleset;
+  StringPool pool;
+  std::vector<Position> positions;
+  const std::vector<StateT> states = MediumStates(ruleset, pool, positions);
+
+  StateT copy{};
+  int i = 0;
+  for (auto _ : state) {
+    copy = states[i];
+    benchmark::DoNotOptimize(copy);
+    i = (i + 1) % states.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * sizeof(StateT));
+}
+BENCHMARK_TEMPLATE(BM_BoardStateCopy, StandardRuleset);
+BENCHMARK_TEMPLATE(BM_BoardStateCopy, MediumRuleset);
+
+// Same as BM_CreateNextBoardState for 11x11 with 4 snakes, for both state
+// types.
+template <class RulesetT>
+void BM_BoardStateStep(benchmark::State& state) {
+  using StateT = typename RulesetT::State;
+  RulesetT ruleset;
+  StringPool pool;
+  std::vector<Position> positions;
+  const std::vector<StateT> states = MediumStates(ruleset, pool, positions);
+
+  StateT next{};
+  int i = 0;
+  for (auto _ : state) {
+    const Position& position = positions[i];
+    ruleset.CreateNextBoardStateJoint(states[i], position.joint_move,
+                                      position.turn, next);
+    benchmark::DoNotOptimize(next);
+    i = (i + 1) % states.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_BoardStateStep, StandardRuleset);
+BENCHMARK_TEMPLATE(BM_BoardStateStep, MediumRuleset);
+
+// Body going around the board in a spiral, without stacked pieces.
+std::vector<Point> SpiralBody(int length) {
+  std::vector<Point> result;
+  Point p{0, 0};
+  const Move moves[] = {Move::Right, Move::Up, Move::Left, Move::Down};
+  int direction = 0;
+  int run = 1;
+  while (result.size() < length) {
+    for (int step = 0; step < run && result.size() < length; ++step) {
+      result.push_back(p);
+      p = p.Moved(moves[direction]);
+    }
+    direction = (direction + 1) % 4;
+    if (direction % 2 == 0) {
+      ++run;
+    }
+  }
+  return result;
+}
+
+// Argument: body length.
+void BM_SnakeBodyCreate(benchmark::State& state) {
+  const std::vector<Point> points = SpiralBody(state.range(0));
+  for (auto _ : state) {
+    SnakeBody body = SnakeBody::Create(points);
+    benchmark::DoNotOptimize(body);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SnakeBodyCreate)->ArgName("length")->Arg(3)->Arg(20)->Arg(100);
+
+// Argument: body length.
+void BM_SnakeBodyMoveTo(benchmark::State& state) {
+  SnakeBody body = SnakeBody::Create(SpiralBody(state.range(0)));
+  // Goes around a square, so the head stays near the start.
+  const Move moves[] = {Move::Up, Move::Right, Move::Down, Move::Left};
+  int i = 0;
+  for (auto _ : state) {
+    body.MoveTo(moves[i]);
+    benchmark::DoNotOptimize(body);
+    i = (i + 1) % 4;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SnakeBodyMoveTo)->ArgName("length")->Arg(3)->Arg(20)->Arg(100);
+
+std::vector<BoardBits> RandomBoardBits(int count) {
+  RandomGenerator random(1);
+  std::vector<BoardBits> result(count);
+  for (BoardBits& bits : result) {
+    for (BoardBits::BlockType& block : bits.data) {
+      block = random.Next();
+    }
+  }
+  return result;
+}
+
+// Inline operations, as used by rulesets.
+void BM_BoardBitsAnd(benchmark::State& state) {
+  const std::vector<BoardBits> bits = RandomBoardBits(kPositionsCount);
+  BoardBits result{};
+  int i = 0;
+  for (auto _ : state) {
+    result = And(Or(result, bits[i]), bits[(i + 1) % bits.size()]);
+    benchmark::DoNotOptimize(result);
+    i = (i + 1) % bits.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BoardBitsAnd);
+
+// Portable inline loop, as compiled without target attributes.
+void BM_BoardBitsPopCountInline(benchmark::State& state) {
+  const std::vector<BoardBits> bits = RandomBoardBits(kPositionsCount);
+  int i = 0;
+  for (auto _ : state) {
+    int count = 0;
+    for (BoardBits::BlockType block : bits[i].data) {
+      count += std::popcount(block);
+    }
+    benchmark::DoNotOptimize(count);
+    i = (i + 1) % bits.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BoardBitsPopCountInline);
+
+// Kernel selected for this CPU, as used by PopCount().
+void BM_BoardBitsPopCount(benchmark::State& state) {
+  const std::vector<BoardBits> bits = RandomBoardBits(kPositionsCount);
+  int i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(PopCount(bits[i]));
+    i = (i + 1) % bits.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BoardBitsPopCount);
+
+}  // namespace
+
+}  // namespace bench
+}  // namespace battlesnake
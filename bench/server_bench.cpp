@@ -0,0 +1,71 @@
+#include <battlesnake/interface/battlesnake.h>
+#include <battlesnake/json/converter.h>
+#include <battlesnake/rules/standard_ruleset.h>
+#include <battlesnake/server/server.h>
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_positions.h"
+#include "client_http.hpp"
+
+namespace battlesnake {
+namespace bench {
+
+namespace {
+
+using namespace battlesnake::rules;
+using namespace battlesnake::json;
+
+using HttpClient = SimpleWeb::Client<SimpleWeb::HTTP>;
+
+constexpr int kPortNumber = 18889;
+constexpr int kThreadsCount = 2;
+
+// Responds with the default move right away, so only the server is measured.
+class IdleBattlesnake : public battlesnake::interface::Battlesnake {};
+
+// Full /move request: HTTP, JSON parsing, the snake and the response.
+// Arguments: board size, snakes count.
+void BM_ServerMove(benchmark::State& state) {
+  StandardRuleset ruleset;
+  StringPool pool;
+  std::vector<Position> positions = CreateMidGamePositions(
+      ruleset, pool, state.range(0), state.range(1), 1);
+  if (positions.empty()) {
+    state.SkipWithError("No positions for this board size and snakes count");
+    return;
+  }
+  const std::string request =
+      CreateJson(CreateGameState(positions[0], pool)).dump();
+
+  IdleBattlesnake battlesnake;
+  server::BattlesnakeServer server(&battlesnake, kPortNumber, kThreadsCount);
+  std::unique_ptr<std::thread> server_thread = server.RunOnNewThread();
+
+  HttpClient client("localhost:" + std::to_string(kPortNumber));
+  for (auto _ : state) {
+    auto response = client.request("POST", "/move", request);
+    std::stringstream ss;
+    ss << response->content.rdbuf();
+    benchmark::DoNotOptimize(ss);
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  server.Stop();
+  server_thread->join();
+}
+BENCHMARK(BM_ServerMove)
+    ->ArgNames({"size", "snakes"})
+    ->Args({kBoardSizeMedium, 4})
+    ->Args({kBoardSizeLarge, 8})
+    ->UseRealTime();
+
+}  // namespace
+
+}  // namespace bench
+}  // namespace battlesnake
@@ -40,7 +40,13 @@ class Battlesnake {
 
   // "Async" interface. Override these functions if you need to do something
   // extra after responding. `game_state` uses references to strings in the
-  // string pool. Keep `string_pool` alive while `game_state` is used.
+  // string pool. Keep `string_pool` alive while `game_state` is used. The
+  // server creates a new string pool for every request and frees it when the
+  // request is responded and no one else holds it, so keep the pool of
+  // /start to use its game state in later requests. The game player shares
+  // one pool for the whole game. If it's set to free old strings, strings of
+  // turns older than the previous one are freed, so don't keep strings added
+  // to the pool in /move then.
 
   virtual void GetCustomization(
       std::function<void(const battlesnake::rules::Customization& result)>
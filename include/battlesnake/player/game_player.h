@@ -1,7 +1,9 @@
 #pragma once
 
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "battlesnake/interface/battlesnake.h"
 #include "battlesnake/rules/ruleset.h"
@@ -34,6 +36,10 @@ class GamePlayer {
 
   void SetPrintMode(PrintMode mode);
   void SetRequestsMode(RequestsMode mode);
+  // Frees strings of turns older than the previous one after every turn, so
+  // that shouts don't pile up in long games. Off by default: snakes that keep
+  // strings of older turns must not be used with it.
+  void SetFreeOldStrings(bool free_old_strings);
 
   void Play();
 
@@ -56,12 +62,10 @@ class GamePlayer {
   std::vector<PlayerInfo> players_;
   PrintMode print_mode_ = PrintMode::DoNotPrint;
   RequestsMode requests_mode_ = RequestsMode::Parallel;
+  bool free_old_strings_ = false;
 
   std::shared_ptr<battlesnake::rules::StringPool> string_pool_ =
       std::make_shared<battlesnake::rules::StringPool>();
-  std::unordered_map<battlesnake::rules::SnakeId,
-                     battlesnake::interface::Battlesnake*>
-      snakes_map_;
 
   std::vector<battlesnake::rules::SnakeId> winners_;
 
@@ -69,13 +73,24 @@ class GamePlayer {
                  const std::unordered_map<battlesnake::rules::SnakeId, char>&
                      snake_head_syms) const;
 
+  // Players are added in the same order as snakes are created, so snake
+  // handles are indices in `players_`. Snakes with invalid or unknown handles,
+  // e.g. created by a ruleset that doesn't assign them, have no player: they
+  // are not asked for moves and are never used as indices.
+  bool HasPlayer(const battlesnake::rules::Snake& snake) const;
+  // Returns nullptr for snakes without a player.
+  battlesnake::interface::Battlesnake* SnakeInterface(
+      const battlesnake::rules::Snake& snake) const;
+
   void StartAll(const battlesnake::rules::GameState& game);
   void EndAll(const battlesnake::rules::GameState& game);
 
-  using GetMovesResult = std::tuple<
-      std::unordered_map<battlesnake::rules::SnakeId,
-                         battlesnake::interface::Battlesnake::MoveResponse>,
-      std::unordered_map<battlesnake::rules::SnakeId, int>>;
+  // Both are indexed by snake handle. Snakes that didn't respond have no
+  // response and zero latency.
+  using MoveResponsesVector = std::vector<
+      std::optional<battlesnake::interface::Battlesnake::MoveResponse>>;
+  using LatenciesVector = std::vector<int>;
+  using GetMovesResult = std::tuple<MoveResponsesVector, LatenciesVector>;
 
   GetMovesResult GetMovesParallel(const battlesnake::rules::GameState& game);
   GetMovesResult GetMovesSequential(const battlesnake::rules::GameState& game);
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <battlesnake/rules/board_bits_ops.h>
+#include <battlesnake/rules/data_types.h>
+#include <battlesnake/rules/ruleset.h>
+
+#include <vector>
+
+namespace battlesnake {
+namespace rules {
+
+// Board analysis kernels commonly used by snakes to evaluate positions. All of
+// them work on whole BoardBits at once instead of visiting points one by one.
+
+// Returns cells that can't be entered: bodies and heads of all snakes that are
+// not eliminated, and optionally hazards.
+BoardBits Obstacles(const BoardState& state, bool include_hazards = false);
+
+struct FloodFillResult {
+  // All reached cells, including start cells.
+  BoardBits reached;
+  // Number of reached cells, excluding start cells.
+  int area;
+  // Number of steps made until there were no new cells to expand to or the
+  // steps limit was reached. Distance to the farthest reached cell.
+  int steps;
+};
+
+// Expands the whole frontier by one step at a time, starting from `start`
+// cells and never entering `obstacles`. Start cells are always reached even if
+// they are obstacles themselves, e.g. a snake head. Board size and wrapping
+// are taken from `shifter`.
+//
+// Stops after `max_steps` steps if it's not negative. If `layers` is provided,
+// it's filled with cells reached at each step: layers[0] is start cells,
+// layers[i] are the cells at distance i.
+FloodFillResult FloodFill(const BoardBits& start, const BoardBits& obstacles,
+                          const BoardBitsShifter& shifter, int max_steps = -1,
+                          std::vector<BoardBits>* layers = nullptr);
+
+// Flood fill from the head of the snake with the given index. Bodies and heads
+// of other snakes, and optionally hazards, are obstacles. Doesn't account for
+// tails moving away.
+FloodFillResult ReachableArea(const BoardState& state, int snake_index,
+                              const BoardBitsShifter& shifter,
+                              bool include_hazards = false);
+
+// Partition of the board between snakes: every cell belongs to the snake that
+// can reach it first. Cells reached by several snakes at the same time go to
+// the longest of them, like in a head-to-head collision. If the longest snakes
+// have equal length, nobody gets the cell and it's marked neutral. Neutral and
+// owned cells block expansion of other snakes.
+struct Territory {
+  static constexpr int kNoOwner = -1;
+  static constexpr int kUnreachable = -1;
+
+  Coordinate width;
+  Coordinate height;
+  // Per cell values, indexed by y * width + x.
+  // Index of the snake that owns the cell, or kNoOwner.
+  signed char owner[BoardBits::kBitsSizeNeeded];
+  // Number of moves for the owner to reach the cell, or kUnreachable. For
+  // neutral cells it's the distance for the snakes that tied.
+  short distance[BoardBits::kBitsSizeNeeded];
+  // Cells owned by each snake, indexed by snake index. Includes snake head.
+  BoardBits cells[kSnakesCountMax];
+  // Cells reached by snakes of equal length at the same time.
+  BoardBits neutral;
+  // Number of cells owned by each snake, including its head.
+  int area[kSnakesCountMax];
+
+  int Owner(const Point& p) const { return owner[p.y * width + p.x]; }
+  int Distance(const Point& p) const { return distance[p.y * width + p.x]; }
+};
+
+// Computes territory with simultaneous BFS from heads of all snakes that are
+// not eliminated. Bodies, and optionally hazards, are obstacles. Doesn't
+// account for tails moving away.
+Territory ComputeTerritory(const BoardState& state,
+                           const BoardBitsShifter& shifter,
+                           bool include_hazards = false);
+
+struct SafeMovesConfig {
+  // Damage dealt by hazards per turn on top of the usual 1 health point, as in
+  // RoyaleRuleset. 0 means hazards are not dangerous.
+  int hazard_damage_per_turn = 0;
+  // Health restored by food, used to detect it like RoyaleRuleset does.
+  int snake_max_health = 100;
+  // Also avoid cells where the snake may meet the head of a snake that is not
+  // shorter than itself.
+  bool avoid_head_to_head = false;
+
+  static SafeMovesConfig Default() { return SafeMovesConfig(); }
+};
+
+// Returns moves of the snake with the given index that don't eliminate it
+// right away, as a mask of MoveBit() values. A move is unsafe if it leaves the
+// board (wrapping around if the snake body is wrapped), enters a body or a
+// head of a snake that leaves its neck there, or the snake runs out of health
+// there. Tails that move away this turn are safe. Eliminated snakes have no
+// safe moves. Expects `bodies` of the state to be up to date.
+//
+// Blocked and contested cells are combined into bitboards once per call, so
+// each move is a few bit lookups. Contested cells are found with `shifter`,
+// which must be created for the board of the state.
+MoveMask SafeMoves(const BoardState& state, int snake_index,
+                   const BoardBitsShifter& shifter,
+                   const SafeMovesConfig& config = SafeMovesConfig::Default());
+
+}  // namespace rules
+}  // namespace battlesnake
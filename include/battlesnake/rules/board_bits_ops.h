@@ -0,0 +1,269 @@
+#pragma once
+
+#include <battlesnake/rules/data_types.h>
+
+#include <bit>
+
+namespace battlesnake {
+namespace rules {
+
+// Bitwise algebra over whole BoardBits. Binary operations are inline loops over
+// 10 blocks, which compilers unroll and vectorize in place: an indirect call
+// costs as much as the operation itself. PopCount() and SelectBit() go through
+// a table of kernels selected once at runtime for the current CPU, because
+// hardware popcnt, tzcnt and blsr instructions are only available with
+// explicit target attributes in portable builds: popcnt kernels on x86-64
+// machines that support them, portable scalar code otherwise. See
+// BM_BoardBits* benchmarks.
+
+// Table of kernels implementing operations over BoardBits that need
+// instructions selected at runtime.
+struct BoardBitsKernels {
+  const char* name;
+  int (*pop_count)(const BoardBits& a);
+  // Index of the set bit with the given rank, counting from the lowest bit
+  // starting with 0. Returns -1 if there are not enough set bits.
+  int (*select_bit)(const BoardBits& a, int rank);
+};
+
+// Kernels best suited for the current CPU.
+const BoardBitsKernels& GetBoardBitsKernels();
+// Portable kernels. Always available.
+const BoardBitsKernels& GetScalarBoardBitsKernels();
+// Kernels using popcnt, and BMI1 tzcnt and blsr for bit selection. Returns
+// nullptr if they are not compiled in or the CPU doesn't support them.
+const BoardBitsKernels* GetPopcntBoardBitsKernels();
+
+inline BoardBits And(const BoardBits& a, const BoardBits& b) {
+  BoardBits result;
+  for (int i = 0; i < BoardBits::kBlocksCount; ++i) {
+    result.data[i] = a.data[i] & b.data[i];
+  }
+  return result;
+}
+
+inline BoardBits Or(const BoardBits& a, const BoardBits& b) {
+  BoardBits result;
+  for (int i = 0; i < BoardBits::kBlocksCount; ++i) {
+    result.data[i] = a.data[i] | b.data[i];
+  }
+  return result;
+}
+
+// Bits of a that are not set in b.
+inline BoardBits AndNot(const BoardBits& a, const BoardBits& b) {
+  BoardBits result;
+  for (int i = 0; i < BoardBits::kBlocksCount; ++i) {
+    result.data[i] = a.data[i] & ~b.data[i];
+  }
+  return result;
+}
+
+inline BoardBits Xor(const BoardBits& a, const BoardBits& b) {
+  BoardBits result;
+  for (int i = 0; i < BoardBits::kBlocksCount; ++i) {
+    result.data[i] = a.data[i] ^ b.data[i];
+  }
+  return result;
+}
+
+inline int PopCount(const BoardBits& a) {
+  return GetBoardBitsKernels().pop_count(a);
+}
+
+// Index of the set bit with the given rank, see BoardBitsKernels::select_bit.
+// Picking a random cell out of a set is SelectBit(bits, random(PopCount(bits))).
+inline int SelectBit(const BoardBits& a, int rank) {
+  return GetBoardBitsKernels().select_bit(a, rank);
+}
+
+inline bool IsEmpty(const BoardBits& a) {
+  BoardBits::BlockType any = 0;
+  for (BoardBits::BlockType block : a.data) {
+    any |= block;
+  }
+  return any == 0;
+}
+
+inline BoardBits operator&(const BoardBits& a, const BoardBits& b) {
+  return And(a, b);
+}
+inline BoardBits operator|(const BoardBits& a, const BoardBits& b) {
+  return Or(a, b);
+}
+inline BoardBits operator^(const BoardBits& a, const BoardBits& b) {
+  return Xor(a, b);
+}
+inline BoardBits& operator&=(BoardBits& a, const BoardBits& b) {
+  for (int i = 0; i < BoardBits::kBlocksCount; ++i) {
+    a.data[i] &= b.data[i];
+  }
+  return a;
+}
+inline BoardBits& operator|=(BoardBits& a, const BoardBits& b) {
+  for (int i = 0; i < BoardBits::kBlocksCount; ++i) {
+    a.data[i] |= b.data[i];
+  }
+  return a;
+}
+inline BoardBits& operator^=(BoardBits& a, const BoardBits& b) {
+  for (int i = 0; i < BoardBits::kBlocksCount; ++i) {
+    a.data[i] ^= b.data[i];
+  }
+  return a;
+}
+
+// Returns index of the lowest set bit, or -1 if there are none.
+inline int FirstBit(const BoardBits& bits) {
+  for (int i = 0; i < BoardBits::kBlocksCount; ++i) {
+    if (bits.data[i] != 0) {
+      return i * BoardBits::kBlockSizeBits + std::countr_zero(bits.data[i]);
+    }
+  }
+  return -1;
+}
+
+// Calls f(index) for every set bit in ascending order of index.
+template <class F>
+inline void ForEachBit(const BoardBits& bits, F&& f) {
+  for (int i = 0; i < BoardBits::kBlocksCount; ++i) {
+    BoardBits::BlockType block = bits.data[i];
+    while (block != 0) {
+      f(i * BoardBits::kBlockSizeBits + std::countr_zero(block));
+      // Clear the lowest set bit.
+      block &= block - 1;
+    }
+  }
+}
+
+// Same operations over BoardBitsT. They have one or two blocks, so portable
+// code is as fast as the kernels.
+
+template <int kBlocks>
+inline BoardBitsT<kBlocks> And(const BoardBitsT<kBlocks>& a,
+                               const BoardBitsT<kBlocks>& b) {
+  BoardBitsT<kBlocks> result;
+  for (int i = 0; i < kBlocks; ++i) {
+    result.data[i] = a.data[i] & b.data[i];
+  }
+  return result;
+}
+
+template <int kBlocks>
+inline BoardBitsT<kBlocks> Or(const BoardBitsT<kBlocks>& a,
+                              const BoardBitsT<kBlocks>& b) {
+  BoardBitsT<kBlocks> result;
+  for (int i = 0; i < kBlocks; ++i) {
+    result.data[i] = a.data[i] | b.data[i];
+  }
+  return result;
+}
+
+template <int kBlocks>
+inline BoardBitsT<kBlocks> AndNot(const BoardBitsT<kBlocks>& a,
+                                  const BoardBitsT<kBlocks>& b) {
+  BoardBitsT<kBlocks> result;
+  for (int i = 0; i < kBlocks; ++i) {
+    result.data[i] = a.data[i] & ~b.data[i];
+  }
+  return result;
+}
+
+template <int kBlocks>
+inline BoardBitsT<kBlocks> Xor(const BoardBitsT<kBlocks>& a,
+                               const BoardBitsT<kBlocks>& b) {
+  BoardBitsT<kBlocks> result;
+  for (int i = 0; i < kBlocks; ++i) {
+    result.data[i] = a.data[i] ^ b.data[i];
+  }
+  return result;
+}
+
+template <int kBlocks>
+inline int PopCount(const BoardBitsT<kBlocks>& a) {
+  int result = 0;
+  for (int i = 0; i < kBlocks; ++i) {
+    result += std::popcount(a.data[i]);
+  }
+  return result;
+}
+
+template <int kBlocks>
+inline int SelectBit(const BoardBitsT<kBlocks>& a, int rank) {
+  for (int i = 0; i < kBlocks; ++i) {
+    BoardBits::BlockType block = a.data[i];
+    const int count = std::popcount(block);
+    if (rank >= count) {
+      rank -= count;
+      continue;
+    }
+    for (; rank > 0; --rank) {
+      // Clear the lowest set bit.
+      block &= block - 1;
+    }
+    return i * BoardBits::kBlockSizeBits + std::countr_zero(block);
+  }
+  return -1;
+}
+
+template <int kBlocks>
+inline bool IsEmpty(const BoardBitsT<kBlocks>& a) {
+  BoardBits::BlockType any = 0;
+  for (BoardBits::BlockType block : a.data) {
+    any |= block;
+  }
+  return any == 0;
+}
+
+template <int kBlocks, class F>
+inline void ForEachBit(const BoardBitsT<kBlocks>& bits, F&& f) {
+  for (int i = 0; i < kBlocks; ++i) {
+    BoardBits::BlockType block = bits.data[i];
+    while (block != 0) {
+      f(i * BoardBits::kBlockSizeBits + std::countr_zero(block));
+      // Clear the lowest set bit.
+      block &= block - 1;
+    }
+  }
+}
+
+// Moves all set cells of the board by one step in some direction. Cells that
+// leave the board are dropped, or reappear on the opposite side in wrapped
+// mode. Bits outside of the board are never set in the results.
+//
+// Masks are precomputed in constructor, so create shifter once per board size
+// and reuse it.
+class BoardBitsShifter {
+ public:
+  BoardBitsShifter(int width, int height, bool wrapped = false);
+
+  BoardBits Up(const BoardBits& bits) const;
+  BoardBits Down(const BoardBits& bits) const;
+  BoardBits Left(const BoardBits& bits) const;
+  BoardBits Right(const BoardBits& bits) const;
+  BoardBits Moved(const BoardBits& bits, Move move) const;
+
+  // Union of shifts in all four directions. Doesn't include original cells.
+  BoardBits Neighbours(const BoardBits& bits) const;
+
+  // All cells of the board.
+  const BoardBits& BoardMask() const { return board_; }
+
+  int Width() const { return width_; }
+  int Height() const { return height_; }
+  bool Wrapped() const { return wrapped_; }
+
+ private:
+  int width_;
+  int height_;
+  bool wrapped_;
+
+  BoardBits board_;
+  BoardBits left_column_;
+  BoardBits right_column_;
+  BoardBits board_without_left_column_;
+  BoardBits board_without_right_column_;
+};
+
+}  // namespace rules
+}  // namespace battlesnake
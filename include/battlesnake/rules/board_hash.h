@@ -0,0 +1,56 @@
+#pragma once
+
+#include <battlesnake/rules/data_types.h>
+#include <battlesnake/rules/sized_board_state.h>
+
+#include <cstdint>
+
+namespace battlesnake {
+namespace rules {
+
+// Zobrist-style 64-bit hash of a board: snake bodies, heads, lengths and
+// health, food and hazards. Eliminated snakes don't contribute. Snakes are
+// identified by their index, so the hash is only comparable between states of
+// the same game. Value 0 is reserved to mark a hash that was not computed.
+//
+// Each body piece contributes a key of its (snake, cell) pair. Keys are
+// combined with XOR, so pieces stacked on the same cell cancel out in pairs,
+// that's compensated by the length key.
+//
+// Health has a key per value up to kBoardHashMaxHealth. Greater values hash
+// the same as kBoardHashMaxHealth and negative values the same as 0, so states
+// that only differ in such health values collide. Every length up to
+// kMaxSnakeBodyLen has its own key.
+static constexpr int kBoardHashMaxHealth = 255;
+
+// Computes hash of the state from scratch.
+uint64_t ComputeBoardHash(const BoardState& state);
+
+// Sets next.hash from prev.hash and the difference between the states, without
+// walking whole snake bodies. Computes prev hash from scratch if it's 0.
+//
+// Expects `next` to be created from `prev` by a ruleset: snakes are in the
+// same order, every snake that was not eliminated in `prev` has made exactly
+// one move, and snakes only grow at the tail. It can be called several times
+// for the same pair of states, e.g. by a derived ruleset after making more
+// changes.
+void UpdateBoardHash(const BoardState& prev, BoardState& next);
+
+// Same, but the previous state is described by the record saved before the
+// turn was applied to `next` in place. Computes the hash from scratch if the
+// recorded hash is 0.
+void UpdateBoardHash(const UndoRecord& undo, BoardState& next);
+
+// Same for states specialized for board size. Hashes are equal to hashes of
+// the same states converted to BoardState.
+template <Coordinate W, Coordinate H, int N>
+uint64_t ComputeBoardHash(const BoardStateT<W, H, N>& state);
+template <Coordinate W, Coordinate H, int N>
+void UpdateBoardHash(const BoardStateT<W, H, N>& prev,
+                     BoardStateT<W, H, N>& next);
+template <Coordinate W, Coordinate H, int N>
+void UpdateBoardHash(const typename BoardStateT<W, H, N>::UndoRecord& undo,
+                     BoardStateT<W, H, N>& next);
+
+}  // namespace rules
+}  // namespace battlesnake
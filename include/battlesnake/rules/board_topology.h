@@ -0,0 +1,115 @@
+#pragma once
+
+#include <battlesnake/rules/data_types.h>
+
+namespace battlesnake {
+namespace rules {
+
+// Neighbours of every cell of a board of the given size, wrapped or not.
+// Moving a point on a wrapped board needs a modulo per step, with topology it's
+// a table lookup instead. Cells are indexed the same way as in BoardBits:
+// y * width + x.
+//
+// Topologies of standard board sizes are precomputed at compile time, see
+// Find().
+class BoardTopology {
+ public:
+  static constexpr int kMaxCellsCount = kBoardSizeMax * kBoardSizeMax;
+  static constexpr short kNoCell = -1;
+
+  constexpr BoardTopology(Coordinate width, Coordinate height, bool wrapped)
+      : width_(width), height_(height), wrapped_(wrapped) {
+    for (Coordinate y = 0; y < height; ++y) {
+      for (Coordinate x = 0; x < width; ++x) {
+        const int cell = y * width + x;
+        for (Move move : {Move::Up, Move::Down, Move::Left, Move::Right}) {
+          Point p{x, y};
+          switch (move) {
+            case Move::Up:
+              p.y++;
+              break;
+            case Move::Down:
+              p.y--;
+              break;
+            case Move::Left:
+              p.x--;
+              break;
+            default:
+              p.x++;
+              break;
+          }
+          if (wrapped) {
+            p.x = static_cast<Coordinate>((p.x + width) % width);
+            p.y = static_cast<Coordinate>((p.y + height) % height);
+          }
+
+          const int m = static_cast<int>(move);
+          moved_[cell][m] = p;
+          neighbors_[cell][m] =
+              InBounds(p) ? static_cast<short>(CellIndex(p)) : kNoCell;
+        }
+      }
+    }
+  }
+
+  Coordinate Width() const { return width_; }
+  Coordinate Height() const { return height_; }
+  bool Wrapped() const { return wrapped_; }
+  int CellsCount() const { return width_ * height_; }
+
+  constexpr bool InBounds(const Point& p) const {
+    return p.x >= 0 && p.x < width_ && p.y >= 0 && p.y < height_;
+  }
+  constexpr int CellIndex(const Point& p) const { return p.y * width_ + p.x; }
+  Point CellPoint(int cell) const {
+    return Point{static_cast<Coordinate>(cell % width_),
+                 static_cast<Coordinate>(cell / width_)};
+  }
+
+  // Cell next to `cell` in the direction of `move`, or kNoCell if it's off the
+  // board. The move must not be Move::Unknown.
+  int Neighbor(int cell, Move move) const {
+    return neighbors_[cell][static_cast<int>(move)];
+  }
+
+  // Same as Point::Moved(), wrapping if the board is wrapped. Points off the
+  // board, like heads of snakes that went out of bounds, are moved without
+  // the table.
+  Point Moved(const Point& p, Move move) const {
+    if (!InBounds(p) || move == Move::Unknown) {
+      return movedOffBoard(p, move);
+    }
+    return moved_[CellIndex(p)][static_cast<int>(move)];
+  }
+
+  // Same as DetectMove() for this board.
+  Move DetectMove(const Point& from, const Point& to) const;
+
+  // Returns a precomputed topology for standard board sizes: 7x7, 11x11 and
+  // 19x19. Returns nullptr for other sizes.
+  static const BoardTopology* Find(Coordinate width, Coordinate height,
+                                   bool wrapped);
+  // Topology for a snake body, or nullptr if it's not wrapped or not of a
+  // standard size. Bodies don't know the size of unwrapped boards, but moving
+  // on them doesn't need a modulo anyway.
+  template <int kMaxLength>
+  static const BoardTopology* Find(const SnakeBodyT<kMaxLength>& body) {
+    const Point* wrapped_board_size = body.WrappedBoardSizePtr();
+    if (wrapped_board_size == nullptr) {
+      return nullptr;
+    }
+    return Find(wrapped_board_size->x, wrapped_board_size->y, true);
+  }
+
+ private:
+  Point movedOffBoard(const Point& p, Move move) const;
+
+  Coordinate width_;
+  Coordinate height_;
+  bool wrapped_;
+  Point moved_[kMaxCellsCount][4] = {};
+  short neighbors_[kMaxCellsCount][4] = {};
+};
+
+}  // namespace rules
+}  // namespace battlesnake
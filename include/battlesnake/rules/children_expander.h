@@ -0,0 +1,85 @@
+#pragma once
+
+#include <battlesnake/rules/ruleset.h>
+#include <battlesnake/rules/sized_standard_ruleset.h>
+#include <battlesnake/rules/standard_ruleset.h>
+
+#include <trivial_loop_array.hpp>
+
+namespace battlesnake {
+namespace rules {
+
+// Generates children of a state for all joint moves of snakes, one at a time.
+//
+// Each snake is moved, fed and damaged once per its candidate move when the
+// expander is created, since it doesn't depend on other snakes. Every child
+// only combines the moved snakes and runs the rest of the rules: food spawn,
+// collisions and ruleset specific rules. Children are produced lazily, so a
+// search that cuts off early doesn't pay for the rest of them.
+//
+// Children are the same as CreateNextBoardState() would produce, given the
+// same random numbers. With the staged turn pipeline, each child is created by
+// CreateNextBoardStateJoint() instead. The ruleset must outlive the expander.
+//
+// RulesetT is StandardRuleset or its derived class for BoardState, or
+// StandardRulesetT for states specialized for board size, see
+// sized_standard_ruleset.h.
+template <class RulesetT>
+class ChildrenExpanderT {
+ public:
+  using State = typename RulesetT::State;
+
+  // `masks` are candidate moves of snakes, indexed the same way as snakes in
+  // the state. Missing masks are treated as kAllMovesMask. Eliminated snakes
+  // don't move, their masks are ignored. A snake with an empty mask has no
+  // moves, so there are no children.
+  ChildrenExpanderT(RulesetT& ruleset, const State& state,
+                    const MoveMasksVector& masks, int turn);
+
+  // Total number of children.
+  int ChildrenCount() const;
+
+  // Writes the next child and its joint move. Returns false if all children
+  // have been generated.
+  bool Next(JointMove& joint_move, State& child);
+
+ private:
+  using MovesVector = ::theapx::trivial_loop_array<Move, 4>;
+
+  // Snake after a single candidate move.
+  struct MovedSnake {
+    SnakeOf<State> snake;
+    StandardRuleset::SnakeStep step;
+  };
+
+  void moveSnake(int snake_index, Move move, MovedSnake& result) const;
+
+  RulesetT& ruleset_;
+  State parent_;
+  int turn_;
+  MovesVector moves_[kSnakesCountMax];
+  MovedSnake moved_snakes_[kSnakesCountMax][4];
+  // Index of the current candidate move of each snake.
+  int positions_[kSnakesCountMax];
+  bool done_;
+};
+
+using ChildrenExpander = ChildrenExpanderT<StandardRuleset>;
+
+inline ChildrenExpander ExpandChildren(StandardRuleset& ruleset,
+                                       const BoardState& state,
+                                       const MoveMasksVector& masks,
+                                       int turn) {
+  return ChildrenExpander(ruleset, state, masks, turn);
+}
+
+template <Coordinate W, Coordinate H, int N>
+ChildrenExpanderT<StandardRulesetT<W, H, N>> ExpandChildren(
+    StandardRulesetT<W, H, N>& ruleset, const BoardStateT<W, H, N>& state,
+    const MoveMasksVector& masks, int turn) {
+  return ChildrenExpanderT<StandardRulesetT<W, H, N>>(ruleset, state, masks,
+                                                       turn);
+}
+
+}  // namespace rules
+}  // namespace battlesnake
@@ -13,9 +13,10 @@ class ConstrictorRuleset : public StandardRuleset {
   virtual BoardState CreateInitialBoardState(
       Coordinate width, Coordinate height,
       std::vector<SnakeId> snake_ids) override;
-  virtual void CreateNextBoardState(const BoardState& prev_state,
-                                    const SnakeMovesVector& moves, int turn,
-                                    BoardState& next_state) override;
+
+ protected:
+  virtual void resolveTurn(BoardState& state, int turn,
+                           BoundsCheck bounds_check) override;
 
  private:
   int snake_max_health_ = 0;
@@ -2,9 +2,11 @@
 
 #include <battlesnake/rules/errors.h>
 
+#include <atomic>
+#include <bit>
 #include <cstdint>
 #include <cstring>
-#include <forward_list>
+#include <memory>
 #include <mutex>
 #include <ostream>
 #include <string>
@@ -28,13 +30,15 @@ static constexpr Coordinate kSnakesCountStandard = 4;
 static constexpr Coordinate kSnakesCountDuel = 2;
 static constexpr Coordinate kSnakesCountMax = 8;
 
-// Optimize data structures for standard board sizes and numbers of snakes.
-// Larger numbers increase memory footprint. Boards with larger size or number
-// of snakes cause memory allocations.
+// Board states are specialized for standard board sizes and numbers of snakes,
+// see sized_board_state.h. Larger numbers increase memory footprint of the
+// largest specialization. Larger boards and more snakes use BoardState.
 
-// Max board size that memory optimizations will work for.
+// Largest board size with specialized board states, along with
+// kBoardSizeSmall.
 static constexpr int kOptimizeForMaxBoardSize = kBoardSizeMedium;
-// Max number of snakes that memory optimizations will work for.
+// Largest number of snakes with specialized board states, along with
+// kSnakesCountDuel.
 static constexpr int kOptimizeForMaxSnakesCount = kSnakesCountStandard;
 
 // Wrapper for string pointer. Can be used as simpler but trivially
@@ -58,19 +62,93 @@ bool operator!=(const std::string& b, const StringWrapper& a);
 // expensive string operations when objects are copied. But it forces all
 // strings used to construct the objects to outlive all objects. Use StringPool
 // to keep all strings alive.
+//
+// The pool is thread safe. Strings are split between shards by hash, each
+// shard has its own lock, so concurrent adds of different strings rarely
+// wait for each other.
+//
+// Long-living pools can free strings that are not used anymore. Every add
+// marks the string as used in the current generation. After NewGeneration(),
+// strings that are still needed must be added again, and FreeUnusedSince()
+// frees all strings that weren't added since the given generation.
 class StringPool {
  public:
+  struct Stats {
+    uint64_t adds;
+    // Adds of strings that were already in the pool.
+    uint64_t hits;
+    // Strings freed by FreeUnusedSince().
+    uint64_t freed;
+  };
+
+  StringPool() = default;
+  StringPool(const StringPool&) = delete;
+  StringPool& operator=(const StringPool&) = delete;
+
   StringWrapper Add(const std::string& s);
+
+  uint64_t Generation() const;
+  // Starts a new generation and returns it.
+  uint64_t NewGeneration();
+  // Frees strings that weren't added in `generation` or later and returns the
+  // number of freed strings. All StringWrappers referring to them become
+  // dangling, the caller must make sure no one uses them.
+  size_t FreeUnusedSince(uint64_t generation);
+
   size_t Size() const;
+  // Approximate memory used by strings and the index, in bytes.
+  size_t MemoryUsage() const;
+
+  Stats GetStats() const;
 
  protected:
-  std::mutex mutex_;
-  std::forward_list<std::string> strings_;
-  std::unordered_map<std::string_view, std::string*> index_;
+  static constexpr int kShardsCount = 16;
+
+  struct Entry {
+    std::string value;
+    uint64_t generation;
+  };
+
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<std::string_view, std::unique_ptr<Entry>> index;
+    size_t memory_usage = 0;
+    Stats stats{};
+  };
+
+  std::atomic<uint64_t> generation_ = 0;
+  Shard shards_[kShardsCount];
+
+  static size_t entryMemoryUsage(const Entry& entry);
+  Shard& shardFor(std::string_view s);
 };
 
 using SnakeId = StringWrapper;
 
+// Dense small integer identifying a snake within a game: index of the snake in
+// BoardState::snakes. Comparing and indexing by handles is much cheaper than by
+// SnakeId, which compares and hashes strings. SnakeId is still the identity
+// used in API.
+using SnakeHandle = unsigned char;
+static constexpr SnakeHandle kInvalidSnakeHandle = 0xFF;
+
+// Snake handle that is kInvalidSnakeHandle when zero-initialized. Data types
+// must stay trivial, so they can't have default member initializers. Instead
+// the handle is stored plus one: zero wraps around to kInvalidSnakeHandle.
+class OptionalSnakeHandle {
+ public:
+  OptionalSnakeHandle() = default;
+  constexpr OptionalSnakeHandle(SnakeHandle handle)
+      : stored_(static_cast<unsigned char>(handle + 1)) {}
+
+  constexpr operator SnakeHandle() const {
+    return static_cast<SnakeHandle>(stored_ - 1);
+  }
+
+ private:
+  unsigned char stored_;
+};
+
 // Move direction. Values are chosen to simplify calculation of the opposite
 // direction.
 enum class Move {
@@ -98,6 +176,10 @@ struct EliminatedCause {
   };
 
   Cause cause;
+  // Handle of the snake in `by_id`. Only valid if it refers to the snake with
+  // the same id, states created manually may not set it. Causes created
+  // without it, e.g. `{.cause = ..., .by_id = ...}`, have kInvalidSnakeHandle.
+  OptionalSnakeHandle by_handle;
   SnakeId by_id;
 };
 
@@ -125,10 +207,16 @@ Move DetectMove(const Point& from, const Point& to,
 // their tail and may go out of bounds, so extra buffer of 2 elements. This
 // vector never allocates memory on heap, thus improving performance. Though it
 // uses more memory than regular std::vector in most cases.
-static constexpr int kMaxSnakeBodyLen = kBoardSizeMax * kBoardSizeMax + 2;
+constexpr int MaxSnakeBodyLength(int width, int height) {
+  return width * height + 2;
+}
+static constexpr int kMaxSnakeBodyLen =
+    MaxSnakeBodyLength(kBoardSizeMax, kBoardSizeMax);
 
 using PointsVector = ::theapx::trivial_loop_array<Point, kMaxSnakeBodyLen>;
 
+class BoardTopology;
+
 struct PointHash {
   size_t operator()(const Point& point) const {
     size_t x_hash = std::hash<int>()(point.x);
@@ -137,7 +225,24 @@ struct PointHash {
   }
 };
 
-struct SnakeBody {
+// Small part of a snake body that MoveTo() and IncreaseLength() change, enough
+// to revert them. See SnakeBodyT::SaveCheckpoint().
+struct SnakeBodyCheckpoint {
+  Point head;
+  Point tail;
+  short total_length;
+  short moves_length;
+  signed char moves_offset;
+  unsigned char front_block;
+  unsigned char back_block;
+  short blocks_count;
+};
+
+// Body of snakes up to kMaxLength pieces long. SnakeBody fits any board, bodies
+// of board states specialized for board size are shorter, see
+// sized_board_state.h.
+template <int kMaxLength>
+struct SnakeBodyT {
  private:
   struct fake_allocator {
     typedef Point value_type;
@@ -156,8 +261,9 @@ struct SnakeBody {
     using const_pointer = const Point*;
     using allocator_type = fake_allocator;
 
-    Piece(const SnakeBody* body, short index, Point pos)
-        : body_(body), index_(index), pos_(pos) {}
+    Piece(const SnakeBodyT* body, short index, Point pos,
+          const BoardTopology* topology = nullptr)
+        : body_(body), index_(index), pos_(pos), topology_(topology) {}
 
     bool Valid() const { return index_ < body_->Length(); }
     const Point& Pos() const { return pos_; }
@@ -180,9 +286,11 @@ struct SnakeBody {
     bool operator!=(const Piece& other) const { return !operator==(other); }
 
    private:
-    const SnakeBody* body_;
+    const SnakeBodyT* body_;
     short index_;
     Point pos_;
+    // Moves pieces by table lookups on wrapped boards, if not null.
+    const BoardTopology* topology_;
   };
 
   using value_type = Point;
@@ -196,12 +304,24 @@ struct SnakeBody {
 
   const Point& HeadPos() const { return head; }
   const Point& TailPos() const { return tail; }
-  Piece Head() const { return Piece(this, 0, head); }
+  Piece Head() const { return Piece(this, 0, head, Topology()); }
   int Length() const { return total_length; }
 
+  // Moves head in the given direction. Tail follows, unless there are
+  // stacked pieces at the tail (after the snake has grown).
   void MoveTo(Move move);
+  // Returns the move MoveTo() makes. Move::Unknown continues in the direction
+  // of the last move, or goes up if there is none.
+  Move ResolveMove(Move move) const;
+  // Adds pieces stacked at the tail.
   void IncreaseLength(int delta = 1);
 
+  using Checkpoint = SnakeBodyCheckpoint;
+  Checkpoint SaveCheckpoint() const;
+  // Reverts the body to the checkpoint. At most one MoveTo() and any number
+  // of IncreaseLength() calls may have been made since it was saved.
+  void RestoreCheckpoint(const Checkpoint& checkpoint);
+
   bool NextRepeated(short index) const { return index >= moves_length; }
   Move NextMove(short index) const;
 
@@ -217,6 +337,9 @@ struct SnakeBody {
     }
     return &wrapped_board_size;
   }
+  // Precomputed topology of the wrapped board, or nullptr if the body isn't
+  // wrapped or the board size isn't standard. See board_topology.h.
+  const BoardTopology* Topology() const;
 
   // Example: {1,1}, {1,2}, {2,2}, {2,3}, {2,3}, {2,3}
   // Assuming sizeof(BlockType) == 1
@@ -230,8 +353,7 @@ struct SnakeBody {
   using BlockType = unsigned char;
   static constexpr int kMovesPerBlock = sizeof(BlockType) * 4;
   static constexpr short kBodyDataLength =
-      kMaxSnakeBodyLen / kMovesPerBlock +
-      (kMaxSnakeBodyLen % kMovesPerBlock == 0 ? 0 : 1);
+      kMaxLength / kMovesPerBlock + (kMaxLength % kMovesPerBlock == 0 ? 0 : 1);
   using BodyMovesVector =
       ::theapx::trivial_loop_array<BlockType, kBodyDataLength>;
 
@@ -247,9 +369,9 @@ struct SnakeBody {
   // wrapped_board_size is provided, the board is assumed wrapped and having
   // the provided size.
   template <class T>
-  static SnakeBody Create(const T& data,
-                          const Point* wrapped_board_size = nullptr) {
-    SnakeBody result{
+  static SnakeBodyT Create(const T& data,
+                           const Point* wrapped_board_size = nullptr) {
+    SnakeBodyT result{
         .total_length = static_cast<short>(data.size()),
         .moves_length = 0,
         .moves = {},
@@ -263,6 +385,7 @@ struct SnakeBody {
     if (data.size() != 0) {
       result.head = *data.begin();
     }
+    const BoardTopology* topology = result.Topology();
 
     Point prev = result.head;
     bool first = true;
@@ -273,7 +396,7 @@ struct SnakeBody {
         first = false;
         continue;
       }
-      Move move = DetectMove(prev, p, result.WrappedBoardSizePtr());
+      Move move = result.detectMove(topology, prev, p);
       if (move == Move::Unknown) {
         // if (prev != p) {
         //   throw RulesetException("Invalid body data");
@@ -301,14 +424,54 @@ struct SnakeBody {
     return result;
   }
 
-  static SnakeBody Create(const std::initializer_list<Point>& data,
-                          const Point* wrapped_board_size = nullptr) {
+  static SnakeBodyT Create(const std::initializer_list<Point>& data,
+                           const Point* wrapped_board_size = nullptr) {
     return Create<std::initializer_list<Point>>(data, wrapped_board_size);
   }
+
+  // Copies a body of another max length. The body must fit, moves are
+  // repacked starting from the first block.
+  template <int kOtherMaxLength>
+  static SnakeBodyT FromBody(const SnakeBodyT<kOtherMaxLength>& body) {
+    SnakeBodyT result{
+        .head = body.head,
+        .tail = body.tail,
+        .total_length = body.total_length,
+        .moves_length = body.moves_length,
+        .moves = {},
+        .moves_offset = 0,
+        .wrapped_board_size = body.wrapped_board_size,
+    };
+    BlockType current_block = 0;
+    for (short i = 0; i < body.moves_length; ++i) {
+      const int block_offset = i % kMovesPerBlock;
+      current_block |= static_cast<BlockType>(body.NextMove(i))
+                       << (block_offset * 2);
+      if (block_offset == kMovesPerBlock - 1) {
+        result.moves.push_back(current_block);
+        current_block = 0;
+      }
+    }
+    if (body.moves_length % kMovesPerBlock != 0) {
+      result.moves.push_back(current_block);
+    }
+    return result;
+  }
+
+ private:
+  // Same as DetectMove(), using the topology if not null.
+  Move detectMove(const BoardTopology* topology, const Point& from,
+                  const Point& to) const;
 };
 
-bool operator==(const SnakeBody& a, const SnakeBody& b);
-inline bool operator!=(const SnakeBody& a, const SnakeBody& b) {
+using SnakeBody = SnakeBodyT<kMaxSnakeBodyLen>;
+
+template <int kMaxLength>
+bool operator==(const SnakeBodyT<kMaxLength>& a,
+                const SnakeBodyT<kMaxLength>& b);
+template <int kMaxLength>
+inline bool operator!=(const SnakeBodyT<kMaxLength>& a,
+                       const SnakeBodyT<kMaxLength>& b) {
   return !(a == b);
 }
 
@@ -317,11 +480,15 @@ struct Snake {
   SnakeId id;
   SnakeBody body;
   int health;
+  // Index of the snake in the board state, see BoardState::AssignHandles().
+  // kInvalidSnakeHandle for snakes that are not assigned handles yet.
+  OptionalSnakeHandle handle;
   EliminatedCause eliminated_cause;
 
   // Additional values not necessarily used by ruleset, but used in API.
   StringWrapper name;
-  StringWrapper latency;
+  // Milliseconds, API sends it as a string.
+  int latency;
   StringWrapper shout;
   StringWrapper squad;
 
@@ -360,6 +527,54 @@ inline bool operator!=(const BoardBits& a, const BoardBits& b) {
   return !(a == b);
 }
 
+// First kBlocks blocks of BoardBits, same layout: bit y * width + x. Enough
+// for small boards, see sized_board_state.h.
+template <int kBlocks>
+struct BoardBitsT {
+  using BlockType = BoardBits::BlockType;
+  static constexpr int kBlockSizeBits = BoardBits::kBlockSizeBits;
+  static constexpr int kBlocksCount = kBlocks;
+  static_assert(kBlocksCount <= BoardBits::kBlocksCount);
+
+  BlockType data[kBlocksCount];
+
+  bool Get(int index) const {
+    return (data[index / kBlockSizeBits] >> (index % kBlockSizeBits)) & 1;
+  }
+  void Set(int index, bool value) {
+    const BlockType mask = static_cast<BlockType>(1)
+                           << (index % kBlockSizeBits);
+    if (value) {
+      data[index / kBlockSizeBits] |= mask;
+    } else {
+      data[index / kBlockSizeBits] &= ~mask;
+    }
+  }
+
+  void clear() { std::memset(this, 0, sizeof(*this)); }
+
+  static BoardBitsT FromBoardBits(const BoardBits& bits) {
+    BoardBitsT result;
+    std::memcpy(result.data, bits.data, sizeof(result.data));
+    return result;
+  }
+
+  BoardBits ToBoardBits() const {
+    BoardBits result{};
+    std::memcpy(result.data, data, sizeof(data));
+    return result;
+  }
+};
+
+template <int kBlocks>
+bool operator==(const BoardBitsT<kBlocks>& a, const BoardBitsT<kBlocks>& b) {
+  return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+template <int kBlocks>
+bool operator!=(const BoardBitsT<kBlocks>& a, const BoardBitsT<kBlocks>& b) {
+  return !(a == b);
+}
+
 template <class BitsType>
 class BoardBitsViewBase {
  private:
@@ -376,8 +591,17 @@ class BoardBitsViewBase {
   bool Get(Point p) const { return bits_->Get(p.y * width_ + p.x); }
 
   int Count() const {
+    const int size = width_ * height_;
     int result = 0;
-    for (const auto& p : *this) result++;
+    for (int i = 0; i * BoardBits::kBlockSizeBits < size; ++i) {
+      BoardBits::BlockType block = bits_->data[i];
+      int bits_left = size - i * BoardBits::kBlockSizeBits;
+      if (bits_left < BoardBits::kBlockSizeBits) {
+        // Ignore bits outside of the board.
+        block &= (static_cast<BoardBits::BlockType>(1) << bits_left) - 1;
+      }
+      result += std::popcount(block);
+    }
     return result;
   }
 
@@ -422,16 +646,19 @@ class BoardBitsViewBase {
   int height_;
 };
 
-class BoardBitsView : public BoardBitsViewBase<BoardBits> {
+template <class BitsType>
+class BoardBitsViewT : public BoardBitsViewBase<BitsType> {
  public:
-  BoardBitsView(BoardBits* bits, int width, int height)
-      : BoardBitsViewBase<BoardBits>(bits, width, height) {}
+  BoardBitsViewT(BitsType* bits, int width, int height)
+      : BoardBitsViewBase<BitsType>(bits, width, height) {}
 
-  void Set(Point p, bool value) { bits_->Set(p.y * width_ + p.x, value); }
+  void Set(Point p, bool value) {
+    this->bits_->Set(p.y * this->width_ + p.x, value);
+  }
 
   template <class T>
   void Fill(const T& data) {
-    std::memset(bits_, 0, sizeof(*bits_));
+    std::memset(this->bits_, 0, sizeof(*this->bits_));
     for (Point p : data) {
       Set(p, true);
     }
@@ -442,11 +669,11 @@ class BoardBitsView : public BoardBitsViewBase<BoardBits> {
   }
 };
 
-class BoardBitsViewConst : public BoardBitsViewBase<const BoardBits> {
- public:
-  BoardBitsViewConst(const BoardBits* bits, int width, int height)
-      : BoardBitsViewBase<const BoardBits>(bits, width, height) {}
-};
+template <class BitsType>
+using BoardBitsViewConstT = BoardBitsViewBase<const BitsType>;
+
+using BoardBitsView = BoardBitsViewT<BoardBits>;
+using BoardBitsViewConst = BoardBitsViewConstT<BoardBits>;
 
 template <class T>
 inline BoardBits CreateBoardBits(const T& data, Coordinate width,
@@ -469,6 +696,18 @@ struct BoardState {
   BoardBits food;
   SnakesVector snakes;
   BoardBits hazard;
+  // Cells covered by bodies of non-eliminated snakes, excluding their heads.
+  // A head entering any of these cells collides with a body, which is a single
+  // bit lookup. Rulesets keep it up to date incrementally. If all bits are
+  // zero, rulesets rebuild it from snake bodies, so states created from
+  // scratch don't have to fill it. Ruleset::CreateNextBoardState() and Apply()
+  // always rebuild it. Call ResetDerivedData() after modifying snakes of an
+  // existing state manually before passing it to other entry points.
+  BoardBits bodies;
+  // Hash of the state, see board_hash.h. Rulesets keep it up to date
+  // incrementally. Zero means it's not calculated yet, rulesets calculate it
+  // from scratch in that case.
+  uint64_t hash;
 
   BoardBitsView Food() { return BoardBitsView(&this->food, width, height); }
   BoardBitsViewConst Food() const {
@@ -481,8 +720,98 @@ struct BoardState {
   }
 
   bool InHazard(const Point& p) const { return Hazard().Get(p); }
+
+  BoardBitsView Bodies() { return BoardBitsView(&this->bodies, width, height); }
+  BoardBitsViewConst Bodies() const {
+    return BoardBitsViewConst(&this->bodies, width, height);
+  }
+
+  bool InBounds(const Point& p) const {
+    return p.x >= 0 && p.x < width && p.y >= 0 && p.y < height;
+  }
+
+  // Recalculates `bodies` from scratch.
+  void RebuildBodies();
+  // Calls RebuildBodies() if `bodies` is empty.
+  void EnsureBodies();
+  // Rebuilds `bodies` and clears `hash`, so that rulesets calculate it from
+  // scratch. Call after modifying snakes, food or hazards of an existing state
+  // manually.
+  void ResetDerivedData();
+
+  // Sets handles of all snakes to their indices. Board states created by
+  // rulesets and parsed from JSON already have handles assigned.
+  void AssignHandles();
+  // Returns the snake by its handle, or nullptr if there is no such snake or
+  // its handle is not assigned.
+  Snake* FindSnake(SnakeHandle handle);
+  const Snake* FindSnake(SnakeHandle handle) const;
+};
+
+// Types of snakes and bits of a board state. Code templated on the state type
+// works with both BoardState and states specialized for board size, see
+// sized_board_state.h.
+template <class StateT>
+using SnakeOf = typename decltype(StateT::snakes)::value_type;
+template <class StateT>
+using BitsOf = decltype(StateT::food);
+
+// Part of a board state that a turn may change, enough to revert the turn. Much
+// smaller than the state, since only a few blocks of each snake body are saved.
+// UndoRecord is for BoardState, see BoardStateT for others.
+struct UndoSnakeRecord {
+  SnakeBodyCheckpoint body;
+  int health;
+  EliminatedCause eliminated_cause;
 };
 
+template <class BitsType, int kSnakesCount>
+struct UndoRecordT {
+  using SnakeRecord = UndoSnakeRecord;
+
+  SnakeRecord snakes[kSnakesCount];
+  BitsType food;
+  BitsType hazard;
+  BitsType bodies;
+  uint64_t hash;
+
+  template <class StateT>
+  static UndoRecordT Save(const StateT& state) {
+    UndoRecordT result;
+    for (int i = 0; i < state.snakes.size(); ++i) {
+      const auto& snake = state.snakes[i];
+      result.snakes[i] = SnakeRecord{
+          .body = snake.body.SaveCheckpoint(),
+          .health = snake.health,
+          .eliminated_cause = snake.eliminated_cause,
+      };
+    }
+    result.food = state.food;
+    result.hazard = state.hazard;
+    result.bodies = state.bodies;
+    result.hash = state.hash;
+    return result;
+  }
+
+  // Reverts the state. Each snake body may have made at most one move since
+  // the record was saved.
+  template <class StateT>
+  void Restore(StateT& state) const {
+    for (int i = 0; i < state.snakes.size(); ++i) {
+      auto& snake = state.snakes[i];
+      snake.body.RestoreCheckpoint(snakes[i].body);
+      snake.health = snakes[i].health;
+      snake.eliminated_cause = snakes[i].eliminated_cause;
+    }
+    state.food = food;
+    state.hazard = hazard;
+    state.bodies = bodies;
+    state.hash = hash;
+  }
+};
+
+using UndoRecord = UndoRecordT<BoardBits, kSnakesCountMax>;
+
 struct RulesetSettings {
   int food_spawn_chance;
   int minimum_food;
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <battlesnake/rules/board_topology.h>
+#include <battlesnake/rules/data_types.h>
+
+#include <algorithm>
+#include <bit>
+
+namespace battlesnake {
+namespace rules {
+
+// Positions of all pieces of a snake body, decoded for O(1) random access.
+//
+// SnakeBody is compact, 2 bits per piece, but reaching a piece means walking
+// from the head. Evaluators that need random access, e.g. where the tail will
+// be in a few turns, keep a decoded body next to the snake and update it with
+// the same MoveTo() and IncreaseLength() calls. It's much larger than
+// SnakeBody, so it's not a part of board states.
+//
+// Only distinct positions are kept in a ring buffer: pieces stacked at the
+// tail share the tail position.
+class DecodedSnakeBody {
+ public:
+  // The body must not be empty.
+  static DecodedSnakeBody FromSnakeBody(const SnakeBody& body);
+
+  int Length() const { return total_length_; }
+  const Point& HeadPos() const { return At(0); }
+  const Point& TailPos() const { return At(total_length_ - 1); }
+
+  // Position of the piece `index` pieces away from the head.
+  const Point& At(int index) const {
+    return points_[(head_ + std::min(index, distinct_ - 1)) & kMask];
+  }
+
+  // Number of turns until the cell of the piece `index` is free, if the snake
+  // doesn't eat. The tail cell is free after 1 turn, unless pieces are stacked
+  // there.
+  int TurnsToVacate(int index) const {
+    return total_length_ - std::min(index, distinct_ - 1);
+  }
+
+  // Position of the tail after `turns` turns, if the snake doesn't eat.
+  // `turns` must be less than Length().
+  const Point& TailPosAfter(int turns) const {
+    return At(total_length_ - 1 - turns);
+  }
+
+  // Same as SnakeBody::MoveTo(). The move must be resolved, see
+  // SnakeBody::ResolveMove().
+  void MoveTo(Move move);
+  // Same as SnakeBody::IncreaseLength().
+  void IncreaseLength(int delta = 1) { total_length_ += delta; }
+
+ private:
+  static constexpr int kCapacity = std::bit_ceil(
+      static_cast<unsigned int>(kMaxSnakeBodyLen));
+  static constexpr int kMask = kCapacity - 1;
+
+  Point points_[kCapacity];
+  // Index of the head in `points_`.
+  int head_;
+  // Number of distinct positions, starting from the head.
+  int distinct_;
+  int total_length_;
+  Point wrapped_board_size_;
+  const BoardTopology* topology_;
+};
+
+}  // namespace rules
+}  // namespace battlesnake
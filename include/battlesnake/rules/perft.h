@@ -0,0 +1,33 @@
+#pragma once
+
+#include <battlesnake/rules/standard_ruleset.h>
+
+#include <cstdint>
+#include <ostream>
+
+namespace battlesnake {
+namespace rules {
+
+// Numbers of states reachable from a state, like perft in chess engines.
+struct PerftCounts {
+  // Joint move sequences of 1 to `depth` turns. Each one leads to a node.
+  uint64_t nodes = 0;
+  // Nodes where the game is over. They are not expanded further.
+  uint64_t terminal_nodes = 0;
+  // Nodes at `depth` where the game isn't over.
+  uint64_t leaf_nodes = 0;
+
+  bool operator==(const PerftCounts& other) const = default;
+};
+
+// Expands all joint moves of all non-eliminated snakes, 4 moves each, to
+// `depth` turns starting with `turn`. Food spawn uses random numbers of the
+// ruleset, so counts only repeat with the same seed or with food spawn
+// disabled.
+PerftCounts Perft(StandardRuleset& ruleset, const BoardState& state,
+                  int depth, int turn = 1);
+
+std::ostream& operator<<(std::ostream& s, const PerftCounts& counts);
+
+}  // namespace rules
+}  // namespace battlesnake
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace battlesnake {
+namespace rules {
+
+// Small and fast pseudo-random numbers generator (xoshiro256**). The whole
+// state is 32 bytes, so it is cheap to create and copy. The same seed always
+// produces the same sequence of numbers on all platforms.
+//
+// Not thread safe. Use a separate instance per thread, e.g. one per ruleset.
+//
+// Satisfies UniformRandomBitGenerator requirements, so it can be plugged into
+// standard library distributions and algorithms as well.
+class RandomGenerator {
+ public:
+  using result_type = uint64_t;
+
+  explicit RandomGenerator(uint64_t seed = 0) { Seed(seed); }
+
+  // Creates generator with seed taken from std::random_device.
+  static RandomGenerator CreateRandomlySeeded();
+
+  void Seed(uint64_t seed);
+
+  uint64_t Next() {
+    const uint64_t result = rotl(state_[1] * 5, 7) * 9;
+    const uint64_t t = state_[1] << 17;
+
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+
+    state_[2] ^= t;
+    state_[3] = rotl(state_[3], 45);
+
+    return result;
+  }
+
+  // Returns uniformly distributed random number in range [0, max_value).
+  // max_value must be positive.
+  int Uniform(int max_value);
+
+  // Randomly reorders elements in range [first, last).
+  template <class It>
+  void Shuffle(It first, It last) {
+    int n = static_cast<int>(last - first);
+    for (int i = n - 1; i > 0; --i) {
+      int j = Uniform(i + 1);
+      if (i != j) {
+        std::swap(first[i], first[j]);
+      }
+    }
+  }
+
+  static constexpr result_type min() {
+    return std::numeric_limits<result_type>::min();
+  }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+  result_type operator()() { return Next(); }
+
+ private:
+  uint64_t state_[4];
+
+  static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+}  // namespace rules
+}  // namespace battlesnake
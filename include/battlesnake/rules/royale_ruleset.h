@@ -20,11 +20,10 @@ class RoyaleRuleset : public StandardRuleset {
                 const RoyaleConfig& royale_config = RoyaleConfig::Default())
       : StandardRuleset(config), royale_config_(royale_config) {}
 
-  virtual void CreateNextBoardState(const BoardState& prev_state,
-                                    const SnakeMovesVector& moves, int turn,
-                                    BoardState& next_state) override;
-
  protected:
+  virtual void resolveTurn(BoardState& state, int turn,
+                           BoundsCheck bounds_check) override;
+
   void damageInHazard(BoardState& state) const;
 
  private:
@@ -38,7 +37,7 @@ class RoyaleRuleset : public StandardRuleset {
   };
 
   Bounds findBounds(const BoardState& state) const;
-  bool maybeShrinkBounds(int turn, Bounds& bounds) const;
+  bool maybeShrinkBounds(int turn, Bounds& bounds);
   void fillHazards(const Bounds& bounds, BoardState& state) const;
 };
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <trivial_loop_array.hpp>
 #include <unordered_map>
 #include <vector>
@@ -17,6 +18,72 @@ struct SnakeMove {
 using SnakeMovesVector =
     ::theapx::trivial_loop_array<SnakeMove, kSnakesCountMax>;
 
+// Moves of all snakes packed 2 bits per snake, addressed by snake index in
+// BoardState::snakes instead of snake id.
+using JointMove = uint16_t;
+static_assert(sizeof(JointMove) * 8 >= kSnakesCountMax * 2,
+              "JointMove must fit moves of all snakes");
+
+inline Move GetSnakeMove(JointMove joint_move, int snake_index) {
+  return static_cast<Move>((joint_move >> (snake_index * 2)) & 3);
+}
+
+inline void SetSnakeMove(JointMove& joint_move, int snake_index, Move move) {
+  const int shift = snake_index * 2;
+  joint_move = static_cast<JointMove>(
+      (joint_move & ~(3 << shift)) | ((static_cast<int>(move) & 3) << shift));
+}
+
+// Set of moves, one bit per move: bit `static_cast<int>(move)`.
+using MoveMask = uint8_t;
+static constexpr MoveMask kAllMovesMask = 0xF;
+
+inline MoveMask MoveBit(Move move) {
+  return static_cast<MoveMask>(1 << static_cast<int>(move));
+}
+
+using MoveMasksVector = ::theapx::trivial_loop_array<MoveMask, kSnakesCountMax>;
+
+// Snakes that don't have a move in `moves` get Move::Up.
+inline JointMove PackJointMove(const BoardState& state,
+                               const SnakeMovesVector& moves) {
+  JointMove result = 0;
+  for (int i = 0; i < state.snakes.size(); ++i) {
+    for (const SnakeMove& snake_move : moves) {
+      if (snake_move.snake_id == state.snakes[i].id) {
+        SetSnakeMove(result, i, snake_move.move);
+        break;
+      }
+    }
+  }
+  return result;
+}
+
+inline SnakeMovesVector UnpackJointMove(const BoardState& state,
+                                       JointMove joint_move) {
+  SnakeMovesVector result{};
+  for (int i = 0; i < state.snakes.size(); ++i) {
+    result.push_back(SnakeMove{
+        .snake_id = state.snakes[i].id,
+        .move = GetSnakeMove(joint_move, i),
+    });
+  }
+  return result;
+}
+
+// CreateNextBoardState() and Apply() accept any state, including states
+// created or modified by hand: they rebuild BoardState::bodies, calculate
+// BoardState::hash from scratch and check whole bodies for being out of
+// bounds.
+//
+// The joint move entry points trust data of the state derived from earlier
+// turns: BoardState::bodies is only rebuilt if all its bits are zero,
+// BoardState::hash is only recalculated if it's zero, and only heads are
+// checked for being out of bounds, since the rest of each body was checked on
+// earlier turns. States created by rulesets, ChildrenExpander or JSON parsing
+// and not modified since, and states created from scratch with zero `bodies`
+// and `hash`, satisfy this. Call BoardState::ResetDerivedData() after
+// modifying an existing state manually.
 class Ruleset {
  public:
   virtual ~Ruleset() = default;
@@ -27,6 +94,21 @@ class Ruleset {
   virtual void CreateNextBoardState(const BoardState& prev_state,
                                     const SnakeMovesVector& moves, int turn,
                                     BoardState& next_state) = 0;
+  // Same as CreateNextBoardState(), but changes the state in place. Returned
+  // record reverts the state with Undo(). Random numbers generator of the
+  // ruleset is not rewound by Undo(), so applying the same moves again may
+  // spawn different food.
+  virtual UndoRecord Apply(BoardState& state, const SnakeMovesVector& moves,
+                           int turn) = 0;
+  // Same as above, but moves are addressed by snake index instead of snake id.
+  // Moves of eliminated snakes are ignored. Named differently, so that empty
+  // braces or integers are never taken for moves.
+  virtual void CreateNextBoardStateJoint(const BoardState& prev_state,
+                                         JointMove joint_move, int turn,
+                                         BoardState& next_state) = 0;
+  virtual UndoRecord ApplyJoint(BoardState& state, JointMove joint_move,
+                                int turn) = 0;
+  virtual void Undo(BoardState& state, const UndoRecord& undo) = 0;
   virtual bool IsGameOver(const BoardState& state) = 0;
   virtual bool IsWrapped() = 0;
 };
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <battlesnake/rules/data_types.h>
+
+#include <cstdint>
+#include <trivial_loop_array.hpp>
+
+namespace battlesnake {
+namespace rules {
+
+static_assert(kBoardSizeSmall < kOptimizeForMaxBoardSize &&
+                  kOptimizeForMaxBoardSize <= kBoardSizeMax,
+              "Max optimized board size must be larger than small boards");
+static_assert(kSnakesCountDuel < kOptimizeForMaxSnakesCount &&
+                  kOptimizeForMaxSnakesCount <= kSnakesCountMax,
+              "Max optimized snakes count must be larger than duels");
+
+// Compact board states specialized for board size and number of snakes known
+// at compile time. BoardState is sized for the largest boards, while almost all
+// games are played on small boards with a few snakes.
+//
+// Bits only have blocks for cells of the board, bodies only have room for
+// moves on the board, and there are only as many snakes as the specialization
+// allows. Copies, undo records and turns are cheaper accordingly, see
+// BM_BoardStateCopy and BM_BoardStateStep benchmarks. StandardRulesetT applies
+// rules to them and ChildrenExpanderT expands them, see
+// sized_standard_ruleset.h.
+//
+// Conversion from BoardState keeps everything rulesets use, including bodies
+// and the hash, but drops API values: snake names, latencies and shouts.
+// Handles are reassigned to snake indices.
+//
+// Only small boards and boards of kOptimizeForMaxBoardSize, with 2 snakes or
+// kOptimizeForMaxSnakesCount snakes, are specialized: 7x7 and 11x11 boards
+// with 2 or 4 snakes by default. Use DispatchBoardSize() to pick a
+// specialization at runtime.
+template <Coordinate W, Coordinate H, int N>
+struct BoardStateT {
+  static_assert(W == H &&
+                    (W == kBoardSizeSmall || W == kOptimizeForMaxBoardSize),
+                "Only sizes picked by DispatchBoardSize() are specialized");
+  static_assert(N == kSnakesCountDuel || N == kOptimizeForMaxSnakesCount,
+                "Only sizes picked by DispatchBoardSize() are specialized");
+
+  // Named the same as BoardState fields, so that code templated on the state
+  // type reads them the same way.
+  static constexpr Coordinate width = W;
+  static constexpr Coordinate height = H;
+  static constexpr int kSnakesCount = N;
+  static constexpr int kCellsCount = W * H;
+  static constexpr int kMaxSnakeLength = MaxSnakeBodyLength(W, H);
+
+  using Bits = BoardBitsT<(kCellsCount + BoardBits::kBlockSizeBits - 1) /
+                          BoardBits::kBlockSizeBits>;
+  using Body = SnakeBodyT<kMaxSnakeLength>;
+
+  // Only values used by rulesets. API values, like snake names, are not kept.
+  struct SnakeT {
+    SnakeId id;
+    Body body;
+    int health;
+    EliminatedCause eliminated_cause;
+    StringWrapper squad;
+
+    bool IsEliminated() const {
+      return eliminated_cause.cause != EliminatedCause::NotEliminated;
+    }
+
+    bool IsOutOfHealth() const { return health <= 0; }
+
+    Point& Head() { return body.head; }
+    const Point& Head() const { return body.head; }
+    size_t Length() const { return body.Length(); }
+  };
+
+  using SnakesVector = ::theapx::trivial_loop_array<SnakeT, kSnakesCount>;
+  using UndoRecord = UndoRecordT<Bits, kSnakesCount>;
+
+  Bits food;
+  SnakesVector snakes;
+  Bits hazard;
+  // Same as BoardState::bodies.
+  Bits bodies;
+  // Same as BoardState::hash, equal to the hash of the converted state.
+  uint64_t hash;
+
+  BoardBitsViewT<Bits> Food() {
+    return BoardBitsViewT<Bits>(&food, width, height);
+  }
+  BoardBitsViewConstT<Bits> Food() const {
+    return BoardBitsViewConstT<Bits>(&food, width, height);
+  }
+
+  BoardBitsViewT<Bits> Hazard() {
+    return BoardBitsViewT<Bits>(&hazard, width, height);
+  }
+  BoardBitsViewConstT<Bits> Hazard() const {
+    return BoardBitsViewConstT<Bits>(&hazard, width, height);
+  }
+
+  bool InHazard(const Point& p) const { return Hazard().Get(p); }
+
+  BoardBitsViewT<Bits> Bodies() {
+    return BoardBitsViewT<Bits>(&bodies, width, height);
+  }
+  BoardBitsViewConstT<Bits> Bodies() const {
+    return BoardBitsViewConstT<Bits>(&bodies, width, height);
+  }
+
+  bool InBounds(const Point& p) const {
+    return p.x >= 0 && p.x < width && p.y >= 0 && p.y < height;
+  }
+
+  // Same as BoardState::RebuildBodies().
+  void RebuildBodies() {
+    bodies.clear();
+    BoardBitsViewT<Bits> view = Bodies();
+    for (const SnakeT& snake : snakes) {
+      if (snake.IsEliminated() || snake.body.empty()) {
+        continue;
+      }
+      // Start with the neck.
+      for (typename Body::Piece piece = snake.body.Head().Next();
+           piece.Valid(); piece = piece.Next()) {
+        if (InBounds(piece.Pos())) {
+          view.Set(piece.Pos(), true);
+        }
+      }
+    }
+  }
+  // Same as BoardState::EnsureBodies().
+  void EnsureBodies() {
+    for (typename Bits::BlockType block : bodies.data) {
+      if (block != 0) {
+        return;
+      }
+    }
+    RebuildBodies();
+  }
+  // Same as BoardState::ResetDerivedData().
+  void ResetDerivedData() {
+    RebuildBodies();
+    hash = 0;
+  }
+
+  // Returns true if the state can be converted to this specialization.
+  static bool Fits(const BoardState& state) {
+    if (state.width != width || state.height != height ||
+        state.snakes.size() > kSnakesCount) {
+      return false;
+    }
+    for (const Snake& snake : state.snakes) {
+      if (snake.body.moves_length > kMaxSnakeLength) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // The state must fit, see Fits().
+  static BoardStateT FromBoardState(const BoardState& state) {
+    BoardStateT result{
+        .food = Bits::FromBoardBits(state.food),
+        .snakes = {},
+        .hazard = Bits::FromBoardBits(state.hazard),
+        .bodies = Bits::FromBoardBits(state.bodies),
+        .hash = state.hash,
+    };
+    for (const Snake& snake : state.snakes) {
+      result.snakes.push_back(SnakeT{
+          .id = snake.id,
+          .body = Body::FromBody(snake.body),
+          .health = snake.health,
+          .eliminated_cause = snake.eliminated_cause,
+          .squad = snake.squad,
+      });
+    }
+    return result;
+  }
+
+  BoardState ToBoardState() const {
+    BoardState result{
+        .width = width,
+        .height = height,
+        .food = food.ToBoardBits(),
+        .snakes = {},
+        .hazard = hazard.ToBoardBits(),
+        .bodies = bodies.ToBoardBits(),
+        .hash = hash,
+    };
+    for (int i = 0; i < snakes.size(); ++i) {
+      const SnakeT& snake = snakes[i];
+      result.snakes.push_back(Snake{
+          .id = snake.id,
+          .body = SnakeBody::FromBody(snake.body),
+          .health = snake.health,
+          .handle = static_cast<SnakeHandle>(i),
+          .eliminated_cause = snake.eliminated_cause,
+          .squad = snake.squad,
+      });
+    }
+    return result;
+  }
+};
+
+// Calls MACRO(W, H, N) for every specialization picked by DispatchBoardSize().
+// Used to instantiate templates defined in source files.
+#define BATTLESNAKE_FOR_EACH_SIZED_BOARD(MACRO)                          \
+  MACRO(kBoardSizeSmall, kBoardSizeSmall, kSnakesCountDuel)               \
+  MACRO(kBoardSizeSmall, kBoardSizeSmall, kOptimizeForMaxSnakesCount)     \
+  MACRO(kOptimizeForMaxBoardSize, kOptimizeForMaxBoardSize,               \
+        kSnakesCountDuel)                                                 \
+  MACRO(kOptimizeForMaxBoardSize, kOptimizeForMaxBoardSize,               \
+        kOptimizeForMaxSnakesCount)
+
+// Passed to DispatchBoardSize() callbacks when there is no specialization.
+static constexpr Coordinate kGenericBoardSize = 0;
+
+// Calls `f.template operator()<W, H, N>()` with the smallest specialization
+// that fits the board size and snakes count, or with all kGenericBoardSize if
+// there is none. Callbacks use BoardStateT<W, H, N>, or BoardState for the
+// generic case. Returns what the callback returns.
+//
+// Only standard rules are implemented for specialized states, by
+// StandardRulesetT. Callbacks applying rules of other game types, such as
+// wrapped, royale, constrictor or squad, have to take the generic path with
+// their ruleset regardless of the board size.
+template <class F>
+decltype(auto) DispatchBoardSize(Coordinate width, Coordinate height,
+                                 int snakes_count, F&& f) {
+  if (width == kBoardSizeSmall && height == kBoardSizeSmall) {
+    if (snakes_count <= kSnakesCountDuel) {
+      return f.template operator()<kBoardSizeSmall, kBoardSizeSmall,
+                                   kSnakesCountDuel>();
+    }
+    if (snakes_count <= kOptimizeForMaxSnakesCount) {
+      return f.template operator()<kBoardSizeSmall, kBoardSizeSmall,
+                                   kOptimizeForMaxSnakesCount>();
+    }
+  }
+  if (width == kOptimizeForMaxBoardSize && height == kOptimizeForMaxBoardSize) {
+    if (snakes_count <= kSnakesCountDuel) {
+      return f.template operator()<kOptimizeForMaxBoardSize,
+                                   kOptimizeForMaxBoardSize,
+                                   kSnakesCountDuel>();
+    }
+    if (snakes_count <= kOptimizeForMaxSnakesCount) {
+      return f.template operator()<kOptimizeForMaxBoardSize,
+                                   kOptimizeForMaxBoardSize,
+                                   kOptimizeForMaxSnakesCount>();
+    }
+  }
+  return f.template operator()<kGenericBoardSize, kGenericBoardSize,
+                               kGenericBoardSize>();
+}
+
+// Dispatches by size of the parsed board. Also falls back to the generic case
+// if any snake body is too long for the specialization.
+template <class F>
+decltype(auto) DispatchBoardSize(const BoardState& state, F&& f) {
+  return DispatchBoardSize(
+      state.width, state.height, state.snakes.size(),
+      [&state, &f]<Coordinate W, Coordinate H, int N>() -> decltype(auto) {
+        if constexpr (W != kGenericBoardSize) {
+          if (!BoardStateT<W, H, N>::Fits(state)) {
+            return f.template operator()<kGenericBoardSize, kGenericBoardSize,
+                                         kGenericBoardSize>();
+          }
+        }
+        return f.template operator()<W, H, N>();
+      });
+}
+
+}  // namespace rules
+}  // namespace battlesnake
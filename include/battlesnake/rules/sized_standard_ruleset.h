@@ -0,0 +1,68 @@
+#pragma once
+
+#include "battlesnake/rules/board_hash.h"
+#include "battlesnake/rules/sized_board_state.h"
+#include "battlesnake/rules/standard_ruleset.h"
+
+namespace battlesnake {
+namespace rules {
+
+// Standard ruleset for states specialized for board size, see
+// sized_board_state.h. Turns are applied to sized states directly, with the
+// same results as StandardRuleset on the same states converted to BoardState,
+// including random numbers and hashes.
+//
+// Only standard rules are applied to sized states, rules of derived rulesets
+// are not, so this ruleset can't be derived from. Wrapped, royale, constrictor
+// and squad games use their rulesets with BoardState, see DispatchBoardSize().
+// BoardState overloads are inherited from StandardRuleset and work the same
+// way.
+template <Coordinate W, Coordinate H, int N>
+class StandardRulesetT final : public StandardRuleset {
+ public:
+  using State = BoardStateT<W, H, N>;
+  using UndoRecord = typename State::UndoRecord;
+
+  using StandardRuleset::StandardRuleset;
+
+  using StandardRuleset::ApplyJoint;
+  using StandardRuleset::CreateNextBoardStateJoint;
+  using StandardRuleset::IsGameOver;
+  using StandardRuleset::ResolveTurn;
+  using StandardRuleset::Undo;
+
+  void CreateNextBoardStateJoint(const State& prev_state, JointMove joint_move,
+                                 int turn, State& next_state) {
+    next_state = prev_state;
+    next_state.EnsureBodies();
+    moveAndFeedSnakes(next_state, joint_move);
+    resolveStandardTurn(next_state, turn, BoundsCheck::Heads);
+    UpdateBoardHash(prev_state, next_state);
+  }
+
+  UndoRecord ApplyJoint(State& state, JointMove joint_move, int turn) {
+    state.EnsureBodies();
+    UndoRecord undo = UndoRecord::Save(state);
+    try {
+      moveAndFeedSnakes(state, joint_move);
+      resolveStandardTurn(state, turn, BoundsCheck::Heads);
+    } catch (...) {
+      undo.Restore(state);
+      throw;
+    }
+    UpdateBoardHash(undo, state);
+    return undo;
+  }
+
+  void Undo(State& state, const UndoRecord& undo) { undo.Restore(state); }
+
+  bool IsGameOver(const State& state) { return isStandardGameOver(state); }
+
+  // Applies the rest of the rules of a turn, see StandardRuleset::ResolveTurn().
+  void ResolveTurn(State& state, int turn) {
+    resolveStandardTurn(state, turn, BoundsCheck::Heads);
+  }
+};
+
+}  // namespace rules
+}  // namespace battlesnake
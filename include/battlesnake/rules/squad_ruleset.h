@@ -18,17 +18,22 @@ class SquadRuleset : public StandardRuleset {
 
   SquadRuleset(const Config& config = Config::Default(),
                const SquadConfig& squad_config = SquadConfig::Default())
-      : StandardRuleset(config), squad_config_(squad_config) {}
+      : StandardRuleset(config), squad_config_(squad_config) {
+    bodies_may_overlap_ = squad_config_.allow_body_collisions;
+  }
 
-  virtual void CreateNextBoardState(const BoardState& prev_state,
-                                    const SnakeMovesVector& moves, int turn,
-                                    BoardState& next_state) override;
   virtual bool IsGameOver(const BoardState& state) override;
 
+ protected:
+  virtual void resolveTurn(BoardState& state, int turn,
+                           BoundsCheck bounds_check) override;
+
  private:
   SquadConfig squad_config_;
 
   void resurrectSquadBodyCollisions(BoardState& state) const;
+  const Snake* findEliminator(const BoardState& state,
+                              const EliminatedCause& cause) const;
   void shareSquadAttributes(BoardState& state) const;
 };
 
@@ -1,8 +1,8 @@
 #pragma once
 
-#include <functional>
 #include <trivial_loop_array.hpp>
 
+#include "battlesnake/rules/random.h"
 #include "battlesnake/rules/ruleset.h"
 
 namespace battlesnake {
@@ -10,17 +10,38 @@ namespace rules {
 
 class StandardRuleset : public Ruleset {
  public:
+  // State type the ruleset applies rules to. StandardRulesetT also applies them
+  // to states specialized for board size, see sized_standard_ruleset.h.
+  using State = BoardState;
+
+  // How snakes are moved, damaged and fed in a turn. Both pipelines produce
+  // identical results.
+  enum class TurnPipeline {
+    // Single pass over snakes.
+    Fused,
+    // Separate pass for each rule. Slower, kept as a reference.
+    Staged,
+  };
+
   // Default values.
   struct Config {
     int food_spawn_chance = 15;  // [0, 100]
     int minimum_food = 1;
     int snake_max_health = 100;
     int snake_start_size = 3;
+    // Seed for random numbers generator. Rulesets with the same seed produce
+    // the same games given the same moves. 0 means random seed.
+    uint64_t random_seed = 0;
+    TurnPipeline turn_pipeline = TurnPipeline::Fused;
 
     static Config Default() { return Config(); }
   };
 
-  StandardRuleset(const Config& config = Config::Default()) : config_(config) {}
+  StandardRuleset(const Config& config = Config::Default())
+      : config_(config),
+        random_(config.random_seed != 0
+                    ? RandomGenerator(config.random_seed)
+                    : RandomGenerator::CreateRandomlySeeded()) {}
 
   virtual BoardState CreateInitialBoardState(
       Coordinate width, Coordinate height,
@@ -28,61 +49,172 @@ class StandardRuleset : public Ruleset {
   virtual void CreateNextBoardState(const BoardState& prev_state,
                                     const SnakeMovesVector& moves, int turn,
                                     BoardState& next_state) override;
+  virtual UndoRecord Apply(BoardState& state, const SnakeMovesVector& moves,
+                           int turn) override;
+  virtual void CreateNextBoardStateJoint(const BoardState& prev_state,
+                                         JointMove joint_move, int turn,
+                                         BoardState& next_state) override;
+  virtual UndoRecord ApplyJoint(BoardState& state, JointMove joint_move,
+                                int turn) override;
+  virtual void Undo(BoardState& state, const UndoRecord& undo) override;
   virtual bool IsGameOver(const BoardState& state) override;
   virtual bool IsWrapped() override { return wrapped_mode_; }
 
+  // Restarts random numbers sequence used by this ruleset instance.
+  void SetRandomSeed(uint64_t seed) { random_.Seed(seed); }
+
+  const Config& GetConfig() const { return config_; }
+
+  // Steps of the fused turn pipeline, used by ChildrenExpander to move each
+  // snake once per candidate move and combine moved snakes into children. They
+  // are templated on the state type, implemented for BoardState and states
+  // specialized for board size.
+
+  // Board changes made by a single snake step.
+  struct SnakeStep {
+    // Cell left by the tail, if any.
+    bool has_vacated_tail;
+    Point vacated_tail;
+    // Old head, covered by the body now.
+    bool has_neck;
+    Point neck;
+    bool has_eaten;
+    // Single piece snake has eaten, new piece is stacked under the head.
+    bool has_stacked_head;
+  };
+
+  // Moves the snake, reduces its health and feeds it if it has moved onto food
+  // of `state`. `state` itself is not changed. Eliminated snakes don't move.
+  template <class StateT>
+  void StepSnake(const StateT& state, SnakeOf<StateT>& snake, Move move,
+                 SnakeStep& step) const;
+  // Updates bodies and food of `state` after all snakes have been stepped.
+  // `steps` are indexed the same way as snakes in the state.
+  template <class StateT>
+  void ApplySnakeSteps(StateT& state, const SnakeStep* steps) const;
+  // Applies the rest of the rules of a turn, see resolveTurn(). Only heads are
+  // checked for being out of bounds.
+  void ResolveTurn(BoardState& state, int turn) {
+    resolveTurn(state, turn, BoundsCheck::Heads);
+  }
+
  protected:
-  static int getRandomNumber(int max_value);
-  void growSnake(Snake& snake) const;
+  // Parts of snake bodies checked for being out of bounds.
+  enum class BoundsCheck {
+    // Only heads, the rest of each body was checked on earlier turns.
+    Heads,
+    // Whole bodies, for states that may be created or modified by hand.
+    WholeBodies,
+  };
+
+  // Applies all rules of a turn to the state in place: moves and feeds
+  // snakes, then resolves the rest with resolveTurn(). Hash is updated by the
+  // caller.
+  void applyTurn(BoardState& state, JointMove joint_move, int turn,
+                 BoundsCheck bounds_check);
+  // Moves, damages and feeds snakes with the configured turn pipeline.
+  template <class StateT>
+  void moveAndFeedSnakes(StateT& state, JointMove joint_move) const;
+  // Rules applied after all snakes have moved and eaten: food spawn,
+  // eliminations. Derived rulesets extend this instead of
+  // CreateNextBoardState() and Apply(). Must not move snakes.
+  virtual void resolveTurn(BoardState& state, int turn,
+                           BoundsCheck bounds_check);
+  // Standard part of resolveTurn(), also applied to states specialized for
+  // board size.
+  template <class StateT>
+  void resolveStandardTurn(StateT& state, int turn, BoundsCheck bounds_check);
+
+  // Standard part of IsGameOver(), also applied to states specialized for
+  // board size.
+  template <class StateT>
+  static bool isStandardGameOver(const StateT& state);
+
+  int getRandomNumber(int max_value);
+  template <class StateT>
+  void growSnake(StateT& state, SnakeOf<StateT>& snake) const;
 
  protected:
   Config config_;
   bool wrapped_mode_ = false;
+  // Bodies of non-eliminated snakes may overlap, so a cell left by a tail may
+  // still be covered by another snake.
+  bool bodies_may_overlap_ = false;
+  // Each ruleset instance owns its random numbers generator, so different
+  // instances can be safely used from different threads.
+  RandomGenerator random_;
 
  private:
   using SnakeIndicesVector = ::theapx::trivial_loop_array<int, kSnakesCountMax>;
+  // Collision eliminations indexed the same way as snakes in the board state.
+  // Snakes that are not eliminated by collision have NotEliminated cause.
+  using EliminationsVector =
+      ::theapx::trivial_loop_array<EliminatedCause, kSnakesCountMax>;
 
   static bool isKnownBoardSize(const BoardState& state);
 
-  void placeSnakesFixed(BoardState& state) const;
-  void placeSnakesRandomly(BoardState& state,
-                           PointsVector& unoccupied_points) const;
-
-  void placeFoodFixed(BoardState& state) const;
-  void placeFoodRandomly(BoardState& state,
-                         PointsVector& unoccupied_points) const;
-  void maybeSpawnFood(BoardState& state) const;
-  void spawnFood(BoardState& state, int count,
-                 PointsVector& unoccupied_points) const;
+  void placeSnakesFixed(BoardState& state);
+  void placeSnakesRandomly(BoardState& state, BoardBits& unoccupied_cells);
+
+  void placeFoodFixed(BoardState& state);
+  void placeFoodRandomly(BoardState& state, BoardBits& unoccupied_cells);
+  template <class StateT>
+  void maybeSpawnFood(StateT& state);
+  template <class StateT>
+  void spawnFood(StateT& state, int count, BitsOf<StateT>& unoccupied_cells);
+  // Picks a random cell of `cells`, removes it from `cells` and decrements
+  // `cells_count`, which must be the number of cells.
+  template <class StateT>
+  Point takeRandomCell(const StateT& state, BitsOf<StateT>& cells,
+                       int& cells_count);
   void setSnakesWrapped(BoardState& state) const;
 
-  static PointsVector getUnoccupiedPoints(
-      BoardState& state, bool include_possible_moves,
-      const std::function<bool(const Point&)>& filter = [](const Point&) {
-        return true;
-      });
-  static PointsVector getEvenUnoccupiedPoints(BoardState& state);
-
-  void moveSnakes(BoardState& state, const SnakeMovesVector& moves) const;
+  // Cells of the board without snakes and food.
+  template <class StateT>
+  static BitsOf<StateT> getUnoccupiedCells(const StateT& state,
+                                           bool include_possible_moves);
+  static BoardBits getEvenUnoccupiedCells(const BoardState& state);
+
+  // Matches moves to snakes by snake id.
+  JointMove findJointMove(const BoardState& state,
+                          const SnakeMovesVector& moves) const;
+  template <class StateT>
+  void moveSnakes(StateT& state, JointMove joint_move) const;
+  // Same as moveSnakes(), reduceSnakeHealth() and maybeFeedSnakes() in a
+  // single pass over snakes, using StepSnake() and ApplySnakeSteps().
+  template <class StateT>
+  void stepSnakes(StateT& state, JointMove joint_move) const;
   Move const* findSnakeMove(const SnakeMovesVector& moves,
                             const SnakeId& snake_id) const;
 
-  void reduceSnakeHealth(BoardState& state) const;
-
-  void maybeFeedSnakes(BoardState& state) const;
-  void feedSnake(Snake& snake) const;
-
-  void maybeEliminateSnakes(BoardState& state) const;
-  void eliminateOutOfHealthOrBoundsSnakes(BoardState& state) const;
-  bool snakeOutOfBounds(const BoardState& state, const Snake& snake) const;
-  std::unordered_map<SnakeId, EliminatedCause> findCollisionEliminations(
-      const BoardState& state,
-      const SnakeIndicesVector& snake_indices_by_length) const;
-  bool snakeHasBodyCollided(const Snake& snake, const Snake& other) const;
-  bool snakeHasLostHeadToHead(const Snake& snake, const Snake& other) const;
+  template <class StateT>
+  void reduceSnakeHealth(StateT& state) const;
+
+  template <class StateT>
+  void maybeFeedSnakes(StateT& state) const;
+  template <class StateT>
+  void feedSnake(StateT& state, SnakeOf<StateT>& snake) const;
+
+  template <class StateT>
+  void maybeEliminateSnakes(StateT& state, BoundsCheck bounds_check) const;
+  template <class StateT>
+  void eliminateOutOfHealthOrBoundsSnakes(StateT& state,
+                                          BoundsCheck bounds_check) const;
+  template <class StateT>
+  bool snakeOutOfBounds(const StateT& state, const SnakeOf<StateT>& snake,
+                        BoundsCheck bounds_check) const;
+  // Indices of snakes, longest first.
+  template <class StateT>
+  static SnakeIndicesVector sortSnakesByLength(const StateT& state);
+  template <class StateT>
+  EliminationsVector findCollisionEliminations(const StateT& state) const;
+  template <class SnakeT>
+  bool snakeHasBodyCollided(const SnakeT& snake, const SnakeT& other) const;
+  template <class SnakeT>
+  bool snakeHasLostHeadToHead(const SnakeT& snake, const SnakeT& other) const;
+  template <class StateT>
   void applyCollisionEliminations(
-      BoardState& state,
-      const std::unordered_map<SnakeId, EliminatedCause>& eliminations) const;
+      StateT& state, const EliminationsVector& eliminations) const;
 };
 
 }  // namespace rules
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <battlesnake/rules/ruleset.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace battlesnake {
+namespace rules {
+
+// Fixed size hash table of search results keyed by BoardState::hash. Can be
+// probed and updated by many threads at the same time without locks.
+//
+// Each bucket takes one cache line and holds several entries. Every entry is
+// two 64-bit words: packed data and key XOR data. Torn entries written by
+// several threads at once fail the key check and are treated as misses, so
+// probes never return data stored for a different key.
+class TranspositionTable {
+ public:
+  enum class Bound : uint8_t {
+    None = 0,
+    Exact = 1,
+    // Value is a lower bound (search failed high).
+    Lower = 2,
+    // Value is an upper bound (search failed low).
+    Upper = 3,
+  };
+
+  struct Entry {
+    // Stored as 16 bit signed integer, larger values are clamped.
+    int value;
+    // Stored as 8 bit unsigned integer, larger values are clamped.
+    int depth;
+    Bound bound;
+    JointMove best_move;
+  };
+
+  struct Stats {
+    uint64_t probes;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+    // Stores that have overwritten an entry of a different state.
+    uint64_t collisions;
+  };
+
+  static constexpr int kEntriesPerBucket = 4;
+  static constexpr size_t kBucketSizeBytes = 64;
+
+  // Uses the largest power of two number of buckets that fits into the budget,
+  // but at least one bucket.
+  explicit TranspositionTable(size_t memory_budget_bytes);
+
+  TranspositionTable(const TranspositionTable&) = delete;
+  TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+  // Returns true and fills `entry` if there is an entry for the hash.
+  bool Probe(uint64_t hash, Entry& entry);
+  void Store(uint64_t hash, const Entry& entry);
+
+  // Starts a new search. Entries from older searches are replaced first.
+  void NewSearch();
+  // Removes all entries and resets age. Not thread safe.
+  void Clear();
+
+  size_t BucketsCount() const { return buckets_count_; }
+  size_t Capacity() const { return buckets_count_ * kEntriesPerBucket; }
+  size_t MemoryUsage() const { return buckets_count_ * kBucketSizeBytes; }
+
+  Stats GetStats() const;
+  void ResetStats();
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> key_xor_data;
+    std::atomic<uint64_t> data;
+  };
+
+  struct alignas(kBucketSizeBytes) Bucket {
+    Slot slots[kEntriesPerBucket];
+  };
+  static_assert(sizeof(Bucket) == kBucketSizeBytes);
+
+  // Counters are spread over several cache lines by bucket index, so threads
+  // working on different buckets rarely write the same line.
+  struct alignas(64) Counters {
+    std::atomic<uint64_t> probes;
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> stores;
+    std::atomic<uint64_t> collisions;
+  };
+  static constexpr int kCountersShards = 16;
+
+  static uint64_t pack(const Entry& entry, int age);
+  static Entry unpack(uint64_t data);
+  static int age(uint64_t data);
+
+  Bucket& bucketFor(uint64_t hash) const {
+    return buckets_[hash & (buckets_count_ - 1)];
+  }
+  Counters& countersFor(uint64_t hash) {
+    return counters_[hash & (kCountersShards - 1)];
+  }
+
+  size_t buckets_count_;
+  std::unique_ptr<Bucket[]> buckets_;
+  std::atomic<int> age_;
+  Counters counters_[kCountersShards];
+};
+
+}  // namespace rules
+}  // namespace battlesnake
@@ -13,9 +13,9 @@ class WrappedRuleset : public RoyaleRuleset {
     wrapped_mode_ = true;
   }
 
-  virtual void CreateNextBoardState(const BoardState& prev_state,
-                                    const SnakeMovesVector& moves, int turn,
-                                    BoardState& next_state) override;
+ protected:
+  virtual void resolveTurn(BoardState& state, int turn,
+                           BoundsCheck bounds_check) override;
 
  private:
   static RoyaleConfig fixRoyaleConfig(const RoyaleConfig& royale_config);
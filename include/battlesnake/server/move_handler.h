@@ -0,0 +1,20 @@
+#pragma once
+
+#include <battlesnake/interface/battlesnake.h>
+
+#include <functional>
+#include <string>
+
+namespace battlesnake {
+namespace server {
+
+// Handles the body of a /move request without the HTTP layer: parses the game
+// state into a new string pool, asks `battlesnake` for a move and calls
+// `respond` with the JSON body of the response. Throws if the request can't be
+// parsed.
+void HandleMove(battlesnake::interface::Battlesnake& battlesnake,
+                const std::string& content,
+                std::function<void(const std::string& body)> respond);
+
+}  // namespace server
+}  // namespace battlesnake
@@ -1,5 +1,11 @@
 #include "battlesnake/json/converter.h"
 
+#include <charconv>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "battlesnake/rules/board_hash.h"
 #include "battlesnake/rules/errors.h"
 
 namespace battlesnake {
@@ -68,6 +74,35 @@ StringWrapper GetString(const nlohmann::json& json, const char* key,
   return pool.Add(*v);
 }
 
+// Latency is a string in API, but some engines send a number. It's only
+// informational, so missing, empty or malformed latency is 0 instead of an
+// error.
+int GetLatency(const nlohmann::json& json, const char* key) {
+  auto v = json.find(key);
+  if (v == json.end()) {
+    return 0;
+  }
+  if (v->is_number_integer()) {
+    const int64_t value = *v;
+    if (value < std::numeric_limits<int>::min() ||
+        value > std::numeric_limits<int>::max()) {
+      return 0;
+    }
+    return static_cast<int>(value);
+  }
+  if (!v->is_string()) {
+    return 0;
+  }
+
+  const std::string& s = v->get_ref<const std::string&>();
+  int result = 0;
+  auto [end, error] = std::from_chars(s.data(), s.data() + s.size(), result);
+  if (error != std::errc() || end != s.data() + s.size()) {
+    return 0;
+  }
+  return result;
+}
+
 std::string GetStringNoPool(const nlohmann::json& json, const char* key,
                             const char* default_value) {
   auto v = json.find(key);
@@ -134,7 +169,7 @@ nlohmann::json CreateJson(const Snake& snake) {
   result["length"] = snake.body.size();
 
   result["name"] = snake.name.ToString();
-  result["latency"] = snake.latency.ToString();
+  result["latency"] = std::to_string(snake.latency);
   result["shout"] = snake.shout.ToString();
   result["squad"] = snake.squad.ToString();
 
@@ -251,7 +286,7 @@ Snake ParseJsonSnake(const nlohmann::json& json,
           SnakeBody::Create(GetPointArray(json, "body"), wrapped_board_size),
       .health = GetInt(json, "health"),
       .name = GetString(json, "name", "", pool),
-      .latency = GetString(json, "latency", "0", pool),
+      .latency = GetLatency(json, "latency"),
       .shout = GetString(json, "shout", "", pool),
       .squad = GetString(json, "squad", "", pool),
   };
@@ -282,11 +317,14 @@ BoardState ParseJsonBoard(const nlohmann::json& json,
   Point wrapped_board_size{result.width, result.height};
   result.snakes = GetSnakeArray(json, "snakes", pool,
                                 wrapped ? &wrapped_board_size : nullptr);
+  result.AssignHandles();
 
   result.food =
       CreateBoardBits(GetPointArray(json, "food"), result.width, result.height);
   result.hazard = CreateBoardBits(GetPointArray(json, "hazards"), result.width,
                                   result.height);
+  result.RebuildBodies();
+  result.hash = ComputeBoardHash(result);
   return result;
 }
 
@@ -359,6 +397,15 @@ battlesnake::rules::GameState ParseJsonGameState(
     Point wrapped_board_size{game_state.board.width, game_state.board.height};
     game_state.you =
         ParseJsonSnake(*you_it, pool, wrapped ? &wrapped_board_size : nullptr);
+
+    // Same handle as the snake on the board, if it's there.
+    game_state.you.handle = kInvalidSnakeHandle;
+    for (const Snake& snake : game_state.board.snakes) {
+      if (snake.id == game_state.you.id) {
+        game_state.you.handle = snake.handle;
+        break;
+      }
+    }
   }
 
   return game_state;
@@ -0,0 +1,131 @@
+#include <battlesnake/rules/constrictor_ruleset.h>
+#include <battlesnake/rules/errors.h>
+#include <battlesnake/rules/perft.h>
+#include <battlesnake/rules/royale_ruleset.h>
+#include <battlesnake/rules/solo_ruleset.h>
+#include <battlesnake/rules/squad_ruleset.h>
+#include <battlesnake/rules/standard_ruleset.h>
+#include <battlesnake/rules/wrapped_ruleset.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace battlesnake::rules;
+
+namespace {
+
+std::unique_ptr<StandardRuleset> CreateRuleset(
+    const std::string& name, const StandardRuleset::Config& config) {
+  if (name == "standard") {
+    return std::make_unique<StandardRuleset>(config);
+  }
+
+  if (name == "solo") {
+    return std::make_unique<SoloRuleset>(config);
+  }
+
+  if (name == "royale") {
+    return std::make_unique<RoyaleRuleset>(config);
+  }
+
+  if (name == "constrictor") {
+    return std::make_unique<ConstrictorRuleset>(config);
+  }
+
+  if (name == "squad") {
+    return std::make_unique<SquadRuleset>(config);
+  }
+
+  if (name == "wrapped") {
+    return std::make_unique<WrappedRuleset>(config);
+  }
+
+  return nullptr;
+}
+
+int PrintUsage(const char* program) {
+  std::cerr << "Usage: " << program
+            << " <gametype> <depth> [board size] [snakes] [seed]" << std::endl
+            << "  board size: 1.." << static_cast<int>(kBoardSizeMax)
+            << ", snakes: 1.." << static_cast<int>(kSnakesCountMax)
+            << ", seed: non-zero" << std::endl;
+  return 1;
+}
+
+}  // namespace
+
+// Counts states reachable from a standard start and measures nodes per
+// second. Food spawn is disabled, the rest of random numbers are seeded.
+int main(int argc, const char* const argv[]) {
+  if (argc < 3 || argc > 6) {
+    return PrintUsage(argv[0]);
+  }
+
+  const std::string gametype = argv[1];
+  int depth = 0;
+  int board_size = kBoardSizeMedium;
+  int snakes_count = 2;
+  uint64_t seed = 1;
+  try {
+    depth = std::stoi(argv[2]);
+    if (argc > 3) {
+      board_size = std::stoi(argv[3]);
+    }
+    if (argc > 4) {
+      snakes_count = std::stoi(argv[4]);
+    }
+    if (argc > 5) {
+      seed = std::stoull(argv[5]);
+    }
+  } catch (const std::exception&) {
+    return PrintUsage(argv[0]);
+  }
+  if (depth < 1 || board_size < 1 || board_size > kBoardSizeMax ||
+      snakes_count < 1 || snakes_count > kSnakesCountMax || seed == 0) {
+    return PrintUsage(argv[0]);
+  }
+
+  std::unique_ptr<StandardRuleset> ruleset =
+      CreateRuleset(gametype, StandardRuleset::Config{
+                                  .food_spawn_chance = 0,
+                                  .minimum_food = 0,
+                                  .random_seed = seed,
+                              });
+  if (ruleset == nullptr) {
+    std::cerr << "Unknown game type: " << gametype << std::endl;
+    return 10;
+  }
+
+  StringPool pool;
+  std::vector<SnakeId> ids;
+  for (int i = 0; i < snakes_count; ++i) {
+    ids.push_back(pool.Add("snake" + std::to_string(i)));
+  }
+  const Coordinate size = static_cast<Coordinate>(board_size);
+  BoardState state{};
+  try {
+    state = ruleset->CreateInitialBoardState(size, size, ids);
+  } catch (const RulesetException& e) {
+    std::cerr << "Can't create initial board state: " << e.what() << std::endl;
+    return 11;
+  }
+
+  for (int d = 1; d <= depth; ++d) {
+    ruleset->SetRandomSeed(seed);
+    auto start_time = std::chrono::high_resolution_clock::now();
+    PerftCounts counts = Perft(*ruleset, state, d);
+    auto end_time = std::chrono::high_resolution_clock::now();
+
+    double seconds =
+        std::chrono::duration<double>(end_time - start_time).count();
+    std::cout << "depth " << d << ": " << counts << ", "
+              << static_cast<uint64_t>(counts.nodes / std::max(seconds, 1e-9))
+              << " nodes/s" << std::endl;
+  }
+
+  return 0;
+}
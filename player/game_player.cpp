@@ -18,9 +18,9 @@ using namespace ::battlesnake::interface;
 using namespace ::battlesnake::rules;
 
 struct MoveResult {
-  SnakeId snake_id;
+  SnakeHandle handle = kInvalidSnakeHandle;
   Battlesnake::MoveResponse response;
-  int latency;
+  int latency = 0;
 };
 
 // This is not completely async because it waits for snake->Move(,,) to return,
@@ -45,7 +45,7 @@ MoveResult MoveSnake(std::shared_ptr<StringPool> pool, const GameState& game,
   GameState game_for_snake = game;
   game_for_snake.you = snake;
 
-  move_result.snake_id = snake.id;
+  move_result.handle = snake.handle;
   std::promise<void> has_result;
 
   auto start = std::chrono::high_resolution_clock::now();
@@ -65,6 +65,20 @@ MoveResult MoveSnake(std::shared_ptr<StringPool> pool, const GameState& game,
   return move_result;
 }
 
+// Adds all strings of the game to the pool again, so that they are used in the
+// current generation of the pool.
+void KeepGameStrings(StringPool& pool, const GameState& game) {
+  for (StringWrapper s : {game.game.id, game.game.ruleset.name,
+                          game.game.ruleset.version}) {
+    pool.Add(s.ToString());
+  }
+  for (const Snake& snake : game.board.snakes) {
+    for (StringWrapper s : {snake.id, snake.name, snake.shout, snake.squad}) {
+      pool.Add(s.ToString());
+    }
+  }
+}
+
 }  // namespace
 
 void GamePlayer::SetGameId(const std::string& game_id) { game_id_ = game_id; }
@@ -96,15 +110,14 @@ void GamePlayer::SetPrintMode(PrintMode mode) { print_mode_ = mode; }
 
 void GamePlayer::SetRequestsMode(RequestsMode mode) { requests_mode_ = mode; }
 
-void GamePlayer::Play() {
-  std::unordered_map<SnakeId, StringWrapper> names;
+void GamePlayer::SetFreeOldStrings(bool free_old_strings) {
+  free_old_strings_ = free_old_strings;
+}
 
+void GamePlayer::Play() {
   std::vector<SnakeId> snake_ids;
   for (const PlayerInfo& player : players_) {
-    StringWrapper id_wrapped = string_pool_->Add(player.id);
-    snake_ids.push_back(id_wrapped);
-    snakes_map_[id_wrapped] = player.battlesnake;
-    names[id_wrapped] = string_pool_->Add(player.name);
+    snake_ids.push_back(string_pool_->Add(player.id));
   }
 
   GameState game{
@@ -124,7 +137,9 @@ void GamePlayer::Play() {
   char head_sym = 'A';
 
   for (Snake& snake : game.board.snakes) {
-    snake.name = names[snake.id];
+    if (HasPlayer(snake)) {
+      snake.name = string_pool_->Add(players_[snake.handle].name);
+    }
     snake_head_syms[snake.id] = head_sym;
     ++head_sym;
   }
@@ -136,8 +151,8 @@ void GamePlayer::Play() {
   for (game.turn = 1; !ruleset_->IsGameOver(game.board); ++game.turn) {
     PrintGame(game, snake_head_syms);
 
-    std::unordered_map<SnakeId, Battlesnake::MoveResponse> move_responses;
-    std::unordered_map<SnakeId, int> latencies;
+    MoveResponsesVector move_responses;
+    LatenciesVector latencies;
 
     auto start = std::chrono::high_resolution_clock::now();
     std::tie(move_responses, latencies) = GetMoves(game);
@@ -147,8 +162,10 @@ void GamePlayer::Play() {
     //         .count();
 
     SnakeMovesVector moves{};
-    for (const auto& [id, response] : move_responses) {
-      moves.push_back({id, response.move});
+    for (const Snake& snake : game.board.snakes) {
+      if (HasPlayer(snake) && move_responses[snake.handle].has_value()) {
+        moves.push_back({snake.id, move_responses[snake.handle]->move});
+      }
     }
 
     BoardState new_board{};
@@ -156,20 +173,29 @@ void GamePlayer::Play() {
     game.board = new_board;
 
     for (Snake& snake : game.board.snakes) {
-      auto latency_it = latencies.find(snake.id);
-      if (latency_it == latencies.end()) {
-        snake.latency = string_pool_->Add("0");
-      } else {
-        snake.latency = string_pool_->Add(std::to_string(latency_it->second));
+      if (!HasPlayer(snake)) {
+        snake.latency = 0;
+        snake.shout = string_pool_->Add("");
+        continue;
       }
 
-      auto move_response_it = move_responses.find(snake.id);
-      if (move_response_it == move_responses.end()) {
-        snake.shout = string_pool_->Add("");
+      snake.latency = latencies[snake.handle];
+
+      const auto& move_response = move_responses[snake.handle];
+      if (move_response.has_value()) {
+        snake.shout = string_pool_->Add(move_response->shout);
       } else {
-        snake.shout = string_pool_->Add(move_response_it->second.shout);
+        snake.shout = string_pool_->Add("");
       }
     }
+
+    if (free_old_strings_) {
+      // Strings of the state that snakes have just moved in are kept for one
+      // more turn for snakes still working after responding.
+      const uint64_t generation = string_pool_->NewGeneration();
+      KeepGameStrings(*string_pool_, game);
+      string_pool_->FreeUnusedSince(generation - 1);
+    }
   }
 
   PrintGame(game, snake_head_syms);
@@ -205,41 +231,46 @@ void GamePlayer::PrintGame(
   }
 }
 
+bool GamePlayer::HasPlayer(const Snake& snake) const {
+  return snake.handle != kInvalidSnakeHandle && snake.handle < players_.size();
+}
+
+Battlesnake* GamePlayer::SnakeInterface(const Snake& snake) const {
+  if (!HasPlayer(snake)) {
+    return nullptr;
+  }
+  return players_[snake.handle].battlesnake;
+}
+
 void GamePlayer::StartAll(const GameState& game) {
   for (const Snake& snake : game.board.snakes) {
-    GameState game_for_snake = game;
-    game_for_snake.you = snake;
-    SnakeId id = snake.id;
-
-    auto snake_it = snakes_map_.find(id);
-    if (snake_it == snakes_map_.end()) {
+    Battlesnake* snake_interface = SnakeInterface(snake);
+    if (snake_interface == nullptr) {
       continue;
     }
 
-    Battlesnake* snake_interface = snake_it->second;
+    GameState game_for_snake = game;
+    game_for_snake.you = snake;
     snake_interface->Start(string_pool_, game_for_snake, []() {});
   }
 }
 
 void GamePlayer::EndAll(const GameState& game) {
   for (const Snake& snake : game.board.snakes) {
-    GameState game_for_snake = game;
-    game_for_snake.you = snake;
-    SnakeId id = snake.id;
-
-    auto snake_it = snakes_map_.find(id);
-    if (snake_it == snakes_map_.end()) {
+    Battlesnake* snake_interface = SnakeInterface(snake);
+    if (snake_interface == nullptr) {
       continue;
     }
 
-    Battlesnake* snake_interface = snake_it->second;
+    GameState game_for_snake = game;
+    game_for_snake.you = snake;
     snake_interface->End(string_pool_, game_for_snake, []() {});
   }
 }
 
 GamePlayer::GetMovesResult GamePlayer::GetMovesParallel(const GameState& game) {
-  std::unordered_map<SnakeId, Battlesnake::MoveResponse> move_responses;
-  std::unordered_map<SnakeId, int> latencies;
+  MoveResponsesVector move_responses(players_.size());
+  LatenciesVector latencies(players_.size(), 0);
 
   // Send requests in parallel.
   std::vector<std::future<MoveResult>> move_futures;
@@ -249,26 +280,25 @@ GamePlayer::GetMovesResult GamePlayer::GetMovesParallel(const GameState& game) {
       continue;
     }
 
-    SnakeId id = snake.id;
-    auto snake_it = snakes_map_.find(id);
-    if (snake_it == snakes_map_.end()) {
+    Battlesnake* snake_interface = SnakeInterface(snake);
+    if (snake_interface == nullptr) {
       continue;
     }
 
     move_futures.push_back(std::async(std::launch::async, MoveSnake,
                                       string_pool_, game, snake,
-                                      snake_it->second));
+                                      snake_interface));
   }
 
   // Wait for and process responses.
   for (std::future<MoveResult>& move_future : move_futures) {
     MoveResult move_result = move_future.get();
-    if (move_result.snake_id.empty()) {
+    if (move_result.handle == kInvalidSnakeHandle) {
       continue;
     }
 
-    move_responses[move_result.snake_id] = move_result.response;
-    latencies[move_result.snake_id] = move_result.latency;
+    move_responses[move_result.handle] = move_result.response;
+    latencies[move_result.handle] = move_result.latency;
   }
 
   return std::tie(move_responses, latencies);
@@ -276,8 +306,8 @@ GamePlayer::GetMovesResult GamePlayer::GetMovesParallel(const GameState& game) {
 
 GamePlayer::GetMovesResult GamePlayer::GetMovesSequential(
     const GameState& game) {
-  std::unordered_map<SnakeId, Battlesnake::MoveResponse> move_responses;
-  std::unordered_map<SnakeId, int> latencies;
+  MoveResponsesVector move_responses(players_.size());
+  LatenciesVector latencies(players_.size(), 0);
 
   // Send requests in parallel.
   std::vector<std::future<MoveResult>> move_futures;
@@ -287,20 +317,19 @@ GamePlayer::GetMovesResult GamePlayer::GetMovesSequential(
       continue;
     }
 
-    SnakeId id = snake.id;
-    auto snake_it = snakes_map_.find(id);
-    if (snake_it == snakes_map_.end()) {
+    Battlesnake* snake_interface = SnakeInterface(snake);
+    if (snake_interface == nullptr) {
       continue;
     }
 
     MoveResult move_result =
-        MoveSnake(string_pool_, game, snake, snake_it->second);
-    if (move_result.snake_id.empty()) {
+        MoveSnake(string_pool_, game, snake, snake_interface);
+    if (move_result.handle == kInvalidSnakeHandle) {
       continue;
     }
 
-    move_responses[move_result.snake_id] = move_result.response;
-    latencies[move_result.snake_id] = move_result.latency;
+    move_responses[move_result.handle] = move_result.response;
+    latencies[move_result.handle] = move_result.latency;
   }
 
   return std::tie(move_responses, latencies);
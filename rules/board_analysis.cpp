@@ -0,0 +1,261 @@
+#include "battlesnake/rules/board_analysis.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace battlesnake {
+namespace rules {
+
+BoardBits Obstacles(const BoardState& state, bool include_hazards) {
+  BoardBits result = state.bodies;
+  BoardBitsView view(&result, state.width, state.height);
+  for (const Snake& snake : state.snakes) {
+    if (snake.IsEliminated() || snake.body.empty()) {
+      continue;
+    }
+    if (state.InBounds(snake.Head())) {
+      view.Set(snake.Head(), true);
+    }
+  }
+  if (include_hazards) {
+    result |= state.hazard;
+  }
+  return result;
+}
+
+FloodFillResult FloodFill(const BoardBits& start, const BoardBits& obstacles,
+                          const BoardBitsShifter& shifter, int max_steps,
+                          std::vector<BoardBits>* layers) {
+  const BoardBits free = AndNot(shifter.BoardMask(), obstacles);
+
+  FloodFillResult result{
+      .reached = And(start, shifter.BoardMask()),
+      .area = 0,
+      .steps = 0,
+  };
+  const int start_count = PopCount(result.reached);
+
+  if (layers != nullptr) {
+    layers->clear();
+    layers->push_back(result.reached);
+  }
+
+  BoardBits frontier = result.reached;
+  while (max_steps < 0 || result.steps < max_steps) {
+    // Cells next to the frontier that are free and not visited yet.
+    frontier = AndNot(And(shifter.Neighbours(frontier), free), result.reached);
+    if (IsEmpty(frontier)) {
+      break;
+    }
+
+    result.reached |= frontier;
+    result.steps++;
+    if (layers != nullptr) {
+      layers->push_back(frontier);
+    }
+  }
+
+  result.area = PopCount(result.reached) - start_count;
+  return result;
+}
+
+FloodFillResult ReachableArea(const BoardState& state, int snake_index,
+                              const BoardBitsShifter& shifter,
+                              bool include_hazards) {
+  BoardBits start{};
+  const Snake& snake = state.snakes[snake_index];
+  if (!snake.body.empty() && state.InBounds(snake.Head())) {
+    BoardBitsView(&start, state.width, state.height).Set(snake.Head(), true);
+  }
+
+  return FloodFill(start, Obstacles(state, include_hazards), shifter);
+}
+
+Territory ComputeTerritory(const BoardState& state,
+                           const BoardBitsShifter& shifter,
+                           bool include_hazards) {
+  Territory result{
+      .width = state.width,
+      .height = state.height,
+  };
+  std::fill(std::begin(result.owner), std::end(result.owner),
+            Territory::kNoOwner);
+  std::fill(std::begin(result.distance), std::end(result.distance),
+            Territory::kUnreachable);
+
+  // Snakes taking part, longest first. Equal length snakes are adjacent.
+  int order[kSnakesCountMax];
+  int order_size = 0;
+  for (int i = 0; i < state.snakes.size(); ++i) {
+    const Snake& snake = state.snakes[i];
+    if (snake.IsEliminated() || snake.body.empty() ||
+        !state.InBounds(snake.Head())) {
+      continue;
+    }
+    order[order_size++] = i;
+  }
+  // Insertion sort keeps ties in index order, doesn't allocate and is enough
+  // for kSnakesCountMax snakes. std::sort over `order` also trips GCC's
+  // -Warray-bounds for its paths over 16 elements.
+  for (int k = 1; k < order_size; ++k) {
+    const int index = order[k];
+    const size_t length = state.snakes[index].Length();
+    int j = k;
+    for (; j > 0 && state.snakes[order[j - 1]].Length() < length; --j) {
+      order[j] = order[j - 1];
+    }
+    order[j] = index;
+  }
+
+  // Cells each snake tries to claim at the current distance.
+  BoardBits frontier[kSnakesCountMax];
+  for (int k = 0; k < order_size; ++k) {
+    int i = order[k];
+    frontier[i] = BoardBits{};
+    BoardBitsView(&frontier[i], state.width, state.height)
+        .Set(state.snakes[i].Head(), true);
+  }
+
+  const BoardBits free =
+      AndNot(shifter.BoardMask(), Obstacles(state, include_hazards));
+  BoardBits claimed{};
+
+  for (int distance = 0;; ++distance) {
+    // Resolve conflicts group by group, longest snakes first. Cells taken by
+    // a longer snake are lost for shorter ones. Cells wanted by several snakes
+    // of the same length are lost for all of them.
+    BoardBits taken{};
+    BoardBits tied{};
+    for (int group_begin = 0; group_begin < order_size;) {
+      const size_t length = state.snakes[order[group_begin]].Length();
+      int group_end = group_begin;
+      BoardBits group_seen{};
+      BoardBits group_tied{};
+      while (group_end < order_size &&
+             state.snakes[order[group_end]].Length() == length) {
+        BoardBits& cells = frontier[order[group_end]];
+        cells = AndNot(cells, taken);
+        group_tied |= And(group_seen, cells);
+        group_seen |= cells;
+        group_end++;
+      }
+      if (!IsEmpty(group_tied)) {
+        for (int k = group_begin; k < group_end; ++k) {
+          frontier[order[k]] = AndNot(frontier[order[k]], group_tied);
+        }
+        tied |= group_tied;
+      }
+      taken |= group_seen;
+      group_begin = group_end;
+    }
+    claimed |= taken;
+
+    result.neutral |= tied;
+    ForEachBit(tied, [&result, distance](int index) {
+      result.distance[index] = distance;
+    });
+
+    bool expanded = false;
+    for (int k = 0; k < order_size; ++k) {
+      int i = order[k];
+      if (IsEmpty(frontier[i])) {
+        continue;
+      }
+      expanded = true;
+      result.cells[i] |= frontier[i];
+      ForEachBit(frontier[i], [&result, i, distance](int index) {
+        result.owner[index] = static_cast<signed char>(i);
+        result.distance[index] = distance;
+      });
+    }
+    if (!expanded) {
+      break;
+    }
+
+    for (int k = 0; k < order_size; ++k) {
+      int i = order[k];
+      frontier[i] =
+          AndNot(And(shifter.Neighbours(frontier[i]), free), claimed);
+    }
+  }
+
+  for (int k = 0; k < order_size; ++k) {
+    result.area[order[k]] = PopCount(result.cells[order[k]]);
+  }
+
+  return result;
+}
+
+MoveMask SafeMoves(const BoardState& state, int snake_index,
+                   const BoardBitsShifter& shifter,
+                   const SafeMovesConfig& config) {
+  const Snake& snake = state.snakes[snake_index];
+  if (snake.IsEliminated() || snake.body.empty()) {
+    return 0;
+  }
+
+  // Cells that can't be entered: bodies without tails that move away this
+  // turn, and heads that leave their necks behind. Cells next to heads of
+  // snakes that are not shorter are contested.
+  BoardBits blocked = state.bodies;
+  BoardBits contested_heads{};
+  BoardBitsView blocked_view(&blocked, state.width, state.height);
+  BoardBitsView contested_heads_view(&contested_heads, state.width,
+                                     state.height);
+  for (int i = 0; i < state.snakes.size(); ++i) {
+    const Snake& other = state.snakes[i];
+    if (other.IsEliminated() || other.body.empty() ||
+        !state.InBounds(other.Head())) {
+      continue;
+    }
+    const int length = other.body.Length();
+    if (length >= 2 && other.body.moves_length == length - 1 &&
+        state.InBounds(other.body.TailPos())) {
+      // No pieces are stacked at the tail, so it moves away.
+      blocked_view.Set(other.body.TailPos(), false);
+    }
+    if (i == snake_index) {
+      continue;
+    }
+    if (length >= 2) {
+      blocked_view.Set(other.Head(), true);
+    }
+    if (config.avoid_head_to_head && length >= snake.Length()) {
+      contested_heads_view.Set(other.Head(), true);
+    }
+  }
+  const BoardBits contested = config.avoid_head_to_head
+                                  ? shifter.Neighbours(contested_heads)
+                                  : BoardBits{};
+
+  const Point* wrapped_board_size = snake.body.WrappedBoardSizePtr();
+  MoveMask result = 0;
+  for (Move move : {Move::Up, Move::Down, Move::Left, Move::Right}) {
+    const Point p = snake.Head().Moved(move, wrapped_board_size);
+    if (!state.InBounds(p)) {
+      continue;
+    }
+    const int index = p.y * state.width + p.x;
+    if (blocked.Get(index) || contested.Get(index)) {
+      continue;
+    }
+
+    // Health after the move.
+    int health = snake.health - 1;
+    if (state.food.Get(index)) {
+      health = config.snake_max_health;
+    } else if (config.hazard_damage_per_turn != 0 && state.hazard.Get(index)) {
+      health -= config.hazard_damage_per_turn;
+    }
+    if (health <= 0) {
+      continue;
+    }
+
+    result |= MoveBit(move);
+  }
+
+  return result;
+}
+
+}  // namespace rules
+}  // namespace battlesnake
@@ -0,0 +1,263 @@
+#include "battlesnake/rules/board_bits_ops.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BATTLESNAKE_BOARD_BITS_POPCNT 1
+#include <immintrin.h>
+#endif
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+using BlockType = BoardBits::BlockType;
+static constexpr int kBlocksCount = BoardBits::kBlocksCount;
+static constexpr int kBlockSizeBits = BoardBits::kBlockSizeBits;
+
+int ScalarPopCount(const BoardBits& a) {
+  int result = 0;
+  for (BlockType block : a.data) {
+    result += std::popcount(block);
+  }
+  return result;
+}
+
+int ScalarSelectBit(const BoardBits& a, int rank) {
+  for (int i = 0; i < kBlocksCount; ++i) {
+    BlockType block = a.data[i];
+    const int count = std::popcount(block);
+    if (rank >= count) {
+      rank -= count;
+      continue;
+    }
+    for (; rank > 0; --rank) {
+      // Clear the lowest set bit.
+      block &= block - 1;
+    }
+    return i * kBlockSizeBits + std::countr_zero(block);
+  }
+  return -1;
+}
+
+constexpr BoardBitsKernels kScalarKernels{
+    .name = "scalar",
+    .pop_count = ScalarPopCount,
+    .select_bit = ScalarSelectBit,
+};
+
+#ifdef BATTLESNAKE_BOARD_BITS_POPCNT
+
+// Vector popcount (nibble lookup + vpsadbw) only pays off on much larger
+// inputs than 10 blocks, so popcnt instruction is used block by block.
+__attribute__((target("popcnt"))) int PopcntPopCount(const BoardBits& a) {
+  int result = 0;
+  for (BlockType block : a.data) {
+    result += static_cast<int>(_mm_popcnt_u64(block));
+  }
+  return result;
+}
+
+// Narrows the block down to 8 bits by counting bits of the lower half, then
+// clears the lowest set bits. BMI2 pdep would select the bit in one
+// instruction, but it's microcoded on AMD CPUs before Zen 3 and takes up to
+// hundreds of cycles there.
+__attribute__((target("bmi,popcnt"))) int PopcntSelectBit(const BoardBits& a,
+                                                         int rank) {
+  for (int i = 0; i < kBlocksCount; ++i) {
+    BlockType block = a.data[i];
+    const int count = static_cast<int>(_mm_popcnt_u64(block));
+    if (rank >= count) {
+      rank -= count;
+      continue;
+    }
+    int offset = 0;
+    for (int half = kBlockSizeBits / 2; half >= 8; half /= 2) {
+      const BlockType low = block & ((BlockType{1} << half) - 1);
+      const int low_count = static_cast<int>(_mm_popcnt_u64(low));
+      if (rank >= low_count) {
+        rank -= low_count;
+        block >>= half;
+        offset += half;
+      } else {
+        block = low;
+      }
+    }
+    for (; rank > 0; --rank) {
+      block = _blsr_u64(block);
+    }
+    return i * kBlockSizeBits + offset + static_cast<int>(_tzcnt_u64(block));
+  }
+  return -1;
+}
+
+constexpr BoardBitsKernels kPopcntKernels{
+    .name = "popcnt",
+    .pop_count = PopcntPopCount,
+    .select_bit = PopcntSelectBit,
+};
+
+bool CpuSupportsPopcnt() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("popcnt") && __builtin_cpu_supports("bmi");
+}
+
+#endif  // BATTLESNAKE_BOARD_BITS_POPCNT
+
+const BoardBitsKernels& SelectKernels() {
+  const BoardBitsKernels* popcnt = GetPopcntBoardBitsKernels();
+  if (popcnt != nullptr) {
+    return *popcnt;
+  }
+  return kScalarKernels;
+}
+
+// Treats bits as a single wide integer with bit 0 being the least significant
+// and shifts it by n bits towards higher indices. Then applies mask.
+void ShiftUpMasked(const BoardBits& bits, int n, const BoardBits& mask,
+                   BoardBits& result) {
+  const int block_shift = n / kBlockSizeBits;
+  const int bit_shift = n % kBlockSizeBits;
+  for (int i = kBlocksCount - 1; i >= 0; --i) {
+    const int source = i - block_shift;
+    BlockType value = 0;
+    if (source >= 0) {
+      value = bits.data[source] << bit_shift;
+      if (bit_shift != 0 && source > 0) {
+        value |= bits.data[source - 1] >> (kBlockSizeBits - bit_shift);
+      }
+    }
+    result.data[i] = value & mask.data[i];
+  }
+}
+
+// Same as ShiftUpMasked, but towards lower indices.
+void ShiftDownMasked(const BoardBits& bits, int n, const BoardBits& mask,
+                     BoardBits& result) {
+  const int block_shift = n / kBlockSizeBits;
+  const int bit_shift = n % kBlockSizeBits;
+  for (int i = 0; i < kBlocksCount; ++i) {
+    const int source = i + block_shift;
+    BlockType value = 0;
+    if (source < kBlocksCount) {
+      value = bits.data[source] >> bit_shift;
+      if (bit_shift != 0 && source + 1 < kBlocksCount) {
+        value |= bits.data[source + 1] << (kBlockSizeBits - bit_shift);
+      }
+    }
+    result.data[i] = value & mask.data[i];
+  }
+}
+
+}  // namespace
+
+const BoardBitsKernels& GetBoardBitsKernels() {
+  static const BoardBitsKernels& kernels = SelectKernels();
+  return kernels;
+}
+
+const BoardBitsKernels& GetScalarBoardBitsKernels() { return kScalarKernels; }
+
+const BoardBitsKernels* GetPopcntBoardBitsKernels() {
+#ifdef BATTLESNAKE_BOARD_BITS_POPCNT
+  static const bool supported = CpuSupportsPopcnt();
+  if (supported) {
+    return &kPopcntKernels;
+  }
+#endif
+  return nullptr;
+}
+
+BoardBitsShifter::BoardBitsShifter(int width, int height, bool wrapped)
+    : width_(width),
+      height_(height),
+      wrapped_(wrapped),
+      board_{},
+      left_column_{},
+      right_column_{} {
+  for (int i = 0; i < width * height; ++i) {
+    board_.Set(i, true);
+  }
+  for (int y = 0; y < height; ++y) {
+    left_column_.Set(y * width, true);
+    right_column_.Set(y * width + width - 1, true);
+  }
+  board_without_left_column_ = AndNot(board_, left_column_);
+  board_without_right_column_ = AndNot(board_, right_column_);
+}
+
+BoardBits BoardBitsShifter::Up(const BoardBits& bits) const {
+  BoardBits result;
+  ShiftUpMasked(bits, width_, board_, result);
+  if (wrapped_) {
+    // Top row goes to the bottom one, everything else is shifted out.
+    BoardBits wrapped;
+    ShiftDownMasked(bits, width_ * (height_ - 1), board_, wrapped);
+    result |= wrapped;
+  }
+  return result;
+}
+
+BoardBits BoardBitsShifter::Down(const BoardBits& bits) const {
+  BoardBits result;
+  ShiftDownMasked(bits, width_, board_, result);
+  if (wrapped_) {
+    // Bottom row goes to the top one, everything else is masked out.
+    BoardBits wrapped;
+    ShiftUpMasked(bits, width_ * (height_ - 1), board_, wrapped);
+    result |= wrapped;
+  }
+  return result;
+}
+
+BoardBits BoardBitsShifter::Left(const BoardBits& bits) const {
+  // Cells from the left column would land on the right column of the row
+  // below, mask them out.
+  BoardBits result;
+  ShiftDownMasked(bits, 1, board_without_right_column_, result);
+  if (wrapped_) {
+    BoardBits wrapped;
+    ShiftUpMasked(And(bits, left_column_), width_ - 1, right_column_, wrapped);
+    result |= wrapped;
+  }
+  return result;
+}
+
+BoardBits BoardBitsShifter::Right(const BoardBits& bits) const {
+  // Cells from the right column would land on the left column of the row
+  // above, mask them out.
+  BoardBits result;
+  ShiftUpMasked(bits, 1, board_without_left_column_, result);
+  if (wrapped_) {
+    BoardBits wrapped;
+    ShiftDownMasked(And(bits, right_column_), width_ - 1, left_column_,
+                    wrapped);
+    result |= wrapped;
+  }
+  return result;
+}
+
+BoardBits BoardBitsShifter::Moved(const BoardBits& bits, Move move) const {
+  switch (move) {
+    case Move::Up:
+      return Up(bits);
+    case Move::Down:
+      return Down(bits);
+    case Move::Left:
+      return Left(bits);
+    case Move::Right:
+      return Right(bits);
+    default:
+      return bits;
+  }
+}
+
+BoardBits BoardBitsShifter::Neighbours(const BoardBits& bits) const {
+  BoardBits result = Up(bits);
+  result |= Down(bits);
+  result |= Left(bits);
+  result |= Right(bits);
+  return result;
+}
+
+}  // namespace rules
+}  // namespace battlesnake
@@ -0,0 +1,297 @@
+#include "battlesnake/rules/board_hash.h"
+
+#include <algorithm>
+
+#include "battlesnake/rules/board_bits_ops.h"
+#include "battlesnake/rules/random.h"
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+static constexpr int kCellsCount = BoardBits::kBitsSizeNeeded;
+static constexpr int kHealthKeysCount = kBoardHashMaxHealth + 1;
+// Snake bodies never have more than kMaxSnakeBodyLen pieces.
+static constexpr int kLengthKeysCount = kMaxSnakeBodyLen + 1;
+// Fixed, so that hashes are the same between runs.
+static constexpr uint64_t kKeysSeed = 0x2545f4914f6cdd1dull;
+
+struct ZobristKeys {
+  uint64_t body[kSnakesCountMax][kCellsCount];
+  uint64_t head[kSnakesCountMax][kCellsCount];
+  uint64_t health[kSnakesCountMax][kHealthKeysCount];
+  uint64_t length[kSnakesCountMax][kLengthKeysCount];
+  uint64_t food[kCellsCount];
+  uint64_t hazard[kCellsCount];
+};
+
+template <int N>
+void FillKeys(RandomGenerator& random, uint64_t (&keys)[N]) {
+  for (uint64_t& key : keys) {
+    key = random.Next();
+  }
+}
+
+const ZobristKeys& GetKeys() {
+  static ZobristKeys keys;
+  static const bool initialized = []() {
+    RandomGenerator random(kKeysSeed);
+    for (int i = 0; i < kSnakesCountMax; ++i) {
+      FillKeys(random, keys.body[i]);
+      FillKeys(random, keys.head[i]);
+      FillKeys(random, keys.health[i]);
+      FillKeys(random, keys.length[i]);
+    }
+    FillKeys(random, keys.food);
+    FillKeys(random, keys.hazard);
+    return true;
+  }();
+  (void)initialized;
+
+  return keys;
+}
+
+// Points out of bounds don't contribute to the hash.
+template <class StateT>
+uint64_t CellKey(const uint64_t* keys, const StateT& state, const Point& p) {
+  if (!state.InBounds(p)) {
+    return 0;
+  }
+  return keys[p.y * state.width + p.x];
+}
+
+// Health and length are clamped to the keys table, see kBoardHashMaxHealth.
+uint64_t HealthKey(const ZobristKeys& keys, int snake_index, int health) {
+  return keys.health[snake_index][std::clamp(health, 0, kHealthKeysCount - 1)];
+}
+
+uint64_t LengthKey(const ZobristKeys& keys, int snake_index, int length) {
+  return keys.length[snake_index][std::clamp(length, 0, kLengthKeysCount - 1)];
+}
+
+template <class SnakeT>
+bool ContributesToHash(const SnakeT& snake) {
+  return !snake.IsEliminated() && !snake.body.empty();
+}
+
+template <class StateT>
+uint64_t SnakeHash(const ZobristKeys& keys, const StateT& state,
+                   int snake_index) {
+  const SnakeOf<StateT>& snake = state.snakes[snake_index];
+  uint64_t result = HealthKey(keys, snake_index, snake.health) ^
+                    LengthKey(keys, snake_index, snake.body.Length()) ^
+                    CellKey(keys.head[snake_index], state, snake.Head());
+  for (auto piece = snake.body.Head(); piece.Valid(); piece = piece.Next()) {
+    result ^= CellKey(keys.body[snake_index], state, piece.Pos());
+  }
+  return result;
+}
+
+// Everything the incremental update needs to know about a snake before the
+// move.
+struct SnakeSummary {
+  bool in_hash;
+  Point head;
+  Point tail;
+  int length;
+  int health;
+};
+
+template <class SnakeT>
+SnakeSummary Summarize(const SnakeT& snake) {
+  return SnakeSummary{
+      .in_hash = ContributesToHash(snake),
+      .head = snake.body.HeadPos(),
+      .tail = snake.body.TailPos(),
+      .length = snake.body.Length(),
+      .health = snake.health,
+  };
+}
+
+SnakeSummary Summarize(const UndoSnakeRecord& record) {
+  return SnakeSummary{
+      .in_hash = record.eliminated_cause.cause ==
+                     EliminatedCause::NotEliminated &&
+                 record.body.total_length != 0,
+      .head = record.body.head,
+      .tail = record.body.tail,
+      .length = record.body.total_length,
+      .health = record.health,
+  };
+}
+
+// Difference between hashes of the snake that has made a move and maybe grown
+// at the tail. Returns false if the snake has not made a move.
+template <class StateT>
+bool SnakeMoveDelta(const ZobristKeys& keys, const SnakeSummary& before,
+                    const StateT& next, int snake_index, uint64_t& delta) {
+  const SnakeOf<StateT>& after = next.snakes[snake_index];
+  const int growth = after.body.Length() - before.length;
+  if (growth < 0 || after.body.empty() || after.Head() == before.head) {
+    return false;
+  }
+
+  const uint64_t* body_keys = keys.body[snake_index];
+  const uint64_t* head_keys = keys.head[snake_index];
+
+  // New piece at the head, the last piece has left the old tail position.
+  uint64_t result = CellKey(body_keys, next, after.Head()) ^
+                    CellKey(body_keys, next, before.tail);
+  result ^= CellKey(head_keys, next, before.head) ^
+            CellKey(head_keys, next, after.Head());
+
+  if (growth != 0) {
+    // New pieces are stacked at the tail, pairs of them cancel out.
+    if (growth % 2 != 0) {
+      result ^= CellKey(body_keys, next, after.body.TailPos());
+    }
+    result ^= LengthKey(keys, snake_index, before.length) ^
+              LengthKey(keys, snake_index, after.body.Length());
+  }
+
+  if (before.health != after.health) {
+    result ^= HealthKey(keys, snake_index, before.health) ^
+              HealthKey(keys, snake_index, after.health);
+  }
+
+  delta = result;
+  return true;
+}
+
+// Hash of all snakes, food and hazards of the state.
+template <class StateT>
+uint64_t ComputeHash(const StateT& state) {
+  const ZobristKeys& keys = GetKeys();
+
+  uint64_t result = 0;
+  for (int i = 0; i < state.snakes.size(); ++i) {
+    if (ContributesToHash(state.snakes[i])) {
+      result ^= SnakeHash(keys, state, i);
+    }
+  }
+  ForEachBit(state.food, [&keys, &result](int index) {
+    result ^= keys.food[index];
+  });
+  ForEachBit(state.hazard, [&keys, &result](int index) {
+    result ^= keys.hazard[index];
+  });
+
+  return result;
+}
+
+// Hash of `next` from the hash of the previous state and its summary.
+template <class StateT>
+uint64_t UpdatedHash(uint64_t prev_hash, const SnakeSummary* before,
+                     const BitsOf<StateT>& prev_food,
+                     const BitsOf<StateT>& prev_hazard, const StateT& next) {
+  const ZobristKeys& keys = GetKeys();
+  uint64_t result = prev_hash;
+
+  for (int i = 0; i < next.snakes.size(); ++i) {
+    bool is_in_hash = ContributesToHash(next.snakes[i]);
+    if (!before[i].in_hash) {
+      if (is_in_hash) {
+        // Resurrected.
+        result ^= SnakeHash(keys, next, i);
+      }
+      continue;
+    }
+
+    uint64_t delta = 0;
+    if (!SnakeMoveDelta(keys, before[i], next, i, delta)) {
+      // Not a result of a move, recalculate.
+      return ComputeHash(next);
+    }
+    result ^= delta;
+    if (!is_in_hash) {
+      // Eliminated after the move: remove what the moved snake would add.
+      result ^= SnakeHash(keys, next, i);
+    }
+  }
+
+  // Only eaten, spawned and changed cells.
+  ForEachBit(Xor(prev_food, next.food), [&keys, &result](int index) {
+    result ^= keys.food[index];
+  });
+  ForEachBit(Xor(prev_hazard, next.hazard), [&keys, &result](int index) {
+    result ^= keys.hazard[index];
+  });
+
+  return result;
+}
+
+template <class StateT>
+void UpdateHash(const StateT& prev, StateT& next) {
+  if (prev.snakes.size() != next.snakes.size()) {
+    next.hash = ComputeHash(next);
+    return;
+  }
+
+  SnakeSummary before[kSnakesCountMax];
+  for (int i = 0; i < prev.snakes.size(); ++i) {
+    before[i] = Summarize(prev.snakes[i]);
+  }
+  next.hash = UpdatedHash(prev.hash != 0 ? prev.hash : ComputeHash(prev),
+                          before, prev.food, prev.hazard, next);
+}
+
+template <class UndoT, class StateT>
+void UpdateHashFromUndo(const UndoT& undo, StateT& next) {
+  if (undo.hash == 0) {
+    next.hash = ComputeHash(next);
+    return;
+  }
+
+  SnakeSummary before[kSnakesCountMax];
+  for (int i = 0; i < next.snakes.size(); ++i) {
+    before[i] = Summarize(undo.snakes[i]);
+  }
+  next.hash = UpdatedHash(undo.hash, before, undo.food, undo.hazard, next);
+}
+
+}  // namespace
+
+uint64_t ComputeBoardHash(const BoardState& state) {
+  return ComputeHash(state);
+}
+
+void UpdateBoardHash(const BoardState& prev, BoardState& next) {
+  UpdateHash(prev, next);
+}
+
+void UpdateBoardHash(const UndoRecord& undo, BoardState& next) {
+  UpdateHashFromUndo(undo, next);
+}
+
+template <Coordinate W, Coordinate H, int N>
+uint64_t ComputeBoardHash(const BoardStateT<W, H, N>& state) {
+  return ComputeHash(state);
+}
+
+template <Coordinate W, Coordinate H, int N>
+void UpdateBoardHash(const BoardStateT<W, H, N>& prev,
+                     BoardStateT<W, H, N>& next) {
+  UpdateHash(prev, next);
+}
+
+template <Coordinate W, Coordinate H, int N>
+void UpdateBoardHash(const typename BoardStateT<W, H, N>::UndoRecord& undo,
+                     BoardStateT<W, H, N>& next) {
+  UpdateHashFromUndo(undo, next);
+}
+
+#define INSTANTIATE_SIZED_HASH(W, H, N)                                  \
+  template uint64_t ComputeBoardHash(const BoardStateT<W, H, N>& state); \
+  template void UpdateBoardHash(const BoardStateT<W, H, N>& prev,        \
+                                BoardStateT<W, H, N>& next);             \
+  template void UpdateBoardHash<W, H, N>(                                \
+      const BoardStateT<W, H, N>::UndoRecord& undo,                      \
+      BoardStateT<W, H, N>& next);
+
+BATTLESNAKE_FOR_EACH_SIZED_BOARD(INSTANTIATE_SIZED_HASH)
+
+#undef INSTANTIATE_SIZED_HASH
+
+}  // namespace rules
+}  // namespace battlesnake
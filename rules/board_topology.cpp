@@ -0,0 +1,56 @@
+#include "battlesnake/rules/board_topology.h"
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+static constexpr BoardTopology kSmall(kBoardSizeSmall, kBoardSizeSmall, false);
+static constexpr BoardTopology kSmallWrapped(kBoardSizeSmall, kBoardSizeSmall,
+                                             true);
+static constexpr BoardTopology kMedium(kBoardSizeMedium, kBoardSizeMedium,
+                                       false);
+static constexpr BoardTopology kMediumWrapped(kBoardSizeMedium,
+                                              kBoardSizeMedium, true);
+static constexpr BoardTopology kLarge(kBoardSizeLarge, kBoardSizeLarge, false);
+static constexpr BoardTopology kLargeWrapped(kBoardSizeLarge, kBoardSizeLarge,
+                                             true);
+
+}  // namespace
+
+Move BoardTopology::DetectMove(const Point& from, const Point& to) const {
+  for (Move move : {Move::Up, Move::Down, Move::Left, Move::Right}) {
+    if (Moved(from, move) == to) {
+      return move;
+    }
+  }
+  return Move::Unknown;
+}
+
+Point BoardTopology::movedOffBoard(const Point& p, Move move) const {
+  if (!wrapped_) {
+    return p.Moved(move);
+  }
+  const Point board_size{width_, height_};
+  return p.Moved(move, &board_size);
+}
+
+const BoardTopology* BoardTopology::Find(Coordinate width, Coordinate height,
+                                         bool wrapped) {
+  if (width != height) {
+    return nullptr;
+  }
+  switch (width) {
+    case kBoardSizeSmall:
+      return wrapped ? &kSmallWrapped : &kSmall;
+    case kBoardSizeMedium:
+      return wrapped ? &kMediumWrapped : &kMedium;
+    case kBoardSizeLarge:
+      return wrapped ? &kLargeWrapped : &kLarge;
+    default:
+      return nullptr;
+  }
+}
+
+}  // namespace rules
+}  // namespace battlesnake
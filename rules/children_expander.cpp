@@ -0,0 +1,110 @@
+#include "battlesnake/rules/children_expander.h"
+
+#include "battlesnake/rules/board_hash.h"
+
+namespace battlesnake {
+namespace rules {
+
+template <class RulesetT>
+ChildrenExpanderT<RulesetT>::ChildrenExpanderT(RulesetT& ruleset,
+                                               const State& state,
+                                               const MoveMasksVector& masks,
+                                               int turn)
+    : ruleset_(ruleset), parent_(state), turn_(turn), done_(false) {
+  parent_.EnsureBodies();
+  if (parent_.hash == 0) {
+    parent_.hash = ComputeBoardHash(parent_);
+  }
+
+  for (int i = 0; i < parent_.snakes.size(); ++i) {
+    positions_[i] = 0;
+    moves_[i].clear();
+
+    if (parent_.snakes[i].IsEliminated()) {
+      // Doesn't move, any move gives the same child.
+      moves_[i].push_back(Move::Up);
+      moveSnake(i, Move::Up, moved_snakes_[i][0]);
+      continue;
+    }
+
+    const MoveMask mask = i < masks.size() ? masks[i] : kAllMovesMask;
+    for (Move move : {Move::Up, Move::Down, Move::Left, Move::Right}) {
+      if ((mask & MoveBit(move)) == 0) {
+        continue;
+      }
+      moveSnake(i, move, moved_snakes_[i][moves_[i].size()]);
+      moves_[i].push_back(move);
+    }
+    if (moves_[i].empty()) {
+      done_ = true;
+    }
+  }
+}
+
+template <class RulesetT>
+void ChildrenExpanderT<RulesetT>::moveSnake(int snake_index, Move move,
+                                            MovedSnake& result) const {
+  result.snake = parent_.snakes[snake_index];
+  ruleset_.StepSnake(parent_, result.snake, move, result.step);
+}
+
+template <class RulesetT>
+int ChildrenExpanderT<RulesetT>::ChildrenCount() const {
+  int result = 1;
+  for (int i = 0; i < parent_.snakes.size(); ++i) {
+    result *= moves_[i].size();
+  }
+  return result;
+}
+
+template <class RulesetT>
+bool ChildrenExpanderT<RulesetT>::Next(JointMove& joint_move, State& child) {
+  if (done_) {
+    return false;
+  }
+
+  joint_move = 0;
+  for (int i = 0; i < parent_.snakes.size(); ++i) {
+    SetSnakeMove(joint_move, i, moves_[i][positions_[i]]);
+  }
+
+  if (ruleset_.GetConfig().turn_pipeline ==
+      StandardRuleset::TurnPipeline::Staged) {
+    ruleset_.CreateNextBoardStateJoint(parent_, joint_move, turn_, child);
+  } else {
+    child = parent_;
+    StandardRuleset::SnakeStep steps[kSnakesCountMax];
+    for (int i = 0; i < parent_.snakes.size(); ++i) {
+      const MovedSnake& moved = moved_snakes_[i][positions_[i]];
+      child.snakes[i] = moved.snake;
+      steps[i] = moved.step;
+    }
+    ruleset_.ApplySnakeSteps(child, steps);
+    ruleset_.ResolveTurn(child, turn_);
+    UpdateBoardHash(parent_, child);
+  }
+
+  // Advance to the next joint move.
+  done_ = true;
+  for (int i = 0; i < parent_.snakes.size(); ++i) {
+    if (++positions_[i] < moves_[i].size()) {
+      done_ = false;
+      break;
+    }
+    positions_[i] = 0;
+  }
+
+  return true;
+}
+
+template class ChildrenExpanderT<StandardRuleset>;
+
+#define INSTANTIATE_SIZED_EXPANDER(W, H, N) \
+  template class ChildrenExpanderT<StandardRulesetT<W, H, N>>;
+
+BATTLESNAKE_FOR_EACH_SIZED_BOARD(INSTANTIATE_SIZED_EXPANDER)
+
+#undef INSTANTIATE_SIZED_EXPANDER
+
+}  // namespace rules
+}  // namespace battlesnake
@@ -1,5 +1,7 @@
 #include "battlesnake/rules/constrictor_ruleset.h"
 
+#include "battlesnake/rules/board_hash.h"
+
 namespace battlesnake {
 namespace rules {
 
@@ -9,17 +11,16 @@ BoardState ConstrictorRuleset::CreateInitialBoardState(
       StandardRuleset::CreateInitialBoardState(width, height, snake_ids);
 
   applyConstrictorRules(next_state);
+  next_state.hash = ComputeBoardHash(next_state);
 
   return next_state;
 }
 
-void ConstrictorRuleset::CreateNextBoardState(const BoardState& prev_state,
-                                              const SnakeMovesVector& moves,
-                                              int turn,
-                                              BoardState& next_state) {
-  StandardRuleset::CreateNextBoardState(prev_state, moves, turn, next_state);
+void ConstrictorRuleset::resolveTurn(BoardState& state, int turn,
+                                     BoundsCheck bounds_check) {
+  StandardRuleset::resolveTurn(state, turn, bounds_check);
 
-  applyConstrictorRules(next_state);
+  applyConstrictorRules(state);
 }
 
 void ConstrictorRuleset::applyConstrictorRules(BoardState& state) const {
@@ -29,12 +30,12 @@ void ConstrictorRuleset::applyConstrictorRules(BoardState& state) const {
     snake.health = snake_max_health_;
 
     if (snake.Length() < 2) {
-      growSnake(snake);
+      growSnake(state, snake);
       continue;
     }
 
     if (snake.body.moves_length == snake.body.total_length - 1) {
-      growSnake(snake);
+      growSnake(state, snake);
     }
   }
 }
@@ -2,6 +2,7 @@
 
 #include <cstring>
 
+#include "battlesnake/rules/board_topology.h"
 #include "battlesnake/rules/errors.h"
 
 namespace battlesnake {
@@ -63,20 +64,103 @@ bool operator==(const std::string& b, const StringWrapper& a) { return a == b; }
 bool operator!=(const std::string& b, const StringWrapper& a) { return a != b; }
 
 StringWrapper StringPool::Add(const std::string& s) {
-  std::lock_guard guard(mutex_);
-
-  auto it = index_.find(s);
-  if (it != index_.end()) {
-    return StringWrapper{.value = it->second};
+  const uint64_t generation = generation_.load(std::memory_order_relaxed);
+  Shard& shard = shardFor(s);
+  std::lock_guard guard(shard.mutex);
+  ++shard.stats.adds;
+
+  auto it = shard.index.find(s);
+  if (it != shard.index.end()) {
+    ++shard.stats.hits;
+    it->second->generation = generation;
+    return StringWrapper{.value = &it->second->value};
   }
 
-  strings_.push_front(s);
-  std::string* new_string = &strings_.front();
-  index_[*new_string] = new_string;
+  auto entry = std::make_unique<Entry>(Entry{
+      .value = s,
+      .generation = generation,
+  });
+  std::string* new_string = &entry->value;
+  shard.memory_usage += entryMemoryUsage(*entry);
+  shard.index.emplace(*new_string, std::move(entry));
   return StringWrapper{.value = new_string};
 }
 
-size_t StringPool::Size() const { return index_.size(); }
+uint64_t StringPool::Generation() const {
+  return generation_.load(std::memory_order_relaxed);
+}
+
+uint64_t StringPool::NewGeneration() {
+  return generation_.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+size_t StringPool::FreeUnusedSince(uint64_t generation) {
+  size_t freed = 0;
+  for (Shard& shard : shards_) {
+    std::lock_guard guard(shard.mutex);
+    for (auto it = shard.index.begin(); it != shard.index.end();) {
+      if (it->second->generation >= generation) {
+        ++it;
+        continue;
+      }
+      shard.memory_usage -= entryMemoryUsage(*it->second);
+      ++shard.stats.freed;
+      ++freed;
+      // Key refers to the entry, so it's erased before the entry is freed.
+      it = shard.index.erase(it);
+    }
+  }
+  return freed;
+}
+
+size_t StringPool::Size() const {
+  size_t size = 0;
+  for (const Shard& shard : shards_) {
+    std::lock_guard guard(shard.mutex);
+    size += shard.index.size();
+  }
+  return size;
+}
+
+size_t StringPool::MemoryUsage() const {
+  size_t memory_usage = sizeof(*this);
+  for (const Shard& shard : shards_) {
+    std::lock_guard guard(shard.mutex);
+    memory_usage += shard.memory_usage +
+                    shard.index.bucket_count() * sizeof(void*);
+  }
+  return memory_usage;
+}
+
+StringPool::Stats StringPool::GetStats() const {
+  Stats result{};
+  for (const Shard& shard : shards_) {
+    std::lock_guard guard(shard.mutex);
+    result.adds += shard.stats.adds;
+    result.hits += shard.stats.hits;
+    result.freed += shard.stats.freed;
+  }
+  return result;
+}
+
+size_t StringPool::entryMemoryUsage(const Entry& entry) {
+  // Index node holds the key, the pointer and the cached hash. Short strings
+  // are stored inside std::string itself.
+  size_t result = sizeof(Entry) + sizeof(std::string_view) +
+                  sizeof(std::unique_ptr<Entry>) + 2 * sizeof(void*);
+  const char* data = entry.value.data();
+  const char* object = reinterpret_cast<const char*>(&entry.value);
+  if (data < object || data >= object + sizeof(entry.value)) {
+    result += entry.value.capacity() + 1;
+  }
+  return result;
+}
+
+StringPool::Shard& StringPool::shardFor(std::string_view s) {
+  // Top bits of the hash, low bits choose buckets in the shard index.
+  const size_t hash = std::hash<std::string_view>()(s);
+  return shards_[std::rotl(hash, 4) % kShardsCount];
+}
 
 Point Point::Up(const Point* wrapped_board_size) const {
   if (wrapped_board_size != nullptr) {
@@ -127,6 +211,14 @@ Point Point::Moved(Move move, const Point* wrapped_board_size) const {
 
 Move DetectMove(const Point& from, const Point& to,
                 const Point* wrapped_board_size) {
+  if (wrapped_board_size != nullptr) {
+    const BoardTopology* topology = BoardTopology::Find(
+        wrapped_board_size->x, wrapped_board_size->y, true);
+    if (topology != nullptr) {
+      return topology->DetectMove(from, to);
+    }
+  }
+
   if (to == from.Up(wrapped_board_size)) return Move::Up;
   if (to == from.Down(wrapped_board_size)) return Move::Down;
   if (to == from.Left(wrapped_board_size)) return Move::Left;
@@ -134,7 +226,9 @@ Move DetectMove(const Point& from, const Point& to,
   return Move::Unknown;
 }
 
-SnakeBody::Piece SnakeBody::Piece::Next() const {
+template <int kMaxLength>
+typename SnakeBodyT<kMaxLength>::Piece SnakeBodyT<kMaxLength>::Piece::Next()
+    const {
   if (!Valid()) {
     return *this;
   }
@@ -142,14 +236,18 @@ SnakeBody::Piece SnakeBody::Piece::Next() const {
     return Piece(body_, index_ + 1, pos_);
   }
   if (body_->NextRepeated(index_)) {
-    return Piece(body_, index_ + 1, pos_);
+    return Piece(body_, index_ + 1, pos_, topology_);
+  }
+  const Move move = body_->NextMove(index_);
+  if (topology_ != nullptr) {
+    return Piece(body_, index_ + 1, topology_->Moved(pos_, move), topology_);
   }
-  return Piece(
-      body_, index_ + 1,
-      pos_.Moved(body_->NextMove(index_), body_->WrappedBoardSizePtr()));
+  return Piece(body_, index_ + 1,
+               pos_.Moved(move, body_->WrappedBoardSizePtr()));
 }
 
-bool SnakeBody::Piece::operator==(const SnakeBody::Piece& other) const {
+template <int kMaxLength>
+bool SnakeBodyT<kMaxLength>::Piece::operator==(const Piece& other) const {
   if (!this->Valid() && !other.Valid()) return true;
   if (this->Valid() != other.Valid()) return false;
 
@@ -159,7 +257,23 @@ bool SnakeBody::Piece::operator==(const SnakeBody::Piece& other) const {
   return true;
 }
 
-void SnakeBody::MoveTo(Move move) {
+template <int kMaxLength>
+const BoardTopology* SnakeBodyT<kMaxLength>::Topology() const {
+  return BoardTopology::Find(*this);
+}
+
+template <int kMaxLength>
+Move SnakeBodyT<kMaxLength>::detectMove(const BoardTopology* topology,
+                                        const Point& from,
+                                        const Point& to) const {
+  if (topology != nullptr) {
+    return topology->DetectMove(from, to);
+  }
+  return DetectMove(from, to, WrappedBoardSizePtr());
+}
+
+template <int kMaxLength>
+Move SnakeBodyT<kMaxLength>::ResolveMove(Move move) const {
   if (move == Move::Unknown) {
     if (size() >= 2) {
       move = DetectMove(Head().Next().Pos(), Head().Pos());
@@ -168,8 +282,21 @@ void SnakeBody::MoveTo(Move move) {
   if (move == Move::Unknown) {
     move = Move::Up;
   }
+  return move;
+}
+
+template <int kMaxLength>
+void SnakeBodyT<kMaxLength>::MoveTo(Move move) {
+  move = ResolveMove(move);
+
+  // Tail follows only if there are no pieces stacked at the tail. Remember the
+  // move to the tail before the moves are updated.
+  bool tail_follows = moves_length > 0 && moves_length == total_length - 1;
+  Move to_tail = tail_follows ? NextMove(moves_length - 1) : Move::Unknown;
 
-  head = head.Moved(move, WrappedBoardSizePtr());
+  const BoardTopology* topology = Topology();
+  head = topology != nullptr ? topology->Moved(head, move)
+                             : head.Moved(move, WrappedBoardSizePtr());
   if (moves_offset == 0) {
     moves.push_front(0);
     moves_offset = kMovesPerBlock;
@@ -189,11 +316,67 @@ void SnakeBody::MoveTo(Move move) {
   if (moves.size() > blocks_needed) {
     moves.resize(blocks_needed);
   }
+
+  if (total_length <= 1) {
+    tail = head;
+  } else if (tail_follows) {
+    tail = topology != nullptr
+               ? topology->Moved(tail, Opposite(to_tail))
+               : tail.Moved(Opposite(to_tail), WrappedBoardSizePtr());
+  }
 }
 
-void SnakeBody::IncreaseLength(int delta) { total_length += delta; }
+template <int kMaxLength>
+void SnakeBodyT<kMaxLength>::IncreaseLength(int delta) {
+  total_length += delta;
+}
+
+template <int kMaxLength>
+SnakeBodyCheckpoint SnakeBodyT<kMaxLength>::SaveCheckpoint() const {
+  Checkpoint result{
+      .head = head,
+      .tail = tail,
+      .total_length = total_length,
+      .moves_length = moves_length,
+      .moves_offset = moves_offset,
+      .front_block = 0,
+      .back_block = 0,
+      .blocks_count = static_cast<short>(moves.size()),
+  };
+  if (moves.size() > 0) {
+    result.front_block = moves.front();
+    result.back_block = moves.at(moves.size() - 1);
+  }
+  return result;
+}
+
+template <int kMaxLength>
+void SnakeBodyT<kMaxLength>::RestoreCheckpoint(
+    const Checkpoint& checkpoint) {
+  // MoveTo() always changes moves offset.
+  if (moves_offset != checkpoint.moves_offset) {
+    // A block is added to the front if there was no room for the new move.
+    // The last block is dropped if it doesn't have moves anymore.
+    bool block_added = checkpoint.moves_offset == 0;
+    if (moves.size() < checkpoint.blocks_count + (block_added ? 1 : 0)) {
+      moves.push_back(checkpoint.back_block);
+    }
+    if (block_added) {
+      moves.pop_front();
+    } else {
+      moves.front() = checkpoint.front_block;
+    }
+  }
 
-Move SnakeBody::NextMove(short index) const {
+  head = checkpoint.head;
+  tail = checkpoint.tail;
+  total_length = checkpoint.total_length;
+  moves_length = checkpoint.moves_length;
+  moves_offset = checkpoint.moves_offset;
+}
+
+template <int kMaxLength>
+Move SnakeBodyT<kMaxLength>::NextMove(short index) const {
   short index_moves_offset = index + moves_offset;
 
   short index_block = index_moves_offset / kMovesPerBlock;
@@ -203,7 +386,9 @@ Move SnakeBody::NextMove(short index) const {
   return static_cast<Move>((block_data >> (index_block_offset * 2)) & 0x03u);
 }
 
-bool operator==(const SnakeBody& a, const SnakeBody& b) {
+template <int kMaxLength>
+bool operator==(const SnakeBodyT<kMaxLength>& a,
+                const SnakeBodyT<kMaxLength>& b) {
   if (a.head != b.head) {
     return false;
   }
@@ -223,6 +408,21 @@ bool operator==(const SnakeBody& a, const SnakeBody& b) {
   return true;
 }
 
+// Bodies of BoardState and of states specialized for board size, see
+// sized_board_state.h.
+template struct SnakeBodyT<kMaxSnakeBodyLen>;
+template struct SnakeBodyT<MaxSnakeBodyLength(kBoardSizeSmall, kBoardSizeSmall)>;
+template struct SnakeBodyT<MaxSnakeBodyLength(kBoardSizeMedium,
+                                              kBoardSizeMedium)>;
+template bool operator==(const SnakeBody& a, const SnakeBody& b);
+template bool operator==(
+    const SnakeBodyT<MaxSnakeBodyLength(kBoardSizeSmall, kBoardSizeSmall)>& a,
+    const SnakeBodyT<MaxSnakeBodyLength(kBoardSizeSmall, kBoardSizeSmall)>& b);
+template bool operator==(
+    const SnakeBodyT<MaxSnakeBodyLength(kBoardSizeMedium, kBoardSizeMedium)>& a,
+    const SnakeBodyT<MaxSnakeBodyLength(kBoardSizeMedium, kBoardSizeMedium)>&
+        b);
+
 bool BoardBits::Get(int index) const {
   int block_index = index / kBlockSizeBits;
   int block_offset = index % kBlockSizeBits;
@@ -248,6 +448,57 @@ bool operator==(const BoardBits& a, const BoardBits& b) {
   return std::memcmp(&a, &b, sizeof(a)) == 0;
 }
 
+void BoardState::RebuildBodies() {
+  bodies.clear();
+  BoardBitsView view = Bodies();
+  for (const Snake& snake : snakes) {
+    if (snake.IsEliminated() || snake.body.empty()) {
+      continue;
+    }
+    // Start with the neck.
+    for (SnakeBody::Piece piece = snake.body.Head().Next(); piece.Valid();
+         piece = piece.Next()) {
+      if (InBounds(piece.Pos())) {
+        view.Set(piece.Pos(), true);
+      }
+    }
+  }
+}
+
+void BoardState::EnsureBodies() {
+  for (BoardBits::BlockType block : bodies.data) {
+    if (block != 0) {
+      return;
+    }
+  }
+  RebuildBodies();
+}
+
+void BoardState::ResetDerivedData() {
+  RebuildBodies();
+  hash = 0;
+}
+
+void BoardState::AssignHandles() {
+  for (int i = 0; i < snakes.size(); ++i) {
+    snakes[i].handle = static_cast<SnakeHandle>(i);
+  }
+}
+
+Snake* BoardState::FindSnake(SnakeHandle handle) {
+  if (handle >= snakes.size() || snakes[handle].handle != handle) {
+    return nullptr;
+  }
+  return &snakes[handle];
+}
+
+const Snake* BoardState::FindSnake(SnakeHandle handle) const {
+  if (handle >= snakes.size() || snakes[handle].handle != handle) {
+    return nullptr;
+  }
+  return &snakes[handle];
+}
+
 template <class BitsType>
 BoardBitsViewBase<BitsType>::BitsIterator::BitsIterator(
     const BoardBitsViewBase<BitsType>* owner, int index) {
@@ -262,28 +513,16 @@ template <class BitsType>
 void BoardBitsViewBase<BitsType>::BitsIterator::AdvanceToNextPoint() {
   // Find a `1` bit starting from current position.
   while (IsValid()) {
-    BoardBits::BlockType block = owner_->bits_->data[block_index_];
-    BoardBits::BlockType bit_block_value =
-        static_cast<BoardBits::BlockType>(1)
-        << static_cast<BoardBits::BlockType>(block_offset_);
-    bool bit = (block & bit_block_value) != 0;
-    if (bit) break;
-
-    if ((block >> block_offset_) == 0) {
-      // No `1` bits left in the current block. Move to the next one.
-      block_offset_ = 0;
-      block_index_++;
-      continue;
+    BoardBits::BlockType block =
+        owner_->bits_->data[block_index_] >> block_offset_;
+    if (block != 0) {
+      block_offset_ += std::countr_zero(block);
+      break;
     }
 
-    while (IsValid() && block_offset_ < BoardBits::kBlockSizeBits) {
-      block_offset_++;
-      BoardBits::BlockType bit_block_value =
-          static_cast<BoardBits::BlockType>(1)
-          << static_cast<BoardBits::BlockType>(block_offset_);
-      bit = (block & bit_block_value) != 0;
-      if (bit) break;
-    }
+    // No `1` bits left in the current block. Move to the next one.
+    block_offset_ = 0;
+    block_index_++;
   }
 }
 
@@ -351,6 +590,12 @@ bool BoardBitsViewBase<BitsType>::BitsIterator::operator==(
 
 template class BoardBitsViewBase<BoardBits>;
 template class BoardBitsViewBase<const BoardBits>;
+// Bits of states specialized for 7x7 and 11x11 boards, see
+// sized_board_state.h.
+template class BoardBitsViewBase<BoardBitsT<1>>;
+template class BoardBitsViewBase<const BoardBitsT<1>>;
+template class BoardBitsViewBase<BoardBitsT<2>>;
+template class BoardBitsViewBase<const BoardBitsT<2>>;
 
 std::ostream& operator<<(std::ostream& s, const StringWrapper& string) {
   return s << string.ToString();
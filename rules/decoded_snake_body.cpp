@@ -0,0 +1,41 @@
+#include "battlesnake/rules/decoded_snake_body.h"
+
+namespace battlesnake {
+namespace rules {
+
+DecodedSnakeBody DecodedSnakeBody::FromSnakeBody(const SnakeBody& body) {
+  DecodedSnakeBody result;
+  result.head_ = 0;
+  result.distinct_ = 0;
+  result.total_length_ = body.Length();
+  result.wrapped_board_size_ = body.wrapped_board_size;
+  result.topology_ = body.Topology();
+
+  for (SnakeBody::Piece piece = body.Head();
+       piece.Valid() && result.distinct_ <= body.moves_length;
+       piece = piece.Next()) {
+    result.points_[result.distinct_++] = piece.Pos();
+  }
+  return result;
+}
+
+void DecodedSnakeBody::MoveTo(Move move) {
+  const Point& head = HeadPos();
+  Point new_head;
+  if (topology_ != nullptr) {
+    new_head = topology_->Moved(head, move);
+  } else if (wrapped_board_size_.x != 0 && wrapped_board_size_.y != 0) {
+    new_head = head.Moved(move, &wrapped_board_size_);
+  } else {
+    new_head = head.Moved(move);
+  }
+
+  // Old tail position drops out of the distinct positions by itself, unless
+  // there are pieces stacked at the tail.
+  head_ = (head_ - 1) & kMask;
+  points_[head_] = new_head;
+  distinct_ = std::min(distinct_ + 1, std::max(total_length_, 1));
+}
+
+}  // namespace rules
+}  // namespace battlesnake
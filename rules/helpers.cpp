@@ -200,7 +200,7 @@ std::string RenderGame(
     AppendLine(lines, board_len, n++,
                head_char + ":  " + std::to_string(snake.health) + "  " +
                    std::to_string(snake.Length()) + "  " +
-                   snake.name.ToString() + "  " + snake.latency.ToString() +
+                   snake.name.ToString() + "  " + std::to_string(snake.latency) +
                    "ms  " + snake.squad.ToString());
   }
 
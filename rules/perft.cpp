@@ -0,0 +1,46 @@
+#include "battlesnake/rules/perft.h"
+
+#include "battlesnake/rules/children_expander.h"
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+void PerftRecursive(StandardRuleset& ruleset, const BoardState& state,
+                    int depth, int turn, PerftCounts& counts) {
+  ChildrenExpander expander(ruleset, state, MoveMasksVector{}, turn);
+  JointMove joint_move = 0;
+  BoardState child{};
+  while (expander.Next(joint_move, child)) {
+    ++counts.nodes;
+    if (ruleset.IsGameOver(child)) {
+      ++counts.terminal_nodes;
+    } else if (depth == 1) {
+      ++counts.leaf_nodes;
+    } else {
+      PerftRecursive(ruleset, child, depth - 1, turn + 1, counts);
+    }
+  }
+}
+
+}  // namespace
+
+PerftCounts Perft(StandardRuleset& ruleset, const BoardState& state,
+                  int depth, int turn) {
+  PerftCounts counts;
+  if (depth <= 0 || ruleset.IsGameOver(state)) {
+    return counts;
+  }
+  PerftRecursive(ruleset, state, depth, turn, counts);
+  return counts;
+}
+
+std::ostream& operator<<(std::ostream& s, const PerftCounts& counts) {
+  return s << "{nodes: " << counts.nodes
+           << ", terminal_nodes: " << counts.terminal_nodes
+           << ", leaf_nodes: " << counts.leaf_nodes << "}";
+}
+
+}  // namespace rules
+}  // namespace battlesnake
@@ -0,0 +1,43 @@
+#include "battlesnake/rules/random.h"
+
+#include <random>
+
+namespace battlesnake {
+namespace rules {
+
+RandomGenerator RandomGenerator::CreateRandomlySeeded() {
+  std::random_device random_device;
+  uint64_t seed = (static_cast<uint64_t>(random_device()) << 32) ^
+                  static_cast<uint64_t>(random_device());
+  return RandomGenerator(seed);
+}
+
+void RandomGenerator::Seed(uint64_t seed) {
+  // Expand seed into full state with SplitMix64, as recommended by xoshiro
+  // authors. It guarantees that state is never all zeros.
+  for (uint64_t& s : state_) {
+    seed += 0x9e3779b97f4a7c15ull;
+    uint64_t z = seed;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    s = z ^ (z >> 31);
+  }
+}
+
+int RandomGenerator::Uniform(int max_value) {
+  // Lemire's multiply-and-shift method with rejection to avoid modulo bias.
+  const uint32_t range = static_cast<uint32_t>(max_value);
+  uint64_t m = (Next() >> 32) * range;
+  uint32_t low = static_cast<uint32_t>(m);
+  if (low < range) {
+    const uint32_t threshold = -range % range;
+    while (low < threshold) {
+      m = (Next() >> 32) * range;
+      low = static_cast<uint32_t>(m);
+    }
+  }
+  return static_cast<int>(m >> 32);
+}
+
+}  // namespace rules
+}  // namespace battlesnake
@@ -7,15 +7,14 @@
 namespace battlesnake {
 namespace rules {
 
-void RoyaleRuleset::CreateNextBoardState(const BoardState& prev_state,
-                                         const SnakeMovesVector& moves,
-                                         int turn, BoardState& next_state) {
-  StandardRuleset::CreateNextBoardState(prev_state, moves, turn, next_state);
+void RoyaleRuleset::resolveTurn(BoardState& state, int turn,
+                                BoundsCheck bounds_check) {
+  StandardRuleset::resolveTurn(state, turn, bounds_check);
 
-  Bounds bounds = findBounds(next_state);
-  damageInHazard(next_state);
+  Bounds bounds = findBounds(state);
+  damageInHazard(state);
   if (maybeShrinkBounds(turn, bounds)) {
-    fillHazards(bounds, next_state);
+    fillHazards(bounds, state);
   }
 }
 
@@ -44,6 +43,7 @@ RoyaleRuleset::Bounds RoyaleRuleset::findBounds(const BoardState& state) const {
 }
 
 void RoyaleRuleset::damageInHazard(BoardState& state) const {
+  bool eliminated = false;
   for (Snake& snake : state.snakes) {
     if (snake.IsEliminated()) {
       continue;
@@ -65,12 +65,17 @@ void RoyaleRuleset::damageInHazard(BoardState& state) const {
     if (snake.IsOutOfHealth()) {
       snake.health = 0;
       snake.eliminated_cause.cause = EliminatedCause::OutOfHealth;
+      eliminated = true;
     }
   }
+
+  if (eliminated) {
+    state.RebuildBodies();
+  }
 }
 
 bool RoyaleRuleset::maybeShrinkBounds(int turn,
-                                      RoyaleRuleset::Bounds& bounds) const {
+                                      RoyaleRuleset::Bounds& bounds) {
   if (turn % royale_config_.shrink_every_n_turns != 0) {
     return false;
   }
@@ -1,21 +1,21 @@
 #include "battlesnake/rules/squad_ruleset.h"
 
 #include <algorithm>
-#include <unordered_map>
-#include <unordered_set>
 
 #include "battlesnake/rules/errors.h"
 
 namespace battlesnake {
 namespace rules {
 
-void SquadRuleset::CreateNextBoardState(const BoardState& prev_state,
-                                        const SnakeMovesVector& moves, int turn,
-                                        BoardState& next_state) {
-  StandardRuleset::CreateNextBoardState(prev_state, moves, turn, next_state);
+void SquadRuleset::resolveTurn(BoardState& state, int turn,
+                               BoundsCheck bounds_check) {
+  StandardRuleset::resolveTurn(state, turn, bounds_check);
 
-  resurrectSquadBodyCollisions(next_state);
-  shareSquadAttributes(next_state);
+  resurrectSquadBodyCollisions(state);
+  shareSquadAttributes(state);
+
+  // Snakes may have been resurrected or eliminated by squad.
+  state.RebuildBodies();
 }
 
 void SquadRuleset::resurrectSquadBodyCollisions(BoardState& state) const {
@@ -23,32 +23,44 @@ void SquadRuleset::resurrectSquadBodyCollisions(BoardState& state) const {
     return;
   }
 
-  std::unordered_map<SnakeId, StringWrapper> snake_squads;
-  for (const Snake& snake : state.snakes) {
-    snake_squads[snake.id] = snake.squad;
-  }
-
   for (Snake& snake : state.snakes) {
     if (snake.eliminated_cause.cause != EliminatedCause::Collision) {
       continue;
     }
 
-    auto eliminator_squad = snake_squads.find(snake.eliminated_cause.by_id);
-    if (eliminator_squad == snake_squads.end()) {
+    const Snake* eliminator = findEliminator(state, snake.eliminated_cause);
+    if (eliminator == nullptr) {
       throw ErrorInvalidEliminatedById(snake.id.ToString(),
                                        snake.eliminated_cause.by_id.ToString());
     }
 
-    if (snake.squad != eliminator_squad->second) {
+    if (snake.squad != eliminator->squad) {
       // Legit elimination.
       continue;
     }
 
-    snake.eliminated_cause.cause = EliminatedCause::NotEliminated;
-    snake.eliminated_cause.by_id.value = nullptr;
+    snake.eliminated_cause =
+        EliminatedCause{.cause = EliminatedCause::NotEliminated};
   }
 }
 
+const Snake* SquadRuleset::findEliminator(const BoardState& state,
+                                          const EliminatedCause& cause) const {
+  // Rulesets set both the handle and the id, and ids of the same snake share
+  // the string, so this is a pointer comparison.
+  const Snake* snake = state.FindSnake(cause.by_handle);
+  if (snake != nullptr && snake->id == cause.by_id) {
+    return snake;
+  }
+
+  for (const Snake& snake : state.snakes) {
+    if (snake.id == cause.by_id) {
+      return &snake;
+    }
+  }
+  return nullptr;
+}
+
 void SquadRuleset::shareSquadAttributes(BoardState& state) const {
   if (!squad_config_.shared_elimination && !squad_config_.shared_health &&
       !squad_config_.shared_length) {
@@ -67,14 +79,14 @@ void SquadRuleset::shareSquadAttributes(BoardState& state) const {
 
       if (squad_config_.shared_length) {
         while (snake.Length() < other_snake.Length()) {
-          growSnake(snake);
+          growSnake(state, snake);
         }
       }
 
       if (squad_config_.shared_elimination) {
         if (!snake.IsEliminated() && other_snake.IsEliminated()) {
-          snake.eliminated_cause.cause = EliminatedCause::BySquad;
-          snake.eliminated_cause.by_id.value = nullptr;
+          snake.eliminated_cause =
+              EliminatedCause{.cause = EliminatedCause::BySquad};
         }
       }
     }
@@ -82,15 +94,23 @@ void SquadRuleset::shareSquadAttributes(BoardState& state) const {
 }
 
 bool SquadRuleset::IsGameOver(const BoardState& state) {
-  std::unordered_set<StringWrapper> squads_not_eliminated;
+  const Snake* first_alive = nullptr;
 
   for (const Snake& snake : state.snakes) {
-    if (!snake.IsEliminated()) {
-      squads_not_eliminated.insert(snake.squad);
+    if (snake.IsEliminated()) {
+      continue;
+    }
+    if (first_alive == nullptr) {
+      first_alive = &snake;
+      continue;
+    }
+    if (snake.squad != first_alive->squad) {
+      // At least two squads are not eliminated.
+      return false;
     }
   }
 
-  return squads_not_eliminated.size() <= 1;
+  return true;
 }
 
 }  // namespace rules
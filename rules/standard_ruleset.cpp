@@ -1,15 +1,36 @@
 #include "battlesnake/rules/standard_ruleset.h"
 
 #include <algorithm>
-#include <random>
 #include <unordered_set>
 #include <vector>
 
+#include "battlesnake/rules/board_bits_ops.h"
+#include "battlesnake/rules/board_hash.h"
 #include "battlesnake/rules/errors.h"
+#include "battlesnake/rules/sized_board_state.h"
 
 namespace battlesnake {
 namespace rules {
 
+namespace {
+
+// Bits of all cells of the board. Cells are the first width * height bits.
+template <class StateT>
+BitsOf<StateT> BoardCells(const StateT& state) {
+  BitsOf<StateT> result{};
+  const int count = state.width * state.height;
+  for (int i = 0; i < BitsOf<StateT>::kBlocksCount; ++i) {
+    const int bits = std::clamp(count - i * BoardBits::kBlockSizeBits, 0,
+                                BoardBits::kBlockSizeBits);
+    result.data[i] = bits == BoardBits::kBlockSizeBits
+                         ? ~BoardBits::BlockType{0}
+                         : (BoardBits::BlockType{1} << bits) - 1;
+  }
+  return result;
+}
+
+}  // namespace
+
 BoardState StandardRuleset::CreateInitialBoardState(
     Coordinate width, Coordinate height, std::vector<SnakeId> snake_ids) {
   BoardState initial_board_state{
@@ -24,28 +45,26 @@ BoardState StandardRuleset::CreateInitialBoardState(
         .health = config_.snake_max_health,
     });
   }
+  initial_board_state.AssignHandles();
 
   if (isKnownBoardSize(initial_board_state)) {
     placeSnakesFixed(initial_board_state);
     placeFoodFixed(initial_board_state);
   } else {
-    PointsVector unoccupied_points =
-        getEvenUnoccupiedPoints(initial_board_state);
-    placeSnakesRandomly(initial_board_state, unoccupied_points);
-    placeFoodRandomly(initial_board_state, unoccupied_points);
+    BoardBits unoccupied_cells = getEvenUnoccupiedCells(initial_board_state);
+    placeSnakesRandomly(initial_board_state, unoccupied_cells);
+    placeFoodRandomly(initial_board_state, unoccupied_cells);
   }
 
   setSnakesWrapped(initial_board_state);
+  initial_board_state.RebuildBodies();
+  initial_board_state.hash = ComputeBoardHash(initial_board_state);
 
   return initial_board_state;
 }
 
 int StandardRuleset::getRandomNumber(int max_value) {
-  std::random_device random_device;
-  std::mt19937 generator(random_device());
-  std::uniform_int_distribution<> distribution(0, max_value - 1);
-
-  return distribution(generator);
+  return random_.Uniform(max_value);
 }
 
 bool StandardRuleset::isKnownBoardSize(const BoardState& state) {
@@ -61,7 +80,7 @@ bool StandardRuleset::isKnownBoardSize(const BoardState& state) {
   return false;
 }
 
-void StandardRuleset::placeSnakesFixed(BoardState& state) const {
+void StandardRuleset::placeSnakesFixed(BoardState& state) {
   Coordinate pos_left = 1;
   Coordinate pos_mid = (state.width - 1) / 2;
   Coordinate pos_right = state.width - 2;
@@ -77,44 +96,38 @@ void StandardRuleset::placeSnakesFixed(BoardState& state) const {
     throw ErrorTooManySnakes(state.snakes.size());
   }
   // Reorder starting positions randomly.
-  std::random_shuffle(start_points.begin(), start_points.end());
+  random_.Shuffle(start_points.begin(), start_points.end());
 
   // Assign snakes in the given order.
   for (size_t i = 0; i < state.snakes.size(); ++i) {
     state.snakes[i].body = {
         .head = start_points[i],
+        .tail = start_points[i],
         .total_length = static_cast<short>(config_.snake_start_size),
         .moves_length = 0,
     };
   }
 }
 
-void StandardRuleset::placeSnakesRandomly(
-    BoardState& state, PointsVector& unoccupied_points) const {
+void StandardRuleset::placeSnakesRandomly(BoardState& state,
+                                          BoardBits& unoccupied_cells) {
+  int unoccupied_count = PopCount(unoccupied_cells);
   for (Snake& snake : state.snakes) {
-    if (unoccupied_points.empty()) {
+    if (unoccupied_count == 0) {
       throw ErrorNoRoomForSnake();
     }
 
-    int ri = getRandomNumber(unoccupied_points.size());
-    const Point& p = unoccupied_points[ri];
+    const Point p = takeRandomCell(state, unoccupied_cells, unoccupied_count);
     snake.body = {
         .head = p,
+        .tail = p,
         .total_length = static_cast<short>(config_.snake_start_size),
         .moves_length = 0,
     };
-
-    if (unoccupied_points.size() == 1) {
-      unoccupied_points.clear();
-    } else {
-      unoccupied_points[ri] =
-          std::move(unoccupied_points[unoccupied_points.size() - 1]);
-      unoccupied_points.resize(unoccupied_points.size() - 1);
-    }
   }
 }
 
-void StandardRuleset::placeFoodFixed(BoardState& state) const {
+void StandardRuleset::placeFoodFixed(BoardState& state) {
   // Place 1 food within exactly 2 moves of each snake.
   std::unordered_set<Point, PointHash> food_locations;
 
@@ -162,48 +175,56 @@ void StandardRuleset::placeFoodFixed(BoardState& state) const {
 }
 
 void StandardRuleset::placeFoodRandomly(BoardState& state,
-                                        PointsVector& unoccupied_points) const {
-  spawnFood(state, state.snakes.size(), unoccupied_points);
+                                        BoardBits& unoccupied_cells) {
+  spawnFood(state, state.snakes.size(), unoccupied_cells);
 }
 
-void StandardRuleset::maybeSpawnFood(BoardState& state) const {
+template <class StateT>
+void StandardRuleset::maybeSpawnFood(StateT& state) {
   if (config_.minimum_food == 0 && config_.food_spawn_chance == 0) {
     return;
   }
 
   int num_current_food = state.Food().Count();
   if (num_current_food < config_.minimum_food) {
-    auto unoccupied_points = getUnoccupiedPoints(state, false);
+    BitsOf<StateT> unoccupied_cells = getUnoccupiedCells(state, false);
     spawnFood(state, config_.minimum_food - num_current_food,
-              unoccupied_points);
+              unoccupied_cells);
     return;
   } else if (config_.food_spawn_chance > 0 &&
              getRandomNumber(100) < config_.food_spawn_chance) {
-    auto unoccupied_points = getUnoccupiedPoints(state, false);
-    spawnFood(state, 1, unoccupied_points);
+    BitsOf<StateT> unoccupied_cells = getUnoccupiedCells(state, false);
+    spawnFood(state, 1, unoccupied_cells);
     return;
   }
 }
 
-void StandardRuleset::spawnFood(BoardState& state, int count,
-                                PointsVector& unoccupied_points) const {
+template <class StateT>
+void StandardRuleset::spawnFood(StateT& state, int count,
+                                BitsOf<StateT>& unoccupied_cells) {
+  int unoccupied_count = PopCount(unoccupied_cells);
   for (int i = 0; i < count; ++i) {
-    if (unoccupied_points.empty()) {
+    if (unoccupied_count == 0) {
       return;
     }
-    int ri = getRandomNumber(unoccupied_points.size());
-    state.Food().Set(unoccupied_points[ri], true);
-
-    if (unoccupied_points.size() == 1) {
-      unoccupied_points.clear();
-    } else {
-      unoccupied_points[ri] =
-          std::move(unoccupied_points[unoccupied_points.size() - 1]);
-      unoccupied_points.resize(unoccupied_points.size() - 1);
-    }
+    state.Food().Set(takeRandomCell(state, unoccupied_cells, unoccupied_count),
+                     true);
   }
 }
 
+template <class StateT>
+Point StandardRuleset::takeRandomCell(const StateT& state,
+                                      BitsOf<StateT>& cells,
+                                      int& cells_count) {
+  // Cells are ranked in the same order as points of the board are listed:
+  // row by row, starting from {0, 0}.
+  const int index = SelectBit(cells, getRandomNumber(cells_count));
+  cells.Set(index, false);
+  --cells_count;
+  return Point{static_cast<Coordinate>(index % state.width),
+               static_cast<Coordinate>(index / state.width)};
+}
+
 void StandardRuleset::setSnakesWrapped(BoardState& state) const {
   if (!wrapped_mode_) {
     return;
@@ -214,71 +235,143 @@ void StandardRuleset::setSnakesWrapped(BoardState& state) const {
   }
 }
 
-PointsVector StandardRuleset::getUnoccupiedPoints(
-    BoardState& state, bool include_possible_moves,
-    const std::function<bool(const Point&)>& filter) {
-  std::unordered_set<Point, PointHash> occupied_points;
+template <class StateT>
+BitsOf<StateT> StandardRuleset::getUnoccupiedCells(
+    const StateT& state, bool include_possible_moves) {
+  BitsOf<StateT> occupied_bits = Or(state.bodies, state.food);
+  BoardBitsViewT occupied(&occupied_bits, state.width, state.height);
+  auto occupy = [&](const Point& p) {
+    // Points out of bounds can't be returned anyway.
+    if (!state.InBounds(p)) {
+      return;
+    }
+    occupied.Set(p, true);
+  };
 
-  for (const Snake& snake : state.snakes) {
-    if (snake.IsEliminated()) {
+  for (const auto& snake : state.snakes) {
+    if (snake.IsEliminated() || snake.body.empty()) {
       continue;
     }
 
-    for (const Point& p : snake.body) {
-      occupied_points.insert(p);
-    }
+    // The rest of the body is already in state bodies.
+    occupy(snake.Head());
 
-    if (include_possible_moves && snake.body.size() > 0) {
+    if (include_possible_moves) {
       const Point& head = snake.Head();
-      occupied_points.insert(head.Up());
-      occupied_points.insert(head.Down());
-      occupied_points.insert(head.Left());
-      occupied_points.insert(head.Right());
+      occupy(head.Up());
+      occupy(head.Down());
+      occupy(head.Left());
+      occupy(head.Right());
     }
   }
 
-  PointsVector unoccupied_points{};
-  BoardBitsView food = state.Food();
-  for (int y = 0; y < state.height; ++y) {
-    for (int x = 0; x < state.width; ++x) {
-      Point p{static_cast<Coordinate>(x), static_cast<Coordinate>(y)};
-      if (occupied_points.find(p) != occupied_points.end()) {
-        continue;
-      }
-      if (food.Get(p)) {
-        // Taken by food.
-        continue;
-      }
-      if (!filter(p)) {
-        continue;
+  return AndNot(BoardCells(state), occupied_bits);
+}
+
+BoardBits StandardRuleset::getEvenUnoccupiedCells(const BoardState& state) {
+  BoardBits even_cells{};
+  BoardBitsView even(&even_cells, state.width, state.height);
+  for (Coordinate y = 0; y < state.height; ++y) {
+    for (Coordinate x = 0; x < state.width; ++x) {
+      if ((x + y) % 2 == 0) {
+        even.Set(Point{x, y}, true);
       }
-      unoccupied_points.push_back(p);
     }
   }
-
-  return unoccupied_points;
-}
-
-PointsVector StandardRuleset::getEvenUnoccupiedPoints(BoardState& state) {
-  return getUnoccupiedPoints(
-      state, false, [](const Point& p) { return (p.x + p.y) % 2 == 0; });
+  return And(getUnoccupiedCells(state, false), even_cells);
 }
 
 void StandardRuleset::CreateNextBoardState(const BoardState& prev_state,
                                            const SnakeMovesVector& moves,
                                            int turn, BoardState& next_state) {
+  const JointMove joint_move = findJointMove(prev_state, moves);
   next_state = prev_state;
+  // The state may be created or modified by hand, nothing derived from it on
+  // earlier turns is trusted.
+  next_state.RebuildBodies();
+  applyTurn(next_state, joint_move, turn, BoundsCheck::WholeBodies);
+  next_state.hash = ComputeBoardHash(next_state);
+}
 
-  moveSnakes(next_state, moves);
-  reduceSnakeHealth(next_state);
-  maybeFeedSnakes(next_state);
-  maybeSpawnFood(next_state);
-  maybeEliminateSnakes(next_state);
+UndoRecord StandardRuleset::Apply(BoardState& state,
+                                  const SnakeMovesVector& moves, int turn) {
+  const JointMove joint_move = findJointMove(state, moves);
+  // Undo() restores the state exactly as it was passed.
+  UndoRecord undo = UndoRecord::Save(state);
+  try {
+    state.RebuildBodies();
+    applyTurn(state, joint_move, turn, BoundsCheck::WholeBodies);
+  } catch (...) {
+    undo.Restore(state);
+    throw;
+  }
+  state.hash = ComputeBoardHash(state);
+  return undo;
 }
 
-void StandardRuleset::moveSnakes(BoardState& state,
-                                 const SnakeMovesVector& moves) const {
-  for (Snake& snake : state.snakes) {
+void StandardRuleset::CreateNextBoardStateJoint(const BoardState& prev_state,
+                                                JointMove joint_move, int turn,
+                                                BoardState& next_state) {
+  next_state = prev_state;
+  next_state.EnsureBodies();
+  applyTurn(next_state, joint_move, turn, BoundsCheck::Heads);
+  UpdateBoardHash(prev_state, next_state);
+}
+
+UndoRecord StandardRuleset::ApplyJoint(BoardState& state, JointMove joint_move,
+                                       int turn) {
+  state.EnsureBodies();
+  UndoRecord undo = UndoRecord::Save(state);
+  try {
+    applyTurn(state, joint_move, turn, BoundsCheck::Heads);
+  } catch (...) {
+    // Leave the state as it was, like CreateNextBoardState() does.
+    undo.Restore(state);
+    throw;
+  }
+  UpdateBoardHash(undo, state);
+  return undo;
+}
+
+void StandardRuleset::Undo(BoardState& state, const UndoRecord& undo) {
+  undo.Restore(state);
+}
+
+void StandardRuleset::applyTurn(BoardState& state, JointMove joint_move,
+                                int turn, BoundsCheck bounds_check) {
+  moveAndFeedSnakes(state, joint_move);
+  resolveTurn(state, turn, bounds_check);
+}
+
+template <class StateT>
+void StandardRuleset::moveAndFeedSnakes(StateT& state,
+                                        JointMove joint_move) const {
+  if (config_.turn_pipeline == TurnPipeline::Staged) {
+    moveSnakes(state, joint_move);
+    reduceSnakeHealth(state);
+    maybeFeedSnakes(state);
+  } else {
+    stepSnakes(state, joint_move);
+  }
+}
+
+void StandardRuleset::resolveTurn(BoardState& state, int turn,
+                                  BoundsCheck bounds_check) {
+  resolveStandardTurn(state, turn, bounds_check);
+}
+
+template <class StateT>
+void StandardRuleset::resolveStandardTurn(StateT& state, int /*turn*/,
+                                          BoundsCheck bounds_check) {
+  maybeSpawnFood(state);
+  maybeEliminateSnakes(state, bounds_check);
+}
+
+JointMove StandardRuleset::findJointMove(const BoardState& state,
+                                         const SnakeMovesVector& moves) const {
+  JointMove result = 0;
+  for (int i = 0; i < state.snakes.size(); ++i) {
+    const Snake& snake = state.snakes[i];
     if (snake.IsEliminated()) {
       continue;
     }
@@ -291,8 +384,148 @@ void StandardRuleset::moveSnakes(BoardState& state,
     if (move == nullptr) {
       throw ErrorNoMoveFound(snake.id.ToString());
     }
+    SetSnakeMove(result, i, snake.body.ResolveMove(*move));
+  }
+  return result;
+}
+
+template <class StateT>
+void StandardRuleset::moveSnakes(StateT& state, JointMove joint_move) const {
+  // Cells that stop being covered by bodies and new necks. Bodies are updated
+  // after all snakes have moved, so that a tail leaving a cell never clears a
+  // neck that has just moved into the same cell.
+  using PointsPerSnake = ::theapx::trivial_loop_array<Point, kSnakesCountMax>;
+  PointsPerSnake vacated_tails{};
+  PointsPerSnake new_necks{};
 
-    snake.body.MoveTo(*move);
+  for (int i = 0; i < state.snakes.size(); ++i) {
+    SnakeOf<StateT>& snake = state.snakes[i];
+    if (snake.IsEliminated()) {
+      continue;
+    }
+
+    if (snake.body.empty()) {
+      throw ErrorZeroLengthSnake(snake.id.ToString());
+    }
+
+    Point old_head = snake.body.HeadPos();
+    Point old_tail = snake.body.TailPos();
+    snake.body.MoveTo(GetSnakeMove(joint_move, i));
+
+    if (snake.Length() < 2) {
+      // Body consists of the head only.
+      continue;
+    }
+    if (snake.body.TailPos() != old_tail) {
+      vacated_tails.push_back(old_tail);
+    }
+    new_necks.push_back(old_head);
+  }
+
+  if (bodies_may_overlap_) {
+    // A vacated cell may still be covered by another snake.
+    state.RebuildBodies();
+    return;
+  }
+
+  auto bodies = state.Bodies();
+  for (const Point& p : vacated_tails) {
+    if (state.InBounds(p)) {
+      bodies.Set(p, false);
+    }
+  }
+  for (const Point& p : new_necks) {
+    if (state.InBounds(p)) {
+      bodies.Set(p, true);
+    }
+  }
+}
+
+template <class StateT>
+void StandardRuleset::stepSnakes(StateT& state, JointMove joint_move) const {
+  SnakeStep steps[kSnakesCountMax];
+  for (int i = 0; i < state.snakes.size(); ++i) {
+    StepSnake(state, state.snakes[i], GetSnakeMove(joint_move, i), steps[i]);
+  }
+  ApplySnakeSteps(state, steps);
+}
+
+template <class StateT>
+void StandardRuleset::StepSnake(const StateT& state, SnakeOf<StateT>& snake,
+                                Move move, SnakeStep& step) const {
+  step = SnakeStep{
+      .has_vacated_tail = false,
+      .vacated_tail = {},
+      .has_neck = false,
+      .neck = {},
+      .has_eaten = false,
+      .has_stacked_head = false,
+  };
+  if (snake.IsEliminated()) {
+    return;
+  }
+
+  if (snake.body.empty()) {
+    throw ErrorZeroLengthSnake(snake.id.ToString());
+  }
+
+  Point old_head = snake.body.HeadPos();
+  Point old_tail = snake.body.TailPos();
+  snake.body.MoveTo(move);
+
+  if (snake.Length() >= 2) {
+    step.has_vacated_tail = snake.body.TailPos() != old_tail;
+    step.vacated_tail = old_tail;
+    step.has_neck = true;
+    step.neck = old_head;
+  }
+
+  snake.health--;
+
+  const Point& head = snake.Head();
+  if (!state.InBounds(head) || !state.Food().Get(head)) {
+    return;
+  }
+  step.has_eaten = true;
+  step.has_stacked_head = snake.Length() == 1;
+  snake.body.IncreaseLength();
+  snake.health = config_.snake_max_health;
+}
+
+template <class StateT>
+void StandardRuleset::ApplySnakeSteps(StateT& state,
+                                      const SnakeStep* steps) const {
+  // Bodies are updated after all snakes have moved, same as in moveSnakes().
+  auto bodies = state.Bodies();
+  if (bodies_may_overlap_) {
+    state.RebuildBodies();
+  } else {
+    for (int i = 0; i < state.snakes.size(); ++i) {
+      const SnakeStep& step = steps[i];
+      if (step.has_vacated_tail && state.InBounds(step.vacated_tail)) {
+        bodies.Set(step.vacated_tail, false);
+      }
+    }
+    for (int i = 0; i < state.snakes.size(); ++i) {
+      const SnakeStep& step = steps[i];
+      if (step.has_neck && state.InBounds(step.neck)) {
+        bodies.Set(step.neck, true);
+      }
+    }
+  }
+
+  // Several snakes may eat the same food, so it's removed after all of them.
+  auto food = state.Food();
+  for (int i = 0; i < state.snakes.size(); ++i) {
+    const SnakeStep& step = steps[i];
+    if (!step.has_eaten) {
+      continue;
+    }
+    const Point& head = state.snakes[i].Head();
+    food.Set(head, false);
+    if (step.has_stacked_head) {
+      bodies.Set(head, true);
+    }
   }
 }
 
@@ -306,8 +539,9 @@ Move const* StandardRuleset::findSnakeMove(const SnakeMovesVector& moves,
   return nullptr;
 }
 
-void StandardRuleset::reduceSnakeHealth(BoardState& state) const {
-  for (Snake& snake : state.snakes) {
+template <class StateT>
+void StandardRuleset::reduceSnakeHealth(StateT& state) const {
+  for (SnakeOf<StateT>& snake : state.snakes) {
     if (snake.IsEliminated()) {
       continue;
     }
@@ -315,19 +549,20 @@ void StandardRuleset::reduceSnakeHealth(BoardState& state) const {
   }
 }
 
-void StandardRuleset::maybeFeedSnakes(BoardState& state) const {
+template <class StateT>
+void StandardRuleset::maybeFeedSnakes(StateT& state) const {
   // for (int i = 0; i < state.food.size(); ++i) {
   //   const Point& food = state.food[i];
-  BoardBitsView all_food = state.Food();
+  auto all_food = state.Food();
   for (const Point& food : all_food) {
     bool food_has_been_eaten = false;
-    for (Snake& snake : state.snakes) {
+    for (SnakeOf<StateT>& snake : state.snakes) {
       if (snake.IsEliminated() || snake.body.size() == 0) {
         continue;
       }
       const Point& head = snake.Head();
       if (head == food) {
-        feedSnake(snake);
+        feedSnake(state, snake);
         food_has_been_eaten = true;
       }
     }
@@ -341,40 +576,54 @@ void StandardRuleset::maybeFeedSnakes(BoardState& state) const {
   }
 }
 
-void StandardRuleset::feedSnake(Snake& snake) const {
-  growSnake(snake);
+template <class StateT>
+void StandardRuleset::feedSnake(StateT& state,
+                                SnakeOf<StateT>& snake) const {
+  growSnake(state, snake);
   snake.health = config_.snake_max_health;
 }
 
-void StandardRuleset::growSnake(Snake& snake) const {
+template <class StateT>
+void StandardRuleset::growSnake(StateT& state,
+                                SnakeOf<StateT>& snake) const {
+  if (snake.Length() == 1 && !snake.IsEliminated() &&
+      state.InBounds(snake.Head())) {
+    // New piece is stacked under the head.
+    state.Bodies().Set(snake.Head(), true);
+  }
   snake.body.IncreaseLength();
 }
 
-void StandardRuleset::maybeEliminateSnakes(BoardState& state) const {
-  SnakeIndicesVector snake_indices_by_length{};
-  snake_indices_by_length.reserve(state.snakes.size());
-  for (int i = 0; i < state.snakes.size(); ++i) {
-    snake_indices_by_length.push_back(i);
+template <class StateT>
+void StandardRuleset::maybeEliminateSnakes(StateT& state,
+                                           BoundsCheck bounds_check) const {
+  using EliminatedFlags = ::theapx::trivial_loop_array<bool, kSnakesCountMax>;
+  EliminatedFlags was_eliminated{};
+  for (const SnakeOf<StateT>& snake : state.snakes) {
+    was_eliminated.push_back(snake.IsEliminated());
   }
-  std::sort(snake_indices_by_length.begin(), snake_indices_by_length.end(),
-            [&](int a, int b) -> bool {
-              int len_a = state.snakes[a].body.size();
-              int len_b = state.snakes[b].body.size();
-              return len_a > len_b;
-            });
 
   // First, iterate over all non-eliminated snakes and eliminate the ones
   // that are out of health or have moved out of bounds.
-  eliminateOutOfHealthOrBoundsSnakes(state);
+  eliminateOutOfHealthOrBoundsSnakes(state, bounds_check);
 
-  std::unordered_map<SnakeId, EliminatedCause> collision_eliminations =
-      findCollisionEliminations(state, snake_indices_by_length);
+  EliminationsVector collision_eliminations =
+      findCollisionEliminations(state);
   applyCollisionEliminations(state, collision_eliminations);
+
+  for (int i = 0; i < state.snakes.size(); ++i) {
+    if (state.snakes[i].IsEliminated() && !was_eliminated[i]) {
+      // Remove bodies of eliminated snakes from the board.
+      state.RebuildBodies();
+      break;
+    }
+  }
 }
 
+template <class StateT>
 void StandardRuleset::eliminateOutOfHealthOrBoundsSnakes(
-    BoardState& state) const {
-  for (Snake& snake : state.snakes) {
+    StateT& state, BoundsCheck bounds_check) const {
+  for (SnakeOf<StateT>& snake : state.snakes) {
     if (snake.IsEliminated()) {
       continue;
     }
@@ -388,59 +637,115 @@ void StandardRuleset::eliminateOutOfHealthOrBoundsSnakes(
       continue;
     }
 
-    if (snakeOutOfBounds(state, snake)) {
+    if (snakeOutOfBounds(state, snake, bounds_check)) {
       snake.eliminated_cause.cause = EliminatedCause::OutOfBounds;
       continue;
     }
   }
 }
 
-bool StandardRuleset::snakeOutOfBounds(const BoardState& state,
-                                       const Snake& snake) const {
+template <class StateT>
+bool StandardRuleset::snakeOutOfBounds(const StateT& state,
+                                       const SnakeOf<StateT>& snake,
+                                       BoundsCheck bounds_check) const {
+  if (bounds_check == BoundsCheck::Heads) {
+    // The rest of the body consists of previous head positions, which have
+    // already been checked on previous turns.
+    return !state.InBounds(snake.Head());
+  }
   for (const Point& p : snake.body) {
-    if (p.x < 0 || p.x >= state.width) {
-      return true;
-    }
-    if (p.y < 0 || p.y >= state.height) {
+    if (!state.InBounds(p)) {
       return true;
     }
   }
   return false;
 }
 
-std::unordered_map<SnakeId, EliminatedCause>
-StandardRuleset::findCollisionEliminations(
-    const BoardState& state,
-    const SnakeIndicesVector& snake_indices_by_length) const {
-  std::unordered_map<SnakeId, EliminatedCause> result;
-  for (const Snake& snake : state.snakes) {
+template <class StateT>
+StandardRuleset::SnakeIndicesVector StandardRuleset::sortSnakesByLength(
+    const StateT& state) {
+  SnakeIndicesVector result{};
+  result.reserve(state.snakes.size());
+  for (int i = 0; i < state.snakes.size(); ++i) {
+    result.push_back(i);
+  }
+  std::sort(result.begin(), result.end(), [&](int a, int b) -> bool {
+    int len_a = state.snakes[a].body.size();
+    int len_b = state.snakes[b].body.size();
+    return len_a > len_b;
+  });
+  return result;
+}
+
+template <class StateT>
+StandardRuleset::EliminationsVector StandardRuleset::findCollisionEliminations(
+    const StateT& state) const {
+  EliminationsVector result{};
+  result.resize(state.snakes.size());
+
+  // Snakes out of bounds are already eliminated, so all heads are on the
+  // board. A head can only collide with a body in a cell of `bodies`, and
+  // only with another head in a cell shared by several heads.
+  const auto bodies = state.Bodies();
+  BitsOf<StateT> heads{};
+  BitsOf<StateT> shared_heads{};
+  BoardBitsViewT heads_view(&heads, state.width, state.height);
+  BoardBitsViewT shared_heads_view(&shared_heads, state.width, state.height);
+  bool maybe_collided = false;
+  for (const SnakeOf<StateT>& snake : state.snakes) {
+    if (snake.IsEliminated()) {
+      continue;
+    }
+    const Point& head = snake.Head();
+    if (heads_view.Get(head)) {
+      shared_heads_view.Set(head, true);
+      maybe_collided = true;
+    }
+    heads_view.Set(head, true);
+    maybe_collided = maybe_collided || bodies.Get(head);
+  }
+  if (!maybe_collided) {
+    return result;
+  }
+
+  // Eliminations are attributed to the longest snake.
+  const SnakeIndicesVector snake_indices_by_length = sortSnakesByLength(state);
+  for (int snake_index = 0; snake_index < state.snakes.size(); ++snake_index) {
+    const SnakeOf<StateT>& snake = state.snakes[snake_index];
     if (snake.IsEliminated()) {
       continue;
     }
 
+    // Bodies of snakes eliminated on this turn are still in `bodies`, so a
+    // set bit only means the snake may have collided.
+    bool maybe_body_collided = bodies.Get(snake.Head());
+
     // Check for self-collision first.
-    if (snakeHasBodyCollided(snake, snake)) {
-      result[snake.id] = EliminatedCause{
+    if (maybe_body_collided && snakeHasBodyCollided(snake, snake)) {
+      result[snake_index] = EliminatedCause{
           .cause = EliminatedCause::SelfCollision,
+          .by_handle = static_cast<SnakeHandle>(snake_index),
           .by_id = snake.id,
       };
       continue;
     }
 
     // Check for body collisions with other snakes.
-    {
+    if (maybe_body_collided) {
       bool has_body_collided = false;
       for (int i = 0; i < snake_indices_by_length.size(); ++i) {
-        const Snake& other = state.snakes[snake_indices_by_length[i]];
-        if (other.IsEliminated()) {
+        const int other_index = snake_indices_by_length[i];
+        if (other_index == snake_index) {
           continue;
         }
-        if (snake.id == other.id) {
+        const SnakeOf<StateT>& other = state.snakes[other_index];
+        if (other.IsEliminated()) {
           continue;
         }
         if (snakeHasBodyCollided(snake, other)) {
-          result[snake.id] = EliminatedCause{
+          result[snake_index] = EliminatedCause{
               .cause = EliminatedCause::Collision,
+              .by_handle = static_cast<SnakeHandle>(other_index),
               .by_id = other.id,
           };
           has_body_collided = true;
@@ -453,39 +758,37 @@ StandardRuleset::findCollisionEliminations(
     }
 
     // Check for head-to-head.
-    {
-      bool has_head_collided = false;
+    if (shared_heads_view.Get(snake.Head())) {
       for (int i = 0; i < snake_indices_by_length.size(); ++i) {
-        const Snake& other = state.snakes[snake_indices_by_length[i]];
-        if (other.IsEliminated()) {
+        const int other_index = snake_indices_by_length[i];
+        if (other_index == snake_index) {
           continue;
         }
-        if (snake.id == other.id) {
+        const SnakeOf<StateT>& other = state.snakes[other_index];
+        if (other.IsEliminated()) {
           continue;
         }
         if (snakeHasLostHeadToHead(snake, other)) {
-          result[snake.id] = EliminatedCause{
+          result[snake_index] = EliminatedCause{
               .cause = EliminatedCause::HeadToHeadCollision,
+              .by_handle = static_cast<SnakeHandle>(other_index),
               .by_id = other.id,
           };
-          has_head_collided = true;
           break;
         }
       }
-      if (has_head_collided) {
-        continue;
-      }
     }
   }
 
   return result;
 }
 
-bool StandardRuleset::snakeHasBodyCollided(const Snake& snake,
-                                           const Snake& other) const {
+template <class SnakeT>
+bool StandardRuleset::snakeHasBodyCollided(const SnakeT& snake,
+                                           const SnakeT& other) const {
   const Point& head = snake.Head();
   // Start with other snake's neck.
-  for (SnakeBody::Piece piece = other.body.Head().Next(); piece.Valid();
+  for (auto piece = other.body.Head().Next(); piece.Valid();
        piece = piece.Next()) {
     if (piece.Pos() == head) {
       return true;
@@ -494,8 +797,9 @@ bool StandardRuleset::snakeHasBodyCollided(const Snake& snake,
   return false;
 }
 
-bool StandardRuleset::snakeHasLostHeadToHead(const Snake& snake,
-                                             const Snake& other) const {
+template <class SnakeT>
+bool StandardRuleset::snakeHasLostHeadToHead(const SnakeT& snake,
+                                             const SnakeT& other) const {
   if (snake.Head() != other.Head()) {
     return false;
   }
@@ -503,21 +807,25 @@ bool StandardRuleset::snakeHasLostHeadToHead(const Snake& snake,
   return snake.Length() <= other.Length();
 }
 
+template <class StateT>
 void StandardRuleset::applyCollisionEliminations(
-    BoardState& state,
-    const std::unordered_map<SnakeId, EliminatedCause>& eliminations) const {
-  for (Snake& snake : state.snakes) {
-    auto elimination = eliminations.find(snake.id);
-    if (elimination == eliminations.end()) {
+    StateT& state, const EliminationsVector& eliminations) const {
+  for (int i = 0; i < state.snakes.size(); ++i) {
+    if (eliminations[i].cause == EliminatedCause::NotEliminated) {
       continue;
     }
-    snake.eliminated_cause = elimination->second;
+    state.snakes[i].eliminated_cause = eliminations[i];
   }
 }
 
 bool StandardRuleset::IsGameOver(const BoardState& state) {
+  return isStandardGameOver(state);
+}
+
+template <class StateT>
+bool StandardRuleset::isStandardGameOver(const StateT& state) {
   int num_snakes_remaining = 0;
-  for (const Snake& snake : state.snakes) {
+  for (const SnakeOf<StateT>& snake : state.snakes) {
     if (!snake.IsEliminated()) {
       num_snakes_remaining++;
     }
@@ -526,5 +834,32 @@ bool StandardRuleset::IsGameOver(const BoardState& state) {
   return num_snakes_remaining <= 1;
 }
 
+// Used by derived rulesets and ChildrenExpander.
+template void StandardRuleset::StepSnake(const BoardState& state, Snake& snake,
+                                         Move move, SnakeStep& step) const;
+template void StandardRuleset::ApplySnakeSteps(BoardState& state,
+                                               const SnakeStep* steps) const;
+template void StandardRuleset::growSnake(BoardState& state,
+                                         Snake& snake) const;
+
+// Used by StandardRulesetT and ChildrenExpanderT.
+#define INSTANTIATE_SIZED_RULES(W, H, N)                                   \
+  template void StandardRuleset::StepSnake(                                \
+      const BoardStateT<W, H, N>& state,                                   \
+      SnakeOf<BoardStateT<W, H, N>>& snake, Move move, SnakeStep& step)    \
+      const;                                                               \
+  template void StandardRuleset::ApplySnakeSteps(                          \
+      BoardStateT<W, H, N>& state, const SnakeStep* steps) const;          \
+  template void StandardRuleset::moveAndFeedSnakes(                        \
+      BoardStateT<W, H, N>& state, JointMove joint_move) const;            \
+  template void StandardRuleset::resolveStandardTurn(                      \
+      BoardStateT<W, H, N>& state, int turn, BoundsCheck bounds_check);    \
+  template bool StandardRuleset::isStandardGameOver(                       \
+      const BoardStateT<W, H, N>& state);
+
+BATTLESNAKE_FOR_EACH_SIZED_BOARD(INSTANTIATE_SIZED_RULES)
+
+#undef INSTANTIATE_SIZED_RULES
+
 }  // namespace rules
 }  // namespace battlesnake
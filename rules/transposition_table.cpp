@@ -0,0 +1,165 @@
+#include "battlesnake/rules/transposition_table.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+// Layout of packed entry data, from the lowest bits:
+// value (16 bits, biased), depth (8), best move (16), bound (2), age (6).
+static constexpr int kValueShift = 0;
+static constexpr int kDepthShift = 16;
+static constexpr int kBestMoveShift = 24;
+static constexpr int kBoundShift = 40;
+static constexpr int kAgeShift = 42;
+static constexpr int kAgeMask = 63;
+
+static constexpr int kValueBias = 32768;
+static constexpr int kDepthMax = 255;
+
+// How many plies of depth one search of age is worth when choosing an entry
+// to replace.
+static constexpr int kAgeWeight = 8;
+
+}  // namespace
+
+TranspositionTable::TranspositionTable(size_t memory_budget_bytes)
+    : buckets_count_(1), age_(0), counters_{} {
+  while (buckets_count_ * 2 * kBucketSizeBytes <= memory_budget_bytes) {
+    buckets_count_ *= 2;
+  }
+  buckets_ = std::make_unique<Bucket[]>(buckets_count_);
+  Clear();
+}
+
+uint64_t TranspositionTable::pack(const Entry& entry, int age) {
+  const int value = std::clamp(entry.value, -kValueBias, kValueBias - 1);
+  const int depth = std::clamp(entry.depth, 0, kDepthMax);
+  return (static_cast<uint64_t>(value + kValueBias) << kValueShift) |
+         (static_cast<uint64_t>(depth) << kDepthShift) |
+         (static_cast<uint64_t>(entry.best_move) << kBestMoveShift) |
+         (static_cast<uint64_t>(entry.bound) << kBoundShift) |
+         (static_cast<uint64_t>(age & kAgeMask) << kAgeShift);
+}
+
+TranspositionTable::Entry TranspositionTable::unpack(uint64_t data) {
+  return Entry{
+      .value = static_cast<int>((data >> kValueShift) & 0xFFFF) - kValueBias,
+      .depth = static_cast<int>((data >> kDepthShift) & 0xFF),
+      .bound = static_cast<Bound>((data >> kBoundShift) & 3),
+      .best_move = static_cast<JointMove>((data >> kBestMoveShift) & 0xFFFF),
+  };
+}
+
+int TranspositionTable::age(uint64_t data) {
+  return static_cast<int>((data >> kAgeShift) & kAgeMask);
+}
+
+bool TranspositionTable::Probe(uint64_t hash, Entry& entry) {
+  Counters& counters = countersFor(hash);
+  counters.probes.fetch_add(1, std::memory_order_relaxed);
+
+  for (Slot& slot : bucketFor(hash).slots) {
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t key = slot.key_xor_data.load(std::memory_order_relaxed) ^ data;
+    if (data != 0 && key == hash) {
+      entry = unpack(data);
+      counters.hits.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void TranspositionTable::Store(uint64_t hash, const Entry& entry) {
+  if (entry.bound == Bound::None) {
+    return;
+  }
+
+  const int current_age = age_.load(std::memory_order_relaxed) & kAgeMask;
+  const uint64_t new_data = pack(entry, current_age);
+
+  Slot* victim = nullptr;
+  uint64_t victim_data = 0;
+  int victim_score = std::numeric_limits<int>::max();
+  for (Slot& slot : bucketFor(hash).slots) {
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t key = slot.key_xor_data.load(std::memory_order_relaxed) ^ data;
+
+    if (data != 0 && key == hash) {
+      // Same state. Keep deeper results of the current search, unless the new
+      // result is exact.
+      Entry old_entry = unpack(data);
+      if (age(data) == current_age && old_entry.depth > entry.depth &&
+          entry.bound != Bound::Exact) {
+        return;
+      }
+      victim = &slot;
+      victim_data = 0;
+      break;
+    }
+
+    // Prefer empty slots, then shallow entries of old searches.
+    int score = std::numeric_limits<int>::min();
+    if (data != 0) {
+      int relative_age = (current_age - age(data)) & kAgeMask;
+      score = unpack(data).depth - kAgeWeight * relative_age;
+    }
+    if (score < victim_score) {
+      victim = &slot;
+      victim_data = data;
+      victim_score = score;
+    }
+  }
+
+  Counters& counters = countersFor(hash);
+  counters.stores.fetch_add(1, std::memory_order_relaxed);
+  if (victim_data != 0) {
+    counters.collisions.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  victim->key_xor_data.store(hash ^ new_data, std::memory_order_relaxed);
+  victim->data.store(new_data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::NewSearch() {
+  age_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TranspositionTable::Clear() {
+  for (size_t i = 0; i < buckets_count_; ++i) {
+    for (Slot& slot : buckets_[i].slots) {
+      slot.key_xor_data.store(0, std::memory_order_relaxed);
+      slot.data.store(0, std::memory_order_relaxed);
+    }
+  }
+  age_.store(0, std::memory_order_relaxed);
+}
+
+TranspositionTable::Stats TranspositionTable::GetStats() const {
+  Stats result{};
+  for (const Counters& counters : counters_) {
+    result.probes += counters.probes.load(std::memory_order_relaxed);
+    result.hits += counters.hits.load(std::memory_order_relaxed);
+    result.stores += counters.stores.load(std::memory_order_relaxed);
+    result.collisions += counters.collisions.load(std::memory_order_relaxed);
+  }
+  result.misses = result.probes - result.hits;
+  return result;
+}
+
+void TranspositionTable::ResetStats() {
+  for (Counters& counters : counters_) {
+    counters.probes.store(0, std::memory_order_relaxed);
+    counters.hits.store(0, std::memory_order_relaxed);
+    counters.stores.store(0, std::memory_order_relaxed);
+    counters.collisions.store(0, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace rules
+}  // namespace battlesnake
@@ -659,16 +659,15 @@ WrappedRuleset::RoyaleConfig WrappedRuleset::fixRoyaleConfig(
   return result;
 }
 
-void WrappedRuleset::CreateNextBoardState(const BoardState& prev_state,
-                                          const SnakeMovesVector& moves,
-                                          int turn, BoardState& next_state) {
+void WrappedRuleset::resolveTurn(BoardState& state, int turn,
+                                 BoundsCheck bounds_check) {
   // Same as Royale, but don't calculate hazard bounds and don't even attempt to
   // shrink them by Royale rules.
-  StandardRuleset::CreateNextBoardState(prev_state, moves, turn, next_state);
-  damageInHazard(next_state);
+  StandardRuleset::resolveTurn(state, turn, bounds_check);
+  damageInHazard(state);
 
   // Apply own rules of updating hazards.
-  updateWrappedHazard(next_state, turn);
+  updateWrappedHazard(state, turn);
 }
 
 void WrappedRuleset::updateWrappedHazard(BoardState& next_state, int turn) {
@@ -0,0 +1,14 @@
+# Runs benchmarks and writes results as JSON, named after the current commit.
+# Compare two runs with compare.py from Google Benchmark tools:
+#   compare.py benchmarks bench_<old>.json bench_<new>.json
+# Extra arguments are passed to the benchmark binary, e.g.
+#   ./run_bench.sh --benchmark_filter=BoardBits --benchmark_min_time=0.05
+# A plain number of seconds for --benchmark_min_time works with every Google
+# Benchmark version, the "0.05s" form needs 1.8 or newer.
+BUILD_DIR=./build
+OUT=bench_$(git rev-parse --short HEAD).json
+
+${BUILD_DIR}/bench/battlesnake_bench \
+  --benchmark_out=${OUT} \
+  --benchmark_out_format=json \
+  "$@"
@@ -0,0 +1,47 @@
+#include <battlesnake/json/converter.h>
+#include <battlesnake/server/move_handler.h>
+
+#include <memory>
+
+namespace battlesnake {
+namespace server {
+
+using namespace ::battlesnake::interface;
+using namespace ::battlesnake::rules;
+
+void HandleMove(Battlesnake& battlesnake, const std::string& content,
+                std::function<void(const std::string& body)> respond) {
+  auto string_pool = std::make_shared<StringPool>();
+  auto game_state = ::battlesnake::json::ParseJsonGameState(
+      nlohmann::json::parse(content), *string_pool);
+
+  battlesnake.Move(
+      string_pool, game_state,
+      [respond = std::move(respond),
+       string_pool](const Battlesnake::MoveResponse& move) {
+        nlohmann::json json{{"shout", move.shout}};
+
+        switch (move.move) {
+          case Move::Up:
+            json["move"] = "up";
+            break;
+          case Move::Down:
+            json["move"] = "down";
+            break;
+          case Move::Left:
+            json["move"] = "left";
+            break;
+          case Move::Right:
+            json["move"] = "right";
+            break;
+
+          default:
+            break;
+        }
+
+        respond(json.dump());
+      });
+}
+
+}  // namespace server
+}  // namespace battlesnake
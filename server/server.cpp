@@ -1,4 +1,5 @@
 #include <battlesnake/json/converter.h>
+#include <battlesnake/server/move_handler.h>
 #include <battlesnake/server/server.h>
 
 #include <memory>
@@ -29,7 +30,6 @@ class BattlesnakeServer::BattlesnakeServerImpl {
   int port_ = 0;
   int threads_ = 0;
   Battlesnake* battlesnake_ = nullptr;
-  std::shared_ptr<battlesnake::rules::StringPool> string_pool_;
 
   void onInfo(std::shared_ptr<HttpServer::Response> response,
               std::shared_ptr<HttpServer::Request> request);
@@ -43,10 +43,7 @@ class BattlesnakeServer::BattlesnakeServerImpl {
 
 BattlesnakeServer::BattlesnakeServerImpl::BattlesnakeServerImpl(
     Battlesnake* battlesnake, int port, int threads)
-    : battlesnake_(battlesnake),
-      port_(port),
-      threads_(threads),
-      string_pool_(std::make_shared<battlesnake::rules::StringPool>()) {
+    : battlesnake_(battlesnake), port_(port), threads_(threads) {
   server_.config.port = port_;
   server_.config.thread_pool_size = threads;
 
@@ -107,9 +104,10 @@ void BattlesnakeServer::BattlesnakeServerImpl::onStart(
     std::shared_ptr<HttpServer::Request> request) {
   try {
     auto content = request->content.string();
+    auto string_pool = std::make_shared<StringPool>();
     auto game_state = battlesnake::json::ParseJsonGameState(
-        nlohmann::json::parse(content), *string_pool_);
-    battlesnake_->Start(string_pool_, game_state, [response]() {
+        nlohmann::json::parse(content), *string_pool);
+    battlesnake_->Start(string_pool, game_state, [response, string_pool]() {
       response->write("ok");
       response->send();
     });
@@ -124,9 +122,10 @@ void BattlesnakeServer::BattlesnakeServerImpl::onEnd(
     std::shared_ptr<HttpServer::Request> request) {
   try {
     auto content = request->content.string();
+    auto string_pool = std::make_shared<StringPool>();
     auto game_state = battlesnake::json::ParseJsonGameState(
-        nlohmann::json::parse(content), *string_pool_);
-    battlesnake_->End(string_pool_, game_state, [response]() {
+        nlohmann::json::parse(content), *string_pool);
+    battlesnake_->End(string_pool, game_state, [response, string_pool]() {
       response->write("ok");
       response->send();
     });
@@ -141,34 +140,10 @@ void BattlesnakeServer::BattlesnakeServerImpl::onMove(
     std::shared_ptr<HttpServer::Request> request) {
   try {
     auto content = request->content.string();
-    auto game_state = battlesnake::json::ParseJsonGameState(
-        nlohmann::json::parse(content), *string_pool_);
-
-    battlesnake_->Move(string_pool_, game_state,
-                       [response](const Battlesnake::MoveResponse& move) {
-                         nlohmann::json json{{"shout", move.shout}};
-
-                         switch (move.move) {
-                           case Move::Up:
-                             json["move"] = "up";
-                             break;
-                           case Move::Down:
-                             json["move"] = "down";
-                             break;
-                           case Move::Left:
-                             json["move"] = "left";
-                             break;
-                           case Move::Right:
-                             json["move"] = "right";
-                             break;
-
-                           default:
-                             break;
-                         }
-
-                         response->write(json.dump());
-                         response->send();
-                       });
+    HandleMove(*battlesnake_, content, [response](const std::string& body) {
+      response->write(body);
+      response->send();
+    });
   } catch (std::exception) {
     response->write(SimpleWeb::StatusCode::server_error_internal_server_error,
                     "Internal server error");
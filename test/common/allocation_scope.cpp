@@ -0,0 +1,85 @@
+#include "allocation_scope.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<int64_t> allocations_count = 0;
+std::atomic<int64_t> allocations_bytes = 0;
+thread_local int64_t thread_allocations_count = 0;
+thread_local int64_t thread_allocations_bytes = 0;
+
+void CountAllocation(std::size_t size) {
+  allocations_count.fetch_add(1, std::memory_order_relaxed);
+  allocations_bytes.fetch_add(size, std::memory_order_relaxed);
+  thread_allocations_count++;
+  thread_allocations_bytes += size;
+}
+
+void* Allocate(std::size_t size) {
+  CountAllocation(size);
+  void* result = std::malloc(size == 0 ? 1 : size);
+  if (result == nullptr) {
+    throw std::bad_alloc();
+  }
+  return result;
+}
+
+void* AllocateAligned(std::size_t size, std::align_val_t alignment) {
+  CountAllocation(size);
+  const std::size_t align = static_cast<std::size_t>(alignment);
+  // Size passed to aligned_alloc must be a multiple of the alignment.
+  const std::size_t aligned_size = (size + align - 1) / align * align;
+  void* result = std::aligned_alloc(align, aligned_size == 0 ? align
+                                                              : aligned_size);
+  if (result == nullptr) {
+    throw std::bad_alloc();
+  }
+  return result;
+}
+
+}  // namespace
+
+// Replace global allocation functions to count all heap allocations. Array
+// and nothrow versions call these by default.
+void* operator new(std::size_t size) { return Allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  return AllocateAligned(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+namespace battlesnake {
+namespace allocations {
+
+AllocationScope::AllocationScope()
+    : start_count_(allocations_count.load(std::memory_order_relaxed)),
+      start_bytes_(allocations_bytes.load(std::memory_order_relaxed)),
+      start_thread_count_(thread_allocations_count),
+      start_thread_bytes_(thread_allocations_bytes) {}
+
+int64_t AllocationScope::Count() const {
+  return allocations_count.load(std::memory_order_relaxed) - start_count_;
+}
+
+int64_t AllocationScope::Bytes() const {
+  return allocations_bytes.load(std::memory_order_relaxed) - start_bytes_;
+}
+
+int64_t AllocationScope::OtherThreadsCount() const {
+  return Count() - (thread_allocations_count - start_thread_count_);
+}
+
+int64_t AllocationScope::OtherThreadsBytes() const {
+  return Bytes() - (thread_allocations_bytes - start_thread_bytes_);
+}
+
+}  // namespace allocations
+}  // namespace battlesnake
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+namespace battlesnake {
+namespace allocations {
+
+// Counts heap allocations made while the scope is alive.
+//
+// Linking this library replaces global operator new and operator delete of
+// the whole binary with counting versions, so it's only linked into tests and
+// benchmarks. Scopes may be nested and used from several threads.
+class AllocationScope {
+ public:
+  AllocationScope();
+
+  // Allocations made by all threads since the scope was created.
+  int64_t Count() const;
+  int64_t Bytes() const;
+
+  // Allocations made by threads other than the one that created the scope,
+  // e.g. by server threads handling requests sent from this thread. Must be
+  // called on the thread that created the scope.
+  int64_t OtherThreadsCount() const;
+  int64_t OtherThreadsBytes() const;
+
+ private:
+  int64_t start_count_;
+  int64_t start_bytes_;
+  int64_t start_thread_count_;
+  int64_t start_thread_bytes_;
+};
+
+}  // namespace allocations
+}  // namespace battlesnake
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "battlesnake/rules/constrictor_ruleset.h"
+#include "battlesnake/rules/data_types.h"
+#include "battlesnake/rules/royale_ruleset.h"
+#include "battlesnake/rules/solo_ruleset.h"
+#include "battlesnake/rules/squad_ruleset.h"
+#include "battlesnake/rules/standard_ruleset.h"
+#include "battlesnake/rules/wrapped_ruleset.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace battlesnake {
+namespace rules {
+
+// Helpers for tests that play the same games in different ways, e.g. with
+// different entry points or turn pipelines, and compare the results.
+
+inline std::vector<Point> BodyPoints(const SnakeBody& body) {
+  std::vector<Point> result;
+  for (const Point& p : body) {
+    result.push_back(p);
+  }
+  return result;
+}
+
+// Expects states to be the same, including data derived by rulesets: bodies
+// bitboard, hash and layout of snake bodies.
+inline void ExpectSameState(const BoardState& actual,
+                            const BoardState& expected) {
+  EXPECT_THAT(actual.width, ::testing::Eq(expected.width));
+  EXPECT_THAT(actual.height, ::testing::Eq(expected.height));
+  ASSERT_THAT(actual.snakes.size(), ::testing::Eq(expected.snakes.size()));
+  for (int i = 0; i < actual.snakes.size(); ++i) {
+    const Snake& a = actual.snakes[i];
+    const Snake& e = expected.snakes[i];
+    EXPECT_THAT(a.id, ::testing::Eq(e.id)) << "snake " << i;
+    EXPECT_THAT(a.squad, ::testing::Eq(e.squad)) << "snake " << i;
+    EXPECT_THAT(a.body, ::testing::Eq(e.body)) << "snake " << i;
+    EXPECT_THAT(BodyPoints(a.body), ::testing::Eq(BodyPoints(e.body)))
+        << "snake " << i;
+    EXPECT_THAT(a.body.TailPos(), ::testing::Eq(e.body.TailPos()))
+        << "snake " << i;
+    EXPECT_THAT(a.health, ::testing::Eq(e.health)) << "snake " << i;
+    EXPECT_THAT(a.eliminated_cause.cause,
+                ::testing::Eq(e.eliminated_cause.cause))
+        << "snake " << i;
+    EXPECT_THAT(a.eliminated_cause.by_id,
+                ::testing::Eq(e.eliminated_cause.by_id))
+        << "snake " << i;
+    EXPECT_THAT(a.eliminated_cause.by_handle,
+                ::testing::Eq(e.eliminated_cause.by_handle))
+        << "snake " << i;
+  }
+  EXPECT_THAT(actual.food == expected.food, ::testing::IsTrue());
+  EXPECT_THAT(actual.hazard == expected.hazard, ::testing::IsTrue());
+  EXPECT_THAT(actual.bodies == expected.bodies, ::testing::IsTrue());
+  EXPECT_THAT(actual.hash, ::testing::Eq(expected.hash));
+}
+
+// Parameter of tests that run on several rulesets.
+struct RulesetFactory {
+  const char* name;
+  std::function<std::unique_ptr<StandardRuleset>(
+      const StandardRuleset::Config& config)>
+      create;
+};
+
+inline void PrintTo(const RulesetFactory& factory, std::ostream* os) {
+  *os << factory.name;
+}
+
+// Name generator for INSTANTIATE_TEST_SUITE_P().
+inline std::string RulesetFactoryName(
+    const ::testing::TestParamInfo<RulesetFactory>& info) {
+  return info.param.name;
+}
+
+// StandardRuleset and all rulesets derived from it.
+inline std::vector<RulesetFactory> AllRulesets() {
+  return {
+      RulesetFactory{"standard",
+                     [](const StandardRuleset::Config& config) {
+                       return std::make_unique<StandardRuleset>(config);
+                     }},
+      RulesetFactory{"solo",
+                     [](const StandardRuleset::Config& config) {
+                       return std::make_unique<SoloRuleset>(config);
+                     }},
+      RulesetFactory{"royale",
+                     [](const StandardRuleset::Config& config) {
+                       return std::make_unique<RoyaleRuleset>(config);
+                     }},
+      RulesetFactory{"wrapped",
+                     [](const StandardRuleset::Config& config) {
+                       return std::make_unique<WrappedRuleset>(config);
+                     }},
+      RulesetFactory{"squad",
+                     [](const StandardRuleset::Config& config) {
+                       return std::make_unique<SquadRuleset>(config);
+                     }},
+      RulesetFactory{"constrictor",
+                     [](const StandardRuleset::Config& config) {
+                       return std::make_unique<ConstrictorRuleset>(config);
+                     }},
+  };
+}
+
+}  // namespace rules
+}  // namespace battlesnake
@@ -39,7 +39,7 @@ TEST_F(CreateJsonTest, NotEliminatedSnake) {
       }),
       .health = 75,
       .name = pool.Add("Test Caterpillar"),
-      .latency = pool.Add("123"),
+      .latency = 123,
       .shout = pool.Add("Why are we shouting???"),
       .squad = pool.Add("The Suicide Squad"),
   };
@@ -364,7 +364,7 @@ TEST_F(CreateJsonTest, BoardStateSnakes) {
               }),
               .health = 75,
               .name = pool.Add("Test Caterpillar"),
-              .latency = pool.Add("123"),
+              .latency = 123,
               .shout = pool.Add("Why are we shouting???"),
               .squad = pool.Add("The Suicide Squad"),
           },
@@ -420,7 +420,7 @@ TEST_F(CreateJsonTest, BoardStateEliminatedSnake) {
                       .cause = EliminatedCause::HeadToHeadCollision,
                   },
               .name = pool.Add("Test Caterpillar"),
-              .latency = pool.Add("123"),
+              .latency = 123,
               .shout = pool.Add("Why are we shouting???"),
               .squad = pool.Add("The Suicide Squad"),
           },
@@ -588,7 +588,7 @@ TEST_F(CreateJsonTest, GameState) {
           }),
           .health = 75,
           .name = pool.Add("Test Caterpillar"),
-          .latency = pool.Add("123"),
+          .latency = 123,
           .shout = pool.Add("Why are we shouting???"),
           .squad = pool.Add("The Suicide Squad"),
       },
@@ -677,7 +677,7 @@ TEST_F(CreateJsonTest, GameStateYouEliminated) {
           .health = 75,
           .eliminated_cause{.cause = EliminatedCause::Collision},
           .name = pool.Add("Test Caterpillar"),
-          .latency = pool.Add("123"),
+          .latency = 123,
           .shout = pool.Add("Why are we shouting???"),
           .squad = pool.Add("The Suicide Squad"),
       },
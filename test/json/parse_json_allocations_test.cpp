@@ -0,0 +1,78 @@
+#include <string>
+#include <vector>
+
+#include "allocation_scope.h"
+#include "battlesnake/json/converter.h"
+#include "battlesnake/rules/standard_ruleset.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace battlesnake {
+namespace json {
+
+namespace {
+
+using ::battlesnake::allocations::AllocationScope;
+using ::testing::Eq;
+using ::testing::Le;
+
+using namespace ::battlesnake::rules;
+
+// Budgets of heap allocations for parsing the game state below, with a little
+// headroom for differences between standard libraries. Lower them when
+// allocations are removed.
+constexpr int kParseNewStringsBudget = 58;
+constexpr int kParsePooledStringsBudget = 12;
+
+// Game state with 4 snakes on a medium board, as sent to the first snake.
+nlohmann::json CreateGameStateJson() {
+  StringPool pool;
+  StandardRuleset ruleset(StandardRuleset::Config{.random_seed = 1});
+  std::vector<SnakeId> ids;
+  for (int i = 0; i < 4; ++i) {
+    ids.push_back(pool.Add("snake-id-" + std::to_string(i)));
+  }
+  BoardState state =
+      ruleset.CreateInitialBoardState(kBoardSizeMedium, kBoardSizeMedium, ids);
+  for (Snake& snake : state.snakes) {
+    snake.name = pool.Add("Snake name " + snake.id.ToString());
+    snake.latency = 123;
+    snake.shout = pool.Add("Shouting something long enough");
+  }
+
+  return CreateJson(GameState{
+      .game{
+          .id = pool.Add("totally-unique-game-id"),
+          .ruleset{.name = pool.Add("standard"), .version = pool.Add("v1.2.3")},
+          .timeout = 500,
+      },
+      .turn = 10,
+      .board = state,
+      .you = state.snakes[0],
+  });
+}
+
+TEST(ParseJsonAllocationsTest, GameState) {
+  const nlohmann::json json = CreateGameStateJson();
+  StringPool pool;
+
+  {
+    // All strings are added to the pool.
+    AllocationScope scope;
+    GameState game_state = ParseJsonGameState(json, pool);
+    EXPECT_THAT(scope.Count(), Le(kParseNewStringsBudget));
+    EXPECT_THAT(game_state.board.snakes.size(), Eq(4));
+  }
+  {
+    // Strings of the same game are in the pool already.
+    AllocationScope scope;
+    GameState game_state = ParseJsonGameState(json, pool);
+    EXPECT_THAT(scope.Count(), Le(kParsePooledStringsBudget));
+    EXPECT_THAT(game_state.board.snakes.size(), Eq(4));
+  }
+}
+
+}  // namespace
+
+}  // namespace json
+}  // namespace battlesnake
@@ -84,7 +84,7 @@ TEST_F(ParseJsonTest, SnakeSucceeds) {
       }),
       .health = 75,
       .name = pool.Add("Test Caterpillar"),
-      .latency = pool.Add("123"),
+      .latency = 123,
       .shout = pool.Add("Why are we shouting???"),
       .squad = pool.Add("The Suicide Squad"),
   };
@@ -143,7 +143,7 @@ TEST_F(ParseJsonTest, SnakeWrappedSucceeds) {
           &wrapped_board_size),
       .health = 75,
       .name = pool.Add("Test Caterpillar"),
-      .latency = pool.Add("123"),
+      .latency = 123,
       .shout = pool.Add("Why are we shouting???"),
       .squad = pool.Add("The Suicide Squad"),
   };
@@ -187,7 +187,7 @@ TEST_F(ParseJsonTest, SnakeNoOptional) {
           Point{10, 3},
       }),
       .health = 75,
-      .latency = pool.Add("0"),
+      .latency = 0,
   };
 
   Snake snake = ParseJsonSnake(json, pool);
@@ -205,6 +205,57 @@ TEST_F(ParseJsonTest, SnakeNoOptional) {
   EXPECT_THAT(snake.squad, Eq(expected_snake.squad));
 }
 
+TEST_F(ParseJsonTest, SnakeLatency) {
+  auto json = nlohmann::json::parse(R"json(
+      {
+          "id": "snake_id",
+          "body": [
+              {"x": 10, "y": 1},
+              {"x": 10, "y": 2}
+          ],
+          "head": {"x": 10, "y": 1},
+          "health": 75
+      }
+  )json");
+  StringPool pool;
+
+  json["latency"] = "37";
+  EXPECT_THAT(ParseJsonSnake(json, pool).latency, Eq(37));
+  json["latency"] = 42;
+  EXPECT_THAT(ParseJsonSnake(json, pool).latency, Eq(42));
+  json["latency"] = "";
+  EXPECT_THAT(ParseJsonSnake(json, pool).latency, Eq(0));
+}
+
+// Latency is informational, malformed values don't reject the snake.
+TEST_F(ParseJsonTest, SnakeMalformedLatency) {
+  auto json = nlohmann::json::parse(R"json(
+      {
+          "id": "snake_id",
+          "body": [
+              {"x": 10, "y": 1},
+              {"x": 10, "y": 2}
+          ],
+          "head": {"x": 10, "y": 1},
+          "health": 75
+      }
+  )json");
+  StringPool pool;
+
+  json["latency"] = "12ms";
+  EXPECT_THAT(ParseJsonSnake(json, pool).latency, Eq(0));
+  json["latency"] = "timeout";
+  EXPECT_THAT(ParseJsonSnake(json, pool).latency, Eq(0));
+  json["latency"] = 12.5;
+  EXPECT_THAT(ParseJsonSnake(json, pool).latency, Eq(0));
+  json["latency"] = int64_t{1} << 40;
+  EXPECT_THAT(ParseJsonSnake(json, pool).latency, Eq(0));
+  json["latency"] = true;
+  EXPECT_THAT(ParseJsonSnake(json, pool).latency, Eq(0));
+  json["latency"] = nullptr;
+  EXPECT_THAT(ParseJsonSnake(json, pool).latency, Eq(0));
+}
+
 TEST_F(ParseJsonTest, SnakeNoId) {
   auto json = nlohmann::json::parse(R"json(
       {
@@ -480,6 +531,7 @@ TEST_F(ParseJsonTest, BoardStateSnakes) {
               ElementsAreArray(BoardBitsVector(expected_state.Food())));
   EXPECT_THAT(state.snakes,
               ElementsAre(AllOf(Field(&Snake::id, "snake_id"),
+                                Field(&Snake::handle, 0),
                                 Field(&Snake::body, ElementsAreArray({
                                                         Point{2, 0},
                                                         Point{1, 0},
@@ -719,7 +771,7 @@ TEST_F(ParseJsonTest, GameStateSucceeds) {
           }),
           .health = 75,
           .name = pool.Add("Test Caterpillar"),
-          .latency = pool.Add("123"),
+          .latency = 123,
           .shout = pool.Add("Why are we shouting???"),
           .squad = pool.Add("The Suicide Squad"),
       },
@@ -732,6 +784,50 @@ TEST_F(ParseJsonTest, GameStateSucceeds) {
   EXPECT_THAT(result.turn, Eq(expected_result.turn));
   EXPECT_THAT(result.board.width, Eq(expected_result.board.width));
   EXPECT_THAT(result.you.id, Eq(expected_result.you.id));
+  // Not on the board.
+  EXPECT_THAT(result.you.handle, Eq(kInvalidSnakeHandle));
+}
+
+TEST_F(ParseJsonTest, GameStateYouHandle) {
+  auto json = nlohmann::json::parse(R"json({
+        "game": {
+            "id": "totally-unique-game-id",
+            "ruleset": {"name": "standard", "version": "v1.2.3"},
+            "timeout": 500
+        },
+        "turn": 1,
+        "board": {
+            "width": 11,
+            "height": 11,
+            "food": [],
+            "snakes": [{
+                "id": "other_id",
+                "body": [{"x": 1, "y": 1}],
+                "head": {"x": 1, "y": 1},
+                "health": 100
+            }, {
+                "id": "snake_id",
+                "body": [{"x": 5, "y": 5}],
+                "head": {"x": 5, "y": 5},
+                "health": 100
+            }],
+            "hazards": []
+        },
+        "you": {
+            "id": "snake_id",
+            "body": [{"x": 5, "y": 5}],
+            "head": {"x": 5, "y": 5},
+            "health": 100
+        }
+  })json");
+
+  StringPool pool;
+  GameState result = ParseJsonGameState(json, pool);
+
+  ASSERT_THAT(result.board.snakes.size(), Eq(2));
+  EXPECT_THAT(result.board.snakes[0].handle, Eq(0));
+  EXPECT_THAT(result.board.snakes[1].handle, Eq(1));
+  EXPECT_THAT(result.you.handle, Eq(1));
 }
 
 TEST_F(ParseJsonTest, GameStateNoYou) {
@@ -837,7 +933,7 @@ TEST_F(ParseJsonTest, GameStateSoloWrapping) {
       }),
       .health = 75,
       .name = pool.Add("Test Caterpillar"),
-      .latency = pool.Add("123"),
+      .latency = 123,
       .shout = pool.Add("Why are we shouting???"),
       .squad = pool.Add("The Suicide Squad"),
   };
@@ -933,7 +1029,7 @@ TEST_F(ParseJsonTest, GameStateWrapped) {
       }),
       .health = 75,
       .name = pool.Add("Test Caterpillar"),
-      .latency = pool.Add("123"),
+      .latency = 123,
       .shout = pool.Add("Why are we shouting???"),
       .squad = pool.Add("The Suicide Squad"),
   };
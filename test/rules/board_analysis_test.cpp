@@ -0,0 +1,655 @@
+#include "battlesnake/rules/board_analysis.h"
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "battlesnake/rules/random.h"
+#include "battlesnake/rules/royale_ruleset.h"
+#include "battlesnake/rules/standard_ruleset.h"
+#include "battlesnake/rules/wrapped_ruleset.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::Gt;
+using ::testing::IsFalse;
+using ::testing::IsTrue;
+using ::testing::SizeIs;
+using ::testing::UnorderedElementsAre;
+
+// Plain point by point BFS. Returns distance to every cell, or -1 for cells
+// that are not reachable.
+std::vector<int> ReferenceDistances(Point start, const BoardBits& obstacles,
+                                    int width, int height, bool wrapped) {
+  Point board_size{static_cast<Coordinate>(width),
+                   static_cast<Coordinate>(height)};
+  BoardBitsViewConst obstacles_view(&obstacles, width, height);
+  std::vector<int> distances(width * height, -1);
+  std::deque<Point> queue{start};
+  distances[start.y * width + start.x] = 0;
+  while (!queue.empty()) {
+    Point p = queue.front();
+    queue.pop_front();
+    for (Move move : {Move::Up, Move::Down, Move::Left, Move::Right}) {
+      Point next = p.Moved(move, wrapped ? &board_size : nullptr);
+      if (next.x < 0 || next.y < 0 || next.x >= width || next.y >= height) {
+        continue;
+      }
+      int index = next.y * width + next.x;
+      if (distances[index] >= 0 || obstacles_view.Get(next)) {
+        continue;
+      }
+      distances[index] = distances[p.y * width + p.x] + 1;
+      queue.push_back(next);
+    }
+  }
+  return distances;
+}
+
+// Point by point version of ComputeTerritory.
+void ReferenceTerritory(const BoardState& state, bool wrapped,
+                        std::vector<int>& owner, std::vector<int>& distance) {
+  const int width = state.width;
+  const int height = state.height;
+  Point board_size{state.width, state.height};
+  BoardBits obstacles = Obstacles(state);
+  owner.assign(width * height, Territory::kNoOwner);
+  distance.assign(width * height, Territory::kUnreachable);
+  std::vector<bool> claimed(width * height, false);
+
+  std::vector<std::vector<Point>> frontier(state.snakes.size());
+  for (int i = 0; i < state.snakes.size(); ++i) {
+    if (!state.snakes[i].IsEliminated()) {
+      frontier[i].push_back(state.snakes[i].Head());
+    }
+  }
+
+  for (int d = 0;; ++d) {
+    // Snakes wanting each cell.
+    std::vector<std::vector<int>> wanted(width * height);
+    for (int i = 0; i < frontier.size(); ++i) {
+      for (Point p : frontier[i]) {
+        int index = p.y * width + p.x;
+        // Frontier may have duplicates, points of one snake are adjacent.
+        if (!claimed[index] &&
+            (wanted[index].empty() || wanted[index].back() != i)) {
+          wanted[index].push_back(i);
+        }
+      }
+    }
+
+    std::vector<std::vector<Point>> owned(frontier.size());
+    bool any = false;
+    for (int index = 0; index < width * height; ++index) {
+      if (wanted[index].empty()) {
+        continue;
+      }
+      claimed[index] = true;
+      distance[index] = d;
+      size_t max_length = 0;
+      int winners = 0;
+      int winner = -1;
+      for (int i : wanted[index]) {
+        size_t length = state.snakes[i].Length();
+        if (length > max_length) {
+          max_length = length;
+          winners = 1;
+          winner = i;
+        } else if (length == max_length) {
+          winners++;
+        }
+      }
+      if (winners == 1) {
+        owner[index] = winner;
+        owned[winner].push_back(Point{static_cast<Coordinate>(index % width),
+                                      static_cast<Coordinate>(index / width)});
+        any = true;
+      }
+    }
+    if (!any) {
+      break;
+    }
+
+    for (int i = 0; i < frontier.size(); ++i) {
+      frontier[i].clear();
+      for (Point p : owned[i]) {
+        for (Move move : {Move::Up, Move::Down, Move::Left, Move::Right}) {
+          Point next = p.Moved(move, wrapped ? &board_size : nullptr);
+          if (!state.InBounds(next) ||
+              obstacles.Get(next.y * width + next.x)) {
+            continue;
+          }
+          frontier[i].push_back(next);
+        }
+      }
+    }
+  }
+}
+
+TEST(FloodFillTest, EmptyBoard) {
+  BoardBitsShifter shifter(kBoardSizeMedium, kBoardSizeMedium);
+  BoardBits start = CreateBoardBits({Point{0, 0}}, kBoardSizeMedium,
+                                    kBoardSizeMedium);
+
+  FloodFillResult result = FloodFill(start, BoardBits{}, shifter);
+
+  EXPECT_THAT(result.area, Eq(kBoardSizeMedium * kBoardSizeMedium - 1));
+  EXPECT_THAT(result.steps, Eq(2 * (kBoardSizeMedium - 1)));
+  EXPECT_THAT(result.reached, Eq(shifter.BoardMask()));
+}
+
+TEST(FloodFillTest, EmptyBoardWrapped) {
+  BoardBitsShifter shifter(kBoardSizeMedium, kBoardSizeMedium, true);
+  BoardBits start = CreateBoardBits({Point{0, 0}}, kBoardSizeMedium,
+                                    kBoardSizeMedium);
+
+  FloodFillResult result = FloodFill(start, BoardBits{}, shifter);
+
+  EXPECT_THAT(result.area, Eq(kBoardSizeMedium * kBoardSizeMedium - 1));
+  EXPECT_THAT(result.steps, Eq(kBoardSizeMedium - 1));
+}
+
+TEST(FloodFillTest, WallSplitsBoard) {
+  // Vertical wall at x = 2 on 5x5 board.
+  BoardBits wall = CreateBoardBits(
+      {Point{2, 0}, Point{2, 1}, Point{2, 2}, Point{2, 3}, Point{2, 4}}, 5, 5);
+  BoardBits start = CreateBoardBits({Point{0, 0}}, 5, 5);
+
+  FloodFillResult result = FloodFill(start, wall, BoardBitsShifter(5, 5));
+  EXPECT_THAT(result.area, Eq(9));
+
+  // Wrapped board has only one wall, so the other side is reachable.
+  FloodFillResult wrapped_result =
+      FloodFill(start, wall, BoardBitsShifter(5, 5, true));
+  EXPECT_THAT(wrapped_result.area, Eq(19));
+}
+
+TEST(FloodFillTest, Layers) {
+  BoardBits start = CreateBoardBits({Point{0, 0}}, 3, 3);
+  BoardBits obstacles = CreateBoardBits({Point{1, 1}}, 3, 3);
+  std::vector<BoardBits> layers;
+
+  FloodFillResult result =
+      FloodFill(start, obstacles, BoardBitsShifter(3, 3), -1, &layers);
+
+  EXPECT_THAT(result.area, Eq(7));
+  EXPECT_THAT(result.steps, Eq(4));
+  ASSERT_THAT(layers, SizeIs(5));
+  EXPECT_THAT(BoardBitsViewConst(&layers[0], 3, 3), ElementsAre(Point{0, 0}));
+  EXPECT_THAT(BoardBitsViewConst(&layers[1], 3, 3),
+              UnorderedElementsAre(Point{1, 0}, Point{0, 1}));
+  EXPECT_THAT(BoardBitsViewConst(&layers[2], 3, 3),
+              UnorderedElementsAre(Point{2, 0}, Point{0, 2}));
+  EXPECT_THAT(BoardBitsViewConst(&layers[3], 3, 3),
+              UnorderedElementsAre(Point{2, 1}, Point{1, 2}));
+  EXPECT_THAT(BoardBitsViewConst(&layers[4], 3, 3), ElementsAre(Point{2, 2}));
+}
+
+TEST(FloodFillTest, MaxSteps) {
+  BoardBitsShifter shifter(kBoardSizeMedium, kBoardSizeMedium);
+  BoardBits start =
+      CreateBoardBits({Point{5, 5}}, kBoardSizeMedium, kBoardSizeMedium);
+
+  FloodFillResult result = FloodFill(start, BoardBits{}, shifter, 2);
+
+  EXPECT_THAT(result.steps, Eq(2));
+  EXPECT_THAT(result.area, Eq(4 + 8));
+}
+
+TEST(FloodFillTest, StartIsObstacle) {
+  BoardBits start = CreateBoardBits({Point{0, 0}}, 3, 3);
+
+  FloodFillResult result = FloodFill(start, start, BoardBitsShifter(3, 3));
+
+  EXPECT_THAT(result.area, Eq(8));
+}
+
+TEST(FloodFillTest, MatchesReferenceBfs) {
+  RandomGenerator random(42);
+
+  for (bool wrapped : {false, true}) {
+    for (int iteration = 0; iteration < 50; ++iteration) {
+      int width = 3 + random.Uniform(kBoardSizeMax - 2);
+      int height = 3 + random.Uniform(kBoardSizeMax - 2);
+      BoardBitsShifter shifter(width, height, wrapped);
+
+      BoardBits obstacles{};
+      for (int i = 0; i < width * height; ++i) {
+        obstacles.Set(i, random.Uniform(3) == 0);
+      }
+      Point start{static_cast<Coordinate>(random.Uniform(width)),
+                  static_cast<Coordinate>(random.Uniform(height))};
+      BoardBits start_bits = CreateBoardBits({start}, width, height);
+
+      std::vector<BoardBits> layers;
+      FloodFillResult result =
+          FloodFill(start_bits, obstacles, shifter, -1, &layers);
+
+      std::vector<int> expected =
+          ReferenceDistances(start, obstacles, width, height, wrapped);
+      int expected_area = -1;
+      int expected_steps = 0;
+      for (int i = 0; i < width * height; ++i) {
+        int distance = expected[i];
+        if (distance < 0) {
+          EXPECT_FALSE(result.reached.Get(i));
+          continue;
+        }
+        expected_area++;
+        expected_steps = std::max(expected_steps, distance);
+        ASSERT_THAT(layers.size(), Gt(distance));
+        EXPECT_TRUE(layers[distance].Get(i));
+      }
+      EXPECT_THAT(result.area, Eq(expected_area));
+      EXPECT_THAT(result.steps, Eq(expected_steps));
+    }
+  }
+}
+
+TEST(ReachableAreaTest, OtherSnakesAreObstacles) {
+  StringPool pool;
+  BoardState state{
+      .width = 5,
+      .height = 5,
+      .snakes = SnakesVector::Create({
+          Snake{
+              .id = pool.Add("one"),
+              .body = SnakeBody::Create({{0, 0}, {0, 1}}),
+          },
+          // Walls off the right part of the board.
+          Snake{
+              .id = pool.Add("two"),
+              .body = SnakeBody::Create(
+                  {{2, 4}, {2, 3}, {2, 2}, {2, 1}, {2, 0}}),
+          },
+      }),
+  };
+  state.RebuildBodies();
+
+  BoardBitsShifter shifter(5, 5);
+  EXPECT_THAT(ReachableArea(state, 0, shifter).area, Eq(8));
+
+  state.hazard = CreateBoardBits({Point{1, 4}}, 5, 5);
+  EXPECT_THAT(ReachableArea(state, 0, shifter, true).area, Eq(7));
+
+  state.snakes[1].eliminated_cause.cause = EliminatedCause::Collision;
+  state.RebuildBodies();
+  EXPECT_THAT(ReachableArea(state, 0, shifter).area, Eq(23));
+}
+
+TEST(TerritoryTest, EqualLengthTie) {
+  StringPool pool;
+  BoardState state{
+      .width = 5,
+      .height = 1,
+      .snakes = SnakesVector::Create({
+          Snake{.id = pool.Add("one"), .body = SnakeBody::Create({{0, 0}})},
+          Snake{.id = pool.Add("two"), .body = SnakeBody::Create({{4, 0}})},
+      }),
+  };
+
+  Territory territory = ComputeTerritory(state, BoardBitsShifter(5, 1));
+
+  EXPECT_THAT(territory.Owner(Point{0, 0}), Eq(0));
+  EXPECT_THAT(territory.Owner(Point{1, 0}), Eq(0));
+  EXPECT_THAT(territory.Owner(Point{2, 0}), Eq(Territory::kNoOwner));
+  EXPECT_THAT(territory.Owner(Point{3, 0}), Eq(1));
+  EXPECT_THAT(territory.Owner(Point{4, 0}), Eq(1));
+  EXPECT_THAT(territory.Distance(Point{1, 0}), Eq(1));
+  EXPECT_THAT(territory.Distance(Point{2, 0}), Eq(2));
+  EXPECT_THAT(BoardBitsViewConst(&territory.neutral, 5, 1),
+              ElementsAre(Point{2, 0}));
+  EXPECT_THAT(territory.area[0], Eq(2));
+  EXPECT_THAT(territory.area[1], Eq(2));
+}
+
+TEST(TerritoryTest, LongerSnakeWinsTie) {
+  StringPool pool;
+  BoardState state{
+      .width = 5,
+      .height = 1,
+      .snakes = SnakesVector::Create({
+          Snake{.id = pool.Add("one"), .body = SnakeBody::Create({{0, 0}})},
+          Snake{.id = pool.Add("two"),
+                .body = SnakeBody::Create({{4, 0}, {4, 0}})},
+      }),
+  };
+
+  Territory territory = ComputeTerritory(state, BoardBitsShifter(5, 1));
+
+  EXPECT_THAT(territory.Owner(Point{2, 0}), Eq(1));
+  EXPECT_THAT(territory.Distance(Point{2, 0}), Eq(2));
+  EXPECT_THAT(IsEmpty(territory.neutral), IsTrue());
+  EXPECT_THAT(territory.area[0], Eq(2));
+  EXPECT_THAT(territory.area[1], Eq(3));
+}
+
+TEST(TerritoryTest, EliminatedSnakesAreIgnored) {
+  StringPool pool;
+  BoardState state{
+      .width = 5,
+      .height = 1,
+      .snakes = SnakesVector::Create({
+          Snake{.id = pool.Add("one"), .body = SnakeBody::Create({{0, 0}})},
+          Snake{.id = pool.Add("two"),
+                .body = SnakeBody::Create({{4, 0}}),
+                .eliminated_cause = {.cause = EliminatedCause::Collision}},
+      }),
+  };
+
+  Territory territory = ComputeTerritory(state, BoardBitsShifter(5, 1));
+
+  EXPECT_THAT(territory.area[0], Eq(5));
+  EXPECT_THAT(territory.area[1], Eq(0));
+  EXPECT_THAT(territory.Distance(Point{4, 0}), Eq(4));
+}
+
+class TerritoryRandomGamesTest : public testing::TestWithParam<bool> {};
+
+TEST_P(TerritoryRandomGamesTest, MatchesReference) {
+  const bool wrapped = GetParam();
+  StringPool pool;
+  std::vector<SnakeId> ids{pool.Add("a"), pool.Add("b"), pool.Add("c"),
+                           pool.Add("d")};
+  RandomGenerator moves_generator(7);
+  BoardBitsShifter shifter(kBoardSizeMedium, kBoardSizeMedium, wrapped);
+
+  for (int game = 0; game < 10; ++game) {
+    std::unique_ptr<StandardRuleset> ruleset;
+    if (wrapped) {
+      ruleset = std::make_unique<WrappedRuleset>();
+    } else {
+      ruleset = std::make_unique<StandardRuleset>();
+    }
+    ruleset->SetRandomSeed(game + 1);
+    BoardState state = ruleset->CreateInitialBoardState(
+        kBoardSizeMedium, kBoardSizeMedium, ids);
+
+    for (int turn = 1; turn < 100 && !ruleset->IsGameOver(state); ++turn) {
+      Territory territory = ComputeTerritory(state, shifter);
+      std::vector<int> expected_owner;
+      std::vector<int> expected_distance;
+      ReferenceTerritory(state, wrapped, expected_owner, expected_distance);
+
+      for (int index = 0; index < kBoardSizeMedium * kBoardSizeMedium;
+           ++index) {
+        ASSERT_THAT(territory.owner[index], Eq(expected_owner[index]))
+            << "game " << game << " turn " << turn << " index " << index;
+        ASSERT_THAT(territory.distance[index], Eq(expected_distance[index]))
+            << "game " << game << " turn " << turn << " index " << index;
+        if (expected_owner[index] >= 0) {
+          ASSERT_TRUE(territory.cells[expected_owner[index]].Get(index));
+        }
+      }
+
+      SnakeMovesVector moves{};
+      for (const Snake& snake : state.snakes) {
+        moves.push_back(SnakeMove{
+            .snake_id = snake.id,
+            .move = static_cast<Move>(moves_generator.Uniform(4)),
+        });
+      }
+      BoardState next_state{};
+      ruleset->CreateNextBoardState(state, moves, turn, next_state);
+      state = next_state;
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(TerritoryRandomGames, TerritoryRandomGamesTest,
+                         testing::Values(false, true),
+                         [](const testing::TestParamInfo<bool>& info) {
+                           return info.param ? "Wrapped" : "Standard";
+                         });
+
+MoveMask Moves(std::initializer_list<Move> moves) {
+  MoveMask result = 0;
+  for (Move move : moves) {
+    result |= MoveBit(move);
+  }
+  return result;
+}
+
+class SafeMovesTest : public testing::Test {
+ protected:
+  Snake CreateSnake(const std::string& id,
+                    const std::initializer_list<Point>& body,
+                    int health = 100) {
+    return Snake{
+        .id = pool_.Add(id),
+        .body = SnakeBody::Create(body),
+        .health = health,
+    };
+  }
+
+  StringPool pool_;
+};
+
+TEST_F(SafeMovesTest, BoundsAndBodies) {
+  BoardState state{
+      .width = 5,
+      .height = 5,
+      .snakes = SnakesVector::Create({
+          CreateSnake("one", {{0, 0}, {1, 0}, {2, 0}}),
+      }),
+  };
+  state.RebuildBodies();
+  const BoardBitsShifter shifter(state.width, state.height);
+
+  EXPECT_THAT(SafeMoves(state, 0, shifter), Eq(Moves({Move::Up})));
+}
+
+TEST_F(SafeMovesTest, TailMovingAwayIsSafe) {
+  BoardState state{
+      .width = 5,
+      .height = 5,
+      .snakes = SnakesVector::Create({
+          CreateSnake("one", {{1, 1}, {1, 2}, {2, 2}, {2, 1}}),
+      }),
+  };
+  state.RebuildBodies();
+  const BoardBitsShifter shifter(state.width, state.height);
+  EXPECT_THAT(SafeMoves(state, 0, shifter),
+              Eq(Moves({Move::Down, Move::Left, Move::Right})));
+
+  // Stacked tail stays.
+  state.snakes[0].body.IncreaseLength();
+  state.RebuildBodies();
+  EXPECT_THAT(SafeMoves(state, 0, shifter),
+              Eq(Moves({Move::Down, Move::Left})));
+}
+
+TEST_F(SafeMovesTest, OtherSnakes) {
+  BoardState state{
+      .width = 5,
+      .height = 5,
+      .snakes = SnakesVector::Create({
+          CreateSnake("one", {{2, 2}, {2, 1}, {2, 0}}),
+          // Head to the left, leaves its neck there.
+          CreateSnake("two", {{1, 2}, {0, 2}, {0, 1}}),
+          // Body above, tail doesn't move away.
+          CreateSnake("three", {{4, 3}, {3, 3}, {2, 3}, {2, 3}}),
+      }),
+  };
+  state.RebuildBodies();
+  const BoardBitsShifter shifter(state.width, state.height);
+
+  EXPECT_THAT(SafeMoves(state, 0, shifter), Eq(Moves({Move::Right})));
+
+  state.snakes[1].eliminated_cause.cause = EliminatedCause::OutOfHealth;
+  state.RebuildBodies();
+  EXPECT_THAT(SafeMoves(state, 0, shifter),
+              Eq(Moves({Move::Left, Move::Right})));
+  EXPECT_THAT(SafeMoves(state, 1, shifter), Eq(0));
+}
+
+TEST_F(SafeMovesTest, HeadToHead) {
+  BoardState state{
+      .width = 7,
+      .height = 7,
+      .snakes = SnakesVector::Create({
+          CreateSnake("one", {{3, 3}, {3, 2}, {3, 1}}),
+          // Can move to (2, 4) and (4, 4) too.
+          CreateSnake("two", {{3, 5}, {3, 6}}),
+          CreateSnake("three", {{1, 3}, {0, 3}, {0, 2}, {0, 1}}),
+      }),
+  };
+  state.RebuildBodies();
+  const BoardBitsShifter shifter(state.width, state.height);
+
+  const MoveMask all_safe = Moves({Move::Up, Move::Left, Move::Right});
+  EXPECT_THAT(SafeMoves(state, 0, shifter), Eq(all_safe));
+  const SafeMovesConfig head_to_head_config{.avoid_head_to_head = true};
+
+  // Only the longer third snake is dangerous.
+  EXPECT_THAT(SafeMoves(state, 0, shifter, head_to_head_config),
+              Eq(Moves({Move::Up, Move::Right})));
+
+  state.snakes[1].body.IncreaseLength();
+  state.RebuildBodies();
+  EXPECT_THAT(SafeMoves(state, 0, shifter, head_to_head_config),
+              Eq(Moves({Move::Right})));
+}
+
+TEST_F(SafeMovesTest, Health) {
+  BoardState state{
+      .width = 5,
+      .height = 5,
+      .food = CreateBoardBits({Point{1, 2}}, 5, 5),
+      .snakes = SnakesVector::Create({
+          CreateSnake("one", {{2, 2}, {2, 1}, {2, 0}}, 15),
+      }),
+      .hazard = CreateBoardBits({Point{1, 2}, Point{3, 2}, Point{2, 3}}, 5, 5),
+  };
+  state.RebuildBodies();
+  const BoardBitsShifter shifter(state.width, state.height);
+
+  // Hazards are ignored by default.
+  EXPECT_THAT(SafeMoves(state, 0, shifter),
+              Eq(Moves({Move::Up, Move::Left, Move::Right})));
+
+  // Food in hazard restores health.
+  const SafeMovesConfig config{.hazard_damage_per_turn = 14};
+  EXPECT_THAT(SafeMoves(state, 0, shifter, config), Eq(Moves({Move::Left})));
+  state.snakes[0].health = 16;
+  EXPECT_THAT(SafeMoves(state, 0, shifter, config),
+              Eq(Moves({Move::Up, Move::Left, Move::Right})));
+
+  // Starving.
+  state.snakes[0].health = 1;
+  EXPECT_THAT(SafeMoves(state, 0, shifter), Eq(Moves({Move::Left})));
+}
+
+TEST_F(SafeMovesTest, Wrapped) {
+  Point size{5, 5};
+  BoardState state{
+      .width = 5,
+      .height = 5,
+      .snakes = SnakesVector::Create({
+          Snake{
+              .id = pool_.Add("one"),
+              .body = SnakeBody::Create({{0, 0}, {1, 0}, {2, 0}}, &size),
+              .health = 100,
+          },
+      }),
+  };
+  state.RebuildBodies();
+  const BoardBitsShifter shifter(state.width, state.height, true);
+
+  EXPECT_THAT(SafeMoves(state, 0, shifter),
+              Eq(Moves({Move::Up, Move::Down, Move::Left})));
+}
+
+class SafeMovesRandomGamesTest : public testing::TestWithParam<bool> {};
+
+// Plays random games. Moves that are not safe always eliminate the snake, and
+// moves that are safe even from head to head never do.
+TEST_P(SafeMovesRandomGamesTest, MatchesRuleset) {
+  const bool wrapped = GetParam();
+  StringPool pool;
+  std::vector<SnakeId> ids{pool.Add("a"), pool.Add("b"), pool.Add("c"),
+                           pool.Add("d")};
+  RandomGenerator moves_generator(3);
+  const SafeMovesConfig config{
+      .hazard_damage_per_turn =
+          wrapped ? RoyaleRuleset::RoyaleConfig::Default().extra_damage_per_turn
+                  : 0,
+  };
+  SafeMovesConfig head_to_head_config = config;
+  head_to_head_config.avoid_head_to_head = true;
+
+  for (int game = 0; game < 50; ++game) {
+    std::unique_ptr<StandardRuleset> ruleset;
+    if (wrapped) {
+      ruleset = std::make_unique<WrappedRuleset>();
+    } else {
+      ruleset = std::make_unique<StandardRuleset>();
+    }
+    ruleset->SetRandomSeed(game + 1);
+    BoardState state = ruleset->CreateInitialBoardState(kBoardSizeSmall,
+                                                        kBoardSizeSmall, ids);
+    const BoardBitsShifter shifter(state.width, state.height, wrapped);
+
+    for (int turn = 1; turn < 300 && !ruleset->IsGameOver(state); ++turn) {
+      SnakeMovesVector moves{};
+      for (const Snake& snake : state.snakes) {
+        moves.push_back(SnakeMove{
+            .snake_id = snake.id,
+            .move = static_cast<Move>(moves_generator.Uniform(4)),
+        });
+      }
+      BoardState next_state{};
+      ruleset->CreateNextBoardState(state, moves, turn, next_state);
+
+      // Bodies of snakes eliminated by health or bounds don't eliminate
+      // others, which is not known beforehand.
+      bool others_out = false;
+      for (const Snake& snake : next_state.snakes) {
+        others_out |=
+            snake.eliminated_cause.cause == EliminatedCause::OutOfHealth ||
+            snake.eliminated_cause.cause == EliminatedCause::OutOfBounds;
+      }
+
+      for (int i = 0; i < state.snakes.size(); ++i) {
+        if (state.snakes[i].IsEliminated()) {
+          continue;
+        }
+        const MoveMask move_bit = MoveBit(moves[i].move);
+        const bool eliminated = next_state.snakes[i].IsEliminated();
+        const MoveMask safe =
+            SafeMoves(state, i, shifter, head_to_head_config);
+        if ((safe & move_bit) != 0) {
+          ASSERT_THAT(eliminated, IsFalse())
+              << "game " << game << " turn " << turn << " snake " << i;
+        }
+        const MoveMask safe_without_head_to_head =
+            SafeMoves(state, i, shifter, config);
+        if ((safe_without_head_to_head & move_bit) == 0 && !others_out) {
+          ASSERT_THAT(eliminated, IsTrue())
+              << "game " << game << " turn " << turn << " snake " << i;
+        }
+      }
+
+      state = next_state;
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(SafeMovesRandomGames, SafeMovesRandomGamesTest,
+                         testing::Values(false, true),
+                         [](const testing::TestParamInfo<bool>& info) {
+                           return info.param ? "Wrapped" : "Standard";
+                         });
+
+}  // namespace
+
+}  // namespace rules
+}  // namespace battlesnake
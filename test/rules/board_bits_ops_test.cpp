@@ -0,0 +1,293 @@
+#include "battlesnake/rules/board_bits_ops.h"
+
+#include <vector>
+
+#include "battlesnake/rules/random.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::testing::Eq;
+using ::testing::IsFalse;
+using ::testing::IsTrue;
+using ::testing::NotNull;
+
+BoardBits RandomBits(RandomGenerator& random, int width, int height) {
+  BoardBits result{};
+  for (int i = 0; i < width * height; ++i) {
+    result.Set(i, random.Uniform(3) == 0);
+  }
+  return result;
+}
+
+BoardBits RandomBlocks(RandomGenerator& random) {
+  BoardBits result{};
+  for (BoardBits::BlockType& block : result.data) {
+    block = random.Next();
+  }
+  return result;
+}
+
+// Shifts bits one point at a time, to compare optimized version with.
+BoardBits ReferenceMoved(const BoardBits& bits, int width, int height,
+                         bool wrapped, Move move) {
+  Point board_size{static_cast<Coordinate>(width),
+                   static_cast<Coordinate>(height)};
+  BoardBits result{};
+  BoardBitsView result_view(&result, width, height);
+  for (Point p : BoardBitsViewConst(&bits, width, height)) {
+    Point moved = p.Moved(move, wrapped ? &board_size : nullptr);
+    if (moved.x < 0 || moved.y < 0 || moved.x >= width || moved.y >= height) {
+      continue;
+    }
+    result_view.Set(moved, true);
+  }
+  return result;
+}
+
+class BoardBitsKernelsTest
+    : public testing::TestWithParam<const BoardBitsKernels*> {
+ protected:
+  void SetUp() override {
+    if (GetParam() == nullptr) {
+      GTEST_SKIP() << "Kernels are not supported on this CPU";
+    }
+  }
+};
+
+TEST_P(BoardBitsKernelsTest, PopCount) {
+  const BoardBitsKernels& kernels = *GetParam();
+  RandomGenerator random(3);
+
+  BoardBits empty{};
+  EXPECT_THAT(kernels.pop_count(empty), Eq(0));
+
+  for (int iteration = 0; iteration < 100; ++iteration) {
+    BoardBits a = RandomBlocks(random);
+    int expected = 0;
+    for (int i = 0; i < BoardBits::kMaxBitsSize; ++i) {
+      expected += a.Get(i) ? 1 : 0;
+    }
+    EXPECT_THAT(kernels.pop_count(a), Eq(expected));
+  }
+}
+
+TEST_P(BoardBitsKernelsTest, SelectBit) {
+  const BoardBitsKernels& kernels = *GetParam();
+  RandomGenerator random(4);
+
+  BoardBits empty{};
+  EXPECT_THAT(kernels.select_bit(empty, 0), Eq(-1));
+
+  for (int iteration = 0; iteration < 100; ++iteration) {
+    // Sparse bits as well as full blocks.
+    BoardBits a = iteration % 2 == 0 ? RandomBlocks(random)
+                                     : RandomBits(random, kBoardSizeMax,
+                                                  kBoardSizeMax);
+    int rank = 0;
+    for (int i = 0; i < BoardBits::kMaxBitsSize; ++i) {
+      if (a.Get(i)) {
+        ASSERT_THAT(kernels.select_bit(a, rank), Eq(i)) << "rank " << rank;
+        ++rank;
+      }
+    }
+    EXPECT_THAT(kernels.select_bit(a, rank), Eq(-1));
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(BoardBitsKernels, BoardBitsKernelsTest,
+                         testing::Values(&GetScalarBoardBitsKernels(),
+                                         GetPopcntBoardBitsKernels()),
+                         [](const auto& info) {
+                           return info.index == 0 ? "Scalar" : "Popcnt";
+                         });
+
+TEST(BoardBitsOpsTest, SelectedKernelsAreValid) {
+  const BoardBitsKernels& kernels = GetBoardBitsKernels();
+  EXPECT_THAT(kernels.name, NotNull());
+  EXPECT_THAT(kernels.pop_count, NotNull());
+  EXPECT_THAT(kernels.select_bit, NotNull());
+}
+
+TEST(BoardBitsOpsTest, BinaryOperations) {
+  RandomGenerator random(1);
+
+  for (int iteration = 0; iteration < 100; ++iteration) {
+    BoardBits a = RandomBlocks(random);
+    BoardBits b = RandomBlocks(random);
+    BoardBits result_and = And(a, b);
+    BoardBits result_or = Or(a, b);
+    BoardBits result_and_not = AndNot(a, b);
+    BoardBits result_xor = Xor(a, b);
+
+    for (int i = 0; i < BoardBits::kBlocksCount; ++i) {
+      EXPECT_THAT(result_and.data[i], Eq(a.data[i] & b.data[i]));
+      EXPECT_THAT(result_or.data[i], Eq(a.data[i] | b.data[i]));
+      EXPECT_THAT(result_and_not.data[i], Eq(a.data[i] & ~b.data[i]));
+      EXPECT_THAT(result_xor.data[i], Eq(a.data[i] ^ b.data[i]));
+    }
+  }
+}
+
+TEST(BoardBitsOpsTest, Operators) {
+  BoardBits a = CreateBoardBits({Point{0, 0}, Point{1, 0}}, 3, 3);
+  BoardBits b = CreateBoardBits({Point{1, 0}, Point{2, 2}}, 3, 3);
+
+  EXPECT_THAT(a & b, Eq(CreateBoardBits({Point{1, 0}}, 3, 3)));
+  EXPECT_THAT(a | b, Eq(CreateBoardBits(
+                         {Point{0, 0}, Point{1, 0}, Point{2, 2}}, 3, 3)));
+  EXPECT_THAT(a ^ b, Eq(CreateBoardBits({Point{0, 0}, Point{2, 2}}, 3, 3)));
+  EXPECT_THAT(AndNot(a, b), Eq(CreateBoardBits({Point{0, 0}}, 3, 3)));
+  EXPECT_THAT(PopCount(a | b), Eq(3));
+
+  BoardBits c = a;
+  c |= b;
+  c &= a;
+  EXPECT_THAT(c, Eq(a));
+  c ^= a;
+  EXPECT_THAT(IsEmpty(c), IsTrue());
+  EXPECT_THAT(IsEmpty(a), IsFalse());
+}
+
+TEST(BoardBitsOpsTest, ForEachBit) {
+  BoardBits bits{};
+  bits.Set(0, true);
+  bits.Set(63, true);
+  bits.Set(64, true);
+  bits.Set(200, true);
+  bits.Set(BoardBits::kBitsSizeNeeded - 1, true);
+
+  std::vector<int> indices;
+  ForEachBit(bits, [&indices](int index) { indices.push_back(index); });
+
+  EXPECT_THAT(indices,
+              ElementsAre(0, 63, 64, 200, BoardBits::kBitsSizeNeeded - 1));
+  EXPECT_THAT(FirstBit(bits), Eq(0));
+
+  bits.Set(0, false);
+  bits.Set(63, false);
+  EXPECT_THAT(FirstBit(bits), Eq(64));
+
+  BoardBits empty{};
+  EXPECT_THAT(FirstBit(empty), Eq(-1));
+}
+
+TEST(BoardBitsOpsTest, ShiftsSmallBoard) {
+  BoardBitsShifter shifter(3, 3);
+  BoardBits bits = CreateBoardBits({Point{0, 0}, Point{2, 1}}, 3, 3);
+
+  EXPECT_THAT(shifter.Up(bits),
+              Eq(CreateBoardBits({Point{0, 1}, Point{2, 2}}, 3, 3)));
+  EXPECT_THAT(shifter.Down(bits), Eq(CreateBoardBits({Point{2, 0}}, 3, 3)));
+  EXPECT_THAT(shifter.Left(bits), Eq(CreateBoardBits({Point{1, 1}}, 3, 3)));
+  EXPECT_THAT(shifter.Right(bits), Eq(CreateBoardBits({Point{1, 0}}, 3, 3)));
+  EXPECT_THAT(shifter.Neighbours(CreateBoardBits({Point{1, 1}}, 3, 3)),
+              Eq(CreateBoardBits(
+                  {Point{1, 2}, Point{1, 0}, Point{0, 1}, Point{2, 1}}, 3, 3)));
+}
+
+TEST(BoardBitsOpsTest, ShiftsSmallBoardWrapped) {
+  BoardBitsShifter shifter(3, 3, true);
+  BoardBits bits = CreateBoardBits({Point{0, 0}, Point{2, 2}}, 3, 3);
+
+  EXPECT_THAT(shifter.Up(bits),
+              Eq(CreateBoardBits({Point{0, 1}, Point{2, 0}}, 3, 3)));
+  EXPECT_THAT(shifter.Down(bits),
+              Eq(CreateBoardBits({Point{0, 2}, Point{2, 1}}, 3, 3)));
+  EXPECT_THAT(shifter.Left(bits),
+              Eq(CreateBoardBits({Point{2, 0}, Point{1, 2}}, 3, 3)));
+  EXPECT_THAT(shifter.Right(bits),
+              Eq(CreateBoardBits({Point{1, 0}, Point{0, 2}}, 3, 3)));
+}
+
+TEST(BoardBitsOpsTest, BoardMask) {
+  BoardBitsShifter shifter(kBoardSizeMax, kBoardSizeMax);
+
+  EXPECT_THAT(PopCount(shifter.BoardMask()),
+              Eq(kBoardSizeMax * kBoardSizeMax));
+}
+
+struct ShiftTestParams {
+  int width;
+  int height;
+  bool wrapped;
+};
+
+void PrintTo(const ShiftTestParams& params, std::ostream* os) {
+  *os << params.width << "x" << params.height
+      << (params.wrapped ? " wrapped" : "");
+}
+
+class BoardBitsShifterTest : public testing::TestWithParam<ShiftTestParams> {};
+
+TEST_P(BoardBitsShifterTest, MatchesPointByPointMoves) {
+  const ShiftTestParams& params = GetParam();
+  BoardBitsShifter shifter(params.width, params.height, params.wrapped);
+  RandomGenerator random(params.width * 100 + params.height);
+
+  for (int iteration = 0; iteration < 20; ++iteration) {
+    BoardBits bits = RandomBits(random, params.width, params.height);
+    BoardBits neighbours{};
+    for (Move move : {Move::Up, Move::Down, Move::Left, Move::Right}) {
+      BoardBits expected = ReferenceMoved(bits, params.width, params.height,
+                                          params.wrapped, move);
+      EXPECT_THAT(shifter.Moved(bits, move), Eq(expected)) << move;
+      neighbours |= expected;
+    }
+    EXPECT_THAT(shifter.Neighbours(bits), Eq(neighbours));
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    BoardBitsShifter, BoardBitsShifterTest,
+    testing::Values(ShiftTestParams{kBoardSizeSmall, kBoardSizeSmall, false},
+                    ShiftTestParams{kBoardSizeMedium, kBoardSizeMedium, false},
+                    ShiftTestParams{kBoardSizeMedium, kBoardSizeMedium, true},
+                    ShiftTestParams{kBoardSizeLarge, kBoardSizeLarge, false},
+                    ShiftTestParams{kBoardSizeLarge, kBoardSizeLarge, true},
+                    ShiftTestParams{kBoardSizeMax, kBoardSizeMax, false},
+                    ShiftTestParams{kBoardSizeMax, kBoardSizeMax, true},
+                    ShiftTestParams{13, 5, false}, ShiftTestParams{5, 13, true},
+                    ShiftTestParams{1, 7, true}, ShiftTestParams{7, 1, true}));
+
+TEST(BoardBitsViewTest, CountIgnoresBitsOutsideOfBoard) {
+  BoardBits bits{};
+  bits.Set(0, true);
+  bits.Set(8, true);
+  bits.Set(9, true);
+  bits.Set(100, true);
+
+  EXPECT_THAT(BoardBitsViewConst(&bits, 3, 3).Count(), Eq(2));
+}
+
+TEST(BoardBitsViewTest, IteratesAllPoints) {
+  RandomGenerator random(4);
+  BoardBits bits = RandomBits(random, kBoardSizeMax, kBoardSizeMax);
+
+  std::vector<Point> expected;
+  for (int i = 0; i < kBoardSizeMax * kBoardSizeMax; ++i) {
+    if (bits.Get(i)) {
+      expected.push_back(Point{static_cast<Coordinate>(i % kBoardSizeMax),
+                               static_cast<Coordinate>(i / kBoardSizeMax)});
+    }
+  }
+  BoardBitsViewConst view(&bits, kBoardSizeMax, kBoardSizeMax);
+  std::vector<Point> points;
+  for (Point p : view) {
+    points.push_back(p);
+  }
+
+  EXPECT_THAT(points, ElementsAreArray(expected));
+  EXPECT_THAT(view.Count(), Eq(expected.size()));
+}
+
+}  // namespace
+
+}  // namespace rules
+}  // namespace battlesnake
@@ -0,0 +1,193 @@
+#include <memory>
+
+#include "battlesnake/rules/random.h"
+#include "battlesnake/rules/standard_ruleset.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ruleset_test_helpers.h"
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+using ::testing::Eq;
+using ::testing::IsFalse;
+
+class BoardBodiesTest : public testing::TestWithParam<RulesetFactory> {};
+
+// Plays random games and checks that incrementally updated bodies always match
+// bodies calculated from scratch. CreateNextBoardState() rebuilds bodies, so
+// the joint move entry point is used.
+TEST_P(BoardBodiesTest, IncrementalBodiesMatchRebuilt) {
+  StringPool pool;
+  std::vector<SnakeId> ids{pool.Add("a"), pool.Add("b"), pool.Add("c"),
+                           pool.Add("d")};
+  StringWrapper squads[] = {pool.Add("red"), pool.Add("blue")};
+  RandomGenerator moves_generator(1);
+
+  for (int game = 0; game < 20; ++game) {
+    std::unique_ptr<StandardRuleset> ruleset =
+        GetParam().create(StandardRuleset::Config::Default());
+    ruleset->SetRandomSeed(game + 1);
+
+    BoardState state = ruleset->CreateInitialBoardState(kBoardSizeSmall,
+                                                        kBoardSizeSmall, ids);
+    for (int i = 0; i < state.snakes.size(); ++i) {
+      state.snakes[i].squad = squads[i % 2];
+    }
+
+    for (int turn = 1; turn < 200 && !ruleset->IsGameOver(state); ++turn) {
+      JointMove joint_move = 0;
+      for (int i = 0; i < state.snakes.size(); ++i) {
+        SetSnakeMove(joint_move, i,
+                     static_cast<Move>(moves_generator.Uniform(4)));
+      }
+
+      BoardState next_state{};
+      ruleset->CreateNextBoardStateJoint(state, joint_move, turn, next_state);
+      state = next_state;
+
+      BoardState rebuilt = state;
+      rebuilt.RebuildBodies();
+      ASSERT_THAT(state.bodies, Eq(rebuilt.bodies))
+          << "game " << game << " turn " << turn;
+    }
+  }
+}
+
+class BoardBodiesStaleTest : public testing::Test {
+ protected:
+  // The snake would collide with itself moving right, but the bit of the body
+  // piece it moves onto is missing, as if the snake was moved by hand.
+  BoardState CreateStaleState() {
+    BoardState state{
+        .width = kBoardSizeSmall,
+        .height = kBoardSizeSmall,
+        .snakes = SnakesVector::Create({
+            Snake{
+                .id = pool_.Add("one"),
+                .body = SnakeBody::Create({Point{1, 1}, Point{1, 0},
+                                           Point{2, 0}, Point{2, 1},
+                                           Point{2, 2}}),
+                .health = 100,
+            },
+        }),
+    };
+    state.RebuildBodies();
+    state.Bodies().Set(Point{2, 1}, false);
+    return state;
+  }
+
+  StringPool pool_;
+  StandardRuleset ruleset_{StandardRuleset::Config{.food_spawn_chance = 0}};
+};
+
+TEST_F(BoardBodiesStaleTest, CreateNextBoardStateRebuildsBodies) {
+  const BoardState state = CreateStaleState();
+  BoardState next_state{};
+  ruleset_.CreateNextBoardState(
+      state,
+      SnakeMovesVector::Create({
+          SnakeMove{.snake_id = state.snakes[0].id, .move = Move::Right},
+      }),
+      1, next_state);
+
+  EXPECT_THAT(next_state.snakes[0].eliminated_cause.cause,
+              Eq(EliminatedCause::SelfCollision));
+}
+
+TEST_F(BoardBodiesStaleTest, ApplyRebuildsBodies) {
+  BoardState state = CreateStaleState();
+  const BoardState original = state;
+  UndoRecord undo = ruleset_.Apply(
+      state,
+      SnakeMovesVector::Create({
+          SnakeMove{.snake_id = state.snakes[0].id, .move = Move::Right},
+      }),
+      1);
+
+  EXPECT_THAT(state.snakes[0].eliminated_cause.cause,
+              Eq(EliminatedCause::SelfCollision));
+  ruleset_.Undo(state, undo);
+  EXPECT_THAT(state.bodies, Eq(original.bodies));
+}
+
+// Joint move entry points trust bodies until ResetDerivedData() is called.
+TEST_F(BoardBodiesStaleTest, ResetDerivedDataFixesStaleBodies) {
+  BoardState state = CreateStaleState();
+  JointMove joint_move = 0;
+  SetSnakeMove(joint_move, 0, Move::Right);
+
+  BoardState next_state{};
+  ruleset_.CreateNextBoardStateJoint(state, joint_move, 1, next_state);
+  EXPECT_THAT(next_state.snakes[0].IsEliminated(), IsFalse());
+
+  state.ResetDerivedData();
+  ruleset_.CreateNextBoardStateJoint(state, joint_move, 1, next_state);
+  EXPECT_THAT(next_state.snakes[0].eliminated_cause.cause,
+              Eq(EliminatedCause::SelfCollision));
+}
+
+TEST(BoardBodiesOutOfBoundsTest, CreateNextBoardStateChecksWholeBodies) {
+  StringPool pool;
+  BoardState state{
+      .width = kBoardSizeSmall,
+      .height = kBoardSizeSmall,
+      .snakes = SnakesVector::Create({
+          Snake{
+              .id = pool.Add("one"),
+              .body = SnakeBody::Create(
+                  {Point{0, 1}, Point{0, 0}, Point{-1, 0}, Point{-1, 1}}),
+              .health = 100,
+          },
+      }),
+  };
+
+  StandardRuleset ruleset(StandardRuleset::Config{.food_spawn_chance = 0});
+  BoardState next_state{};
+  ruleset.CreateNextBoardState(
+      state,
+      SnakeMovesVector::Create({
+          SnakeMove{.snake_id = state.snakes[0].id, .move = Move::Up},
+      }),
+      1, next_state);
+
+  EXPECT_THAT(next_state.snakes[0].eliminated_cause.cause,
+              Eq(EliminatedCause::OutOfBounds));
+}
+
+TEST(BoardBodiesOutOfBoundsTest, ApplyChecksWholeBodies) {
+  StringPool pool;
+  BoardState state{
+      .width = kBoardSizeSmall,
+      .height = kBoardSizeSmall,
+      .snakes = SnakesVector::Create({
+          Snake{
+              .id = pool.Add("one"),
+              .body = SnakeBody::Create(
+                  {Point{0, 1}, Point{0, 0}, Point{-1, 0}, Point{-1, 1}}),
+              .health = 100,
+          },
+      }),
+  };
+
+  StandardRuleset ruleset(StandardRuleset::Config{.food_spawn_chance = 0});
+  ruleset.Apply(state,
+                SnakeMovesVector::Create({
+                    SnakeMove{.snake_id = state.snakes[0].id, .move = Move::Up},
+                }),
+                1);
+
+  EXPECT_THAT(state.snakes[0].eliminated_cause.cause,
+              Eq(EliminatedCause::OutOfBounds));
+}
+
+INSTANTIATE_TEST_SUITE_P(AllRulesets, BoardBodiesTest,
+                         testing::ValuesIn(AllRulesets()),
+                         RulesetFactoryName);
+
+}  // namespace
+
+}  // namespace rules
+}  // namespace battlesnake
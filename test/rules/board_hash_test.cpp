@@ -0,0 +1,205 @@
+#include "battlesnake/rules/board_hash.h"
+
+#include <memory>
+
+#include "battlesnake/rules/random.h"
+#include "battlesnake/rules/standard_ruleset.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ruleset_test_helpers.h"
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+using ::testing::Eq;
+using ::testing::Ne;
+
+class BoardHashTest : public testing::Test {
+ protected:
+  BoardState CreateState() {
+    BoardState state{
+        .width = kBoardSizeSmall,
+        .height = kBoardSizeSmall,
+        .food = CreateBoardBits({Point{0, 0}}, kBoardSizeSmall,
+                                kBoardSizeSmall),
+        .snakes = SnakesVector::Create({
+            Snake{
+                .id = pool_.Add("one"),
+                .body = SnakeBody::Create({{1, 1}, {1, 2}, {2, 2}}),
+                .health = 100,
+            },
+            Snake{
+                .id = pool_.Add("two"),
+                .body = SnakeBody::Create({{5, 5}, {5, 4}, {5, 4}}),
+                .health = 50,
+            },
+        }),
+        .hazard = CreateBoardBits({Point{6, 6}}, kBoardSizeSmall,
+                                  kBoardSizeSmall),
+    };
+    state.RebuildBodies();
+    return state;
+  }
+
+  StringPool pool_;
+};
+
+TEST_F(BoardHashTest, SameStateSameHash) {
+  EXPECT_THAT(ComputeBoardHash(CreateState()),
+              Eq(ComputeBoardHash(CreateState())));
+  EXPECT_THAT(ComputeBoardHash(CreateState()), Ne(0));
+}
+
+TEST_F(BoardHashTest, AllPartsOfStateAffectHash) {
+  const uint64_t original = ComputeBoardHash(CreateState());
+
+  BoardState state = CreateState();
+  state.Food().Set(Point{3, 3}, true);
+  EXPECT_THAT(ComputeBoardHash(state), Ne(original));
+
+  state = CreateState();
+  state.Hazard().Set(Point{3, 3}, true);
+  EXPECT_THAT(ComputeBoardHash(state), Ne(original));
+
+  state = CreateState();
+  state.snakes[0].health--;
+  EXPECT_THAT(ComputeBoardHash(state), Ne(original));
+
+  state = CreateState();
+  state.snakes[1].body.IncreaseLength();
+  EXPECT_THAT(ComputeBoardHash(state), Ne(original));
+
+  state = CreateState();
+  state.snakes[1].body.MoveTo(Move::Right);
+  EXPECT_THAT(ComputeBoardHash(state), Ne(original));
+
+  // Same bodies, but snakes swapped.
+  state = CreateState();
+  std::swap(state.snakes[0].body, state.snakes[1].body);
+  std::swap(state.snakes[0].health, state.snakes[1].health);
+  EXPECT_THAT(ComputeBoardHash(state), Ne(original));
+}
+
+TEST_F(BoardHashTest, EliminatedSnakesDontContribute) {
+  BoardState state = CreateState();
+  state.snakes[1].eliminated_cause.cause = EliminatedCause::Collision;
+  const uint64_t hash = ComputeBoardHash(state);
+
+  state.snakes[1].health = 0;
+  state.snakes[1].body.MoveTo(Move::Right);
+  EXPECT_THAT(ComputeBoardHash(state), Eq(hash));
+}
+
+TEST_F(BoardHashTest, HealthIsClampedToMaxHealth) {
+  BoardState state = CreateState();
+  auto hash_with_health = [&state](int health) {
+    state.snakes[0].health = health;
+    return ComputeBoardHash(state);
+  };
+
+  // Health doesn't wrap around, it's clamped.
+  EXPECT_THAT(hash_with_health(256), Ne(hash_with_health(0)));
+  EXPECT_THAT(hash_with_health(kBoardHashMaxHealth + 100),
+              Eq(hash_with_health(kBoardHashMaxHealth)));
+  EXPECT_THAT(hash_with_health(-1), Eq(hash_with_health(0)));
+}
+
+TEST_F(BoardHashTest, UpdateComputesMissingPrevHash) {
+  StandardRuleset ruleset;
+  BoardState state = CreateState();
+  ASSERT_THAT(state.hash, Eq(0));
+
+  JointMove joint_move = 0;
+  SetSnakeMove(joint_move, 0, Move::Down);
+  SetSnakeMove(joint_move, 1, Move::Up);
+  BoardState next_state{};
+  ruleset.CreateNextBoardStateJoint(state, joint_move, 1, next_state);
+
+  EXPECT_THAT(next_state.hash, Eq(ComputeBoardHash(next_state)));
+}
+
+// States modified by hand may have an out of date hash, CreateNextBoardState()
+// and Apply() calculate it from scratch.
+TEST_F(BoardHashTest, StaleHashIsNotTrusted) {
+  StandardRuleset ruleset(StandardRuleset::Config{.food_spawn_chance = 0});
+  BoardState state = CreateState();
+  state.hash = ComputeBoardHash(state);
+  state.snakes[1].health = 10;
+  const SnakeMovesVector moves = SnakeMovesVector::Create({
+      SnakeMove{.snake_id = state.snakes[0].id, .move = Move::Down},
+      SnakeMove{.snake_id = state.snakes[1].id, .move = Move::Up},
+  });
+
+  BoardState next_state{};
+  ruleset.CreateNextBoardState(state, moves, 1, next_state);
+  EXPECT_THAT(next_state.hash, Eq(ComputeBoardHash(next_state)));
+
+  const uint64_t stale_hash = state.hash;
+  UndoRecord undo = ruleset.Apply(state, moves, 1);
+  EXPECT_THAT(state.hash, Eq(ComputeBoardHash(state)));
+  ruleset.Undo(state, undo);
+  EXPECT_THAT(state.hash, Eq(stale_hash));
+}
+
+TEST(BoardHashInitialStateTest, InitialStateHasHash) {
+  StringPool pool;
+  StandardRuleset ruleset;
+  BoardState state = ruleset.CreateInitialBoardState(
+      kBoardSizeMedium, kBoardSizeMedium, {pool.Add("a"), pool.Add("b")});
+
+  EXPECT_THAT(state.hash, Ne(0));
+  EXPECT_THAT(state.hash, Eq(ComputeBoardHash(state)));
+}
+
+class IncrementalBoardHashTest
+    : public testing::TestWithParam<RulesetFactory> {};
+
+// Plays random games and checks that incrementally updated hash always matches
+// hash calculated from scratch. CreateNextBoardState() calculates hash from
+// scratch, so the joint move entry point is used.
+TEST_P(IncrementalBoardHashTest, IncrementalHashMatchesComputed) {
+  StringPool pool;
+  std::vector<SnakeId> ids{pool.Add("a"), pool.Add("b"), pool.Add("c"),
+                           pool.Add("d")};
+  StringWrapper squads[] = {pool.Add("red"), pool.Add("blue")};
+  RandomGenerator moves_generator(1);
+
+  for (int game = 0; game < 20; ++game) {
+    std::unique_ptr<StandardRuleset> ruleset =
+        GetParam().create(StandardRuleset::Config::Default());
+    ruleset->SetRandomSeed(game + 1);
+
+    BoardState state = ruleset->CreateInitialBoardState(kBoardSizeSmall,
+                                                        kBoardSizeSmall, ids);
+    for (int i = 0; i < state.snakes.size(); ++i) {
+      state.snakes[i].squad = squads[i % 2];
+    }
+    ASSERT_THAT(state.hash, Eq(ComputeBoardHash(state)));
+
+    for (int turn = 1; turn < 200 && !ruleset->IsGameOver(state); ++turn) {
+      JointMove joint_move = 0;
+      for (int i = 0; i < state.snakes.size(); ++i) {
+        SetSnakeMove(joint_move, i,
+                     static_cast<Move>(moves_generator.Uniform(4)));
+      }
+
+      BoardState next_state{};
+      ruleset->CreateNextBoardStateJoint(state, joint_move, turn, next_state);
+      state = next_state;
+
+      ASSERT_THAT(state.hash, Eq(ComputeBoardHash(state)))
+          << "game " << game << " turn " << turn;
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(AllRulesets, IncrementalBoardHashTest,
+                         testing::ValuesIn(AllRulesets()),
+                         RulesetFactoryName);
+
+}  // namespace
+
+}  // namespace rules
+}  // namespace battlesnake
@@ -0,0 +1,135 @@
+#include "battlesnake/rules/board_topology.h"
+
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ruleset_test_helpers.h"
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+using ::testing::ElementsAreArray;
+using ::testing::Eq;
+using ::testing::IsFalse;
+using ::testing::IsNull;
+using ::testing::IsTrue;
+using ::testing::NotNull;
+
+static constexpr Move kMoves[] = {Move::Up, Move::Down, Move::Left,
+                                  Move::Right};
+
+class BoardTopologyTest : public testing::TestWithParam<bool> {};
+
+TEST_P(BoardTopologyTest, SameAsPointMoved) {
+  const bool wrapped = GetParam();
+  for (Coordinate size : {kBoardSizeSmall, kBoardSizeMedium, kBoardSizeLarge}) {
+    const BoardTopology* topology = BoardTopology::Find(size, size, wrapped);
+    ASSERT_THAT(topology, NotNull());
+    EXPECT_THAT(topology->Width(), Eq(size));
+    EXPECT_THAT(topology->Height(), Eq(size));
+    EXPECT_THAT(topology->Wrapped(), Eq(wrapped));
+    EXPECT_THAT(topology->CellsCount(), Eq(size * size));
+
+    const Point board_size{size, size};
+    const Point* wrapped_board_size = wrapped ? &board_size : nullptr;
+    for (int cell = 0; cell < topology->CellsCount(); ++cell) {
+      const Point p = topology->CellPoint(cell);
+      ASSERT_THAT(topology->CellIndex(p), Eq(cell));
+
+      for (Move move : kMoves) {
+        const Point expected = p.Moved(move, wrapped_board_size);
+        EXPECT_THAT(topology->Moved(p, move), Eq(expected));
+        EXPECT_THAT(topology->DetectMove(p, expected), Eq(move));
+
+        const int neighbor = topology->Neighbor(cell, move);
+        if (topology->InBounds(expected)) {
+          EXPECT_THAT(neighbor, Eq(topology->CellIndex(expected)));
+        } else {
+          EXPECT_THAT(wrapped, IsFalse());
+          EXPECT_THAT(neighbor, Eq(BoardTopology::kNoCell));
+        }
+      }
+      EXPECT_THAT(topology->DetectMove(p, p), Eq(Move::Unknown));
+    }
+  }
+}
+
+TEST_P(BoardTopologyTest, OffBoardPoints) {
+  const bool wrapped = GetParam();
+  const BoardTopology* topology =
+      BoardTopology::Find(kBoardSizeMedium, kBoardSizeMedium, wrapped);
+  ASSERT_THAT(topology, NotNull());
+
+  const Point board_size{kBoardSizeMedium, kBoardSizeMedium};
+  const Point* wrapped_board_size = wrapped ? &board_size : nullptr;
+  for (Point p : {Point{-1, 5}, Point{5, 11}, Point{11, 11}}) {
+    EXPECT_THAT(topology->InBounds(p), IsFalse());
+    for (Move move : kMoves) {
+      EXPECT_THAT(topology->Moved(p, move),
+                  Eq(p.Moved(move, wrapped_board_size)));
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Wrapped, BoardTopologyTest,
+                         testing::Values(false, true));
+
+TEST(BoardTopologyFindTest, OnlyStandardSizes) {
+  EXPECT_THAT(BoardTopology::Find(5, 5, false), IsNull());
+  EXPECT_THAT(BoardTopology::Find(kBoardSizeSmall, kBoardSizeMedium, true),
+              IsNull());
+  EXPECT_THAT(BoardTopology::Find(kBoardSizeMax, kBoardSizeMax, true),
+              IsNull());
+}
+
+TEST(BoardTopologyFindTest, SnakeBody) {
+  const Point board_size{kBoardSizeMedium, kBoardSizeMedium};
+  EXPECT_THAT(SnakeBody::Create({Point{1, 1}}).Topology(), IsNull());
+
+  const BoardTopology* topology =
+      SnakeBody::Create({Point{1, 1}}, &board_size).Topology();
+  ASSERT_THAT(topology, NotNull());
+  EXPECT_THAT(topology->Width(), Eq(kBoardSizeMedium));
+  EXPECT_THAT(topology->Wrapped(), IsTrue());
+
+  const Point odd_board_size{8, 8};
+  EXPECT_THAT(SnakeBody::Create({Point{1, 1}}, &odd_board_size).Topology(),
+              IsNull());
+}
+
+// Body crossing edges of a wrapped board, the same on standard and
+// non-standard board sizes, with and without a topology.
+TEST(BoardTopologySnakeBodyTest, WrappedBody) {
+  for (Coordinate size : {kBoardSizeMedium, Coordinate{12}}) {
+    const Point board_size{size, size};
+    const Coordinate last = size - 1;
+    const std::vector<Point> points{
+        Point{0, 0},    Point{last, 0}, Point{last, last},
+        Point{0, last}, Point{1, last}, Point{1, last},
+    };
+
+    SnakeBody body = SnakeBody::Create(points, &board_size);
+    EXPECT_THAT(body.Length(), Eq(6));
+    EXPECT_THAT(body.TailPos(), Eq(Point{1, last}));
+    EXPECT_THAT(BodyPoints(body), ElementsAreArray(points));
+
+    body.MoveTo(Move::Down);
+    EXPECT_THAT(body.HeadPos(), Eq(Point{0, last}));
+    EXPECT_THAT(BodyPoints(body), ElementsAreArray({
+                                      Point{0, last},
+                                      Point{0, 0},
+                                      Point{last, 0},
+                                      Point{last, last},
+                                      Point{0, last},
+                                      Point{1, last},
+                                  }));
+  }
+}
+
+}  // namespace
+
+}  // namespace rules
+}  // namespace battlesnake
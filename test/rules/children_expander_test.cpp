@@ -0,0 +1,236 @@
+#include "battlesnake/rules/children_expander.h"
+
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "battlesnake/rules/board_hash.h"
+#include "battlesnake/rules/random.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ruleset_test_helpers.h"
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+using ::testing::Eq;
+using ::testing::IsFalse;
+using ::testing::IsTrue;
+
+class ChildrenExpanderTest : public testing::Test {
+ protected:
+  BoardState CreateState() {
+    return BoardState{
+        .width = kBoardSizeSmall,
+        .height = kBoardSizeSmall,
+        .snakes = SnakesVector::Create({
+            Snake{
+                .id = pool_.Add("one"),
+                .body = SnakeBody::Create({{1, 1}, {1, 2}, {1, 3}}),
+                .health = 100,
+            },
+            Snake{
+                .id = pool_.Add("two"),
+                .body = SnakeBody::Create({{5, 5}, {5, 4}, {5, 3}}),
+                .health = 100,
+            },
+            Snake{
+                .id = pool_.Add("three"),
+                .body = SnakeBody::Create({{3, 3}}),
+                .health = 100,
+                .eliminated_cause = {.cause = EliminatedCause::OutOfHealth},
+            },
+        }),
+    };
+  }
+
+  StringPool pool_;
+};
+
+TEST_F(ChildrenExpanderTest, GeneratesAllJointMoves) {
+  StandardRuleset ruleset;
+  BoardState state = CreateState();
+  ChildrenExpander expander = ExpandChildren(
+      ruleset, state,
+      MoveMasksVector::Create({
+          static_cast<MoveMask>(MoveBit(Move::Left) | MoveBit(Move::Down)),
+          kAllMovesMask,
+          // Eliminated snake, ignored.
+          MoveMask{0},
+      }),
+      1);
+
+  EXPECT_THAT(expander.ChildrenCount(), Eq(8));
+
+  std::vector<std::pair<Move, Move>> joint_moves;
+  JointMove joint_move = 0;
+  BoardState child{};
+  while (expander.Next(joint_move, child)) {
+    joint_moves.push_back(
+        {GetSnakeMove(joint_move, 0), GetSnakeMove(joint_move, 1)});
+    EXPECT_THAT(child.snakes[0].Head(),
+                Eq(state.snakes[0].Head().Moved(joint_moves.back().first)));
+    EXPECT_THAT(child.snakes[1].Head(),
+                Eq(state.snakes[1].Head().Moved(joint_moves.back().second)));
+    EXPECT_THAT(child.snakes[2].Head(), Eq(state.snakes[2].Head()));
+  }
+
+  std::set<std::pair<Move, Move>> unique_joint_moves(joint_moves.begin(),
+                                                     joint_moves.end());
+  EXPECT_THAT(joint_moves.size(), Eq(8));
+  EXPECT_THAT(unique_joint_moves.size(), Eq(8));
+  EXPECT_THAT(expander.Next(joint_move, child), IsFalse());
+}
+
+TEST_F(ChildrenExpanderTest, MissingMasksAllowAllMoves) {
+  StandardRuleset ruleset;
+  ChildrenExpander expander =
+      ExpandChildren(ruleset, CreateState(), MoveMasksVector{}, 1);
+
+  EXPECT_THAT(expander.ChildrenCount(), Eq(16));
+}
+
+TEST_F(ChildrenExpanderTest, EmptyMaskMeansNoChildren) {
+  StandardRuleset ruleset;
+  ChildrenExpander expander =
+      ExpandChildren(ruleset, CreateState(),
+                     MoveMasksVector::Create({kAllMovesMask, MoveMask{0}}), 1);
+
+  JointMove joint_move = 0;
+  BoardState child{};
+  EXPECT_THAT(expander.ChildrenCount(), Eq(0));
+  EXPECT_THAT(expander.Next(joint_move, child), IsFalse());
+}
+
+TEST_F(ChildrenExpanderTest, FeedsAndCollides) {
+  StandardRuleset ruleset(StandardRuleset::Config{
+      .food_spawn_chance = 0,
+      .minimum_food = 0,
+  });
+  BoardState state = CreateState();
+  state.Food().Set(Point{0, 1}, true);
+  // Head of the second snake can move next to the head of the first one.
+  state.snakes[1].body = SnakeBody::Create({{1, 5}, {2, 5}, {3, 5}});
+
+  ChildrenExpander expander = ExpandChildren(
+      ruleset, state,
+      MoveMasksVector::Create({
+          static_cast<MoveMask>(MoveBit(Move::Left) | MoveBit(Move::Up)),
+          MoveBit(Move::Down),
+      }),
+      1);
+
+  JointMove joint_move = 0;
+  BoardState child{};
+  int children = 0;
+  while (expander.Next(joint_move, child)) {
+    ++children;
+    if (GetSnakeMove(joint_move, 0) == Move::Left) {
+      // Ate the food.
+      EXPECT_THAT(child.snakes[0].Length(), Eq(4));
+      EXPECT_THAT(child.snakes[0].health, Eq(100));
+      EXPECT_THAT(child.Food().Get(Point{0, 1}), IsFalse());
+    } else {
+      // Moved into own neck.
+      EXPECT_THAT(child.snakes[0].eliminated_cause.cause,
+                  Eq(EliminatedCause::SelfCollision));
+      EXPECT_THAT(child.Food().Get(Point{0, 1}), IsTrue());
+    }
+    EXPECT_THAT(child.snakes[1].health, Eq(99));
+  }
+  EXPECT_THAT(children, Eq(2));
+}
+
+class ChildrenExpanderRandomGamesTest
+    : public testing::TestWithParam<RulesetFactory> {};
+
+// Plays random games. Every turn expands all children for random candidate
+// moves and compares them with the results of CreateNextBoardState().
+TEST_P(ChildrenExpanderRandomGamesTest, ChildrenMatchCreateNextBoardState) {
+  StringPool pool;
+  std::vector<SnakeId> ids{pool.Add("a"), pool.Add("b"), pool.Add("c"),
+                           pool.Add("d")};
+  StringWrapper squads[] = {pool.Add("red"), pool.Add("blue")};
+  RandomGenerator random(1);
+
+  for (int game = 0; game < 10; ++game) {
+    std::unique_ptr<StandardRuleset> ruleset =
+        GetParam().create(StandardRuleset::Config::Default());
+    ruleset->SetRandomSeed(game + 1);
+
+    BoardState state = ruleset->CreateInitialBoardState(kBoardSizeSmall,
+                                                        kBoardSizeSmall, ids);
+    for (int i = 0; i < state.snakes.size(); ++i) {
+      state.snakes[i].squad = squads[i % 2];
+    }
+
+    for (int turn = 1; turn < 200 && !ruleset->IsGameOver(state); ++turn) {
+      MoveMasksVector masks{};
+      for (int i = 0; i < state.snakes.size(); ++i) {
+        masks.push_back(static_cast<MoveMask>(1 + random.Uniform(15)));
+      }
+
+      ChildrenExpander expander =
+          ExpandChildren(*ruleset, state, masks, turn);
+      std::vector<BoardState> children;
+      std::set<JointMove> joint_moves;
+      for (int child_index = 0;; ++child_index) {
+        const uint64_t seed = game * 100000 + turn * 100 + child_index;
+        ruleset->SetRandomSeed(seed);
+        JointMove joint_move = 0;
+        BoardState child{};
+        if (!expander.Next(joint_move, child)) {
+          break;
+        }
+        joint_moves.insert(joint_move);
+
+        for (int i = 0; i < state.snakes.size(); ++i) {
+          if (!state.snakes[i].IsEliminated()) {
+            ASSERT_THAT(masks[i] & MoveBit(GetSnakeMove(joint_move, i)),
+                        Eq(MoveBit(GetSnakeMove(joint_move, i))));
+          }
+        }
+
+        BoardState expected{};
+        ruleset->SetRandomSeed(seed);
+        ruleset->CreateNextBoardState(
+            state, UnpackJointMove(state, joint_move), turn, expected);
+        {
+          SCOPED_TRACE(testing::Message() << "game " << game << " turn "
+                                          << turn << " child " << child_index);
+          ExpectSameState(child, expected);
+          ASSERT_THAT(child.hash, Eq(ComputeBoardHash(child)));
+        }
+        children.push_back(child);
+      }
+
+      ASSERT_THAT(children.size(), Eq(expander.ChildrenCount()));
+      ASSERT_THAT(joint_moves.size(), Eq(children.size()));
+
+      state = children[random.Uniform(children.size())];
+    }
+  }
+}
+
+// All rulesets, and the standard ruleset with the staged turn pipeline.
+std::vector<RulesetFactory> ExpandedRulesets() {
+  std::vector<RulesetFactory> result = AllRulesets();
+  result.push_back(RulesetFactory{
+      "standard_staged", [](const StandardRuleset::Config& config) {
+        StandardRuleset::Config staged = config;
+        staged.turn_pipeline = StandardRuleset::TurnPipeline::Staged;
+        return std::make_unique<StandardRuleset>(staged);
+      }});
+  return result;
+}
+
+INSTANTIATE_TEST_SUITE_P(AllRulesets, ChildrenExpanderRandomGamesTest,
+                         testing::ValuesIn(ExpandedRulesets()),
+                         RulesetFactoryName);
+
+}  // namespace
+
+}  // namespace rules
+}  // namespace battlesnake
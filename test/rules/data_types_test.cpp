@@ -1,8 +1,12 @@
 #include "battlesnake/rules/data_types.h"
 
 #include <cstring>
+#include <string>
+#include <thread>
 #include <type_traits>
+#include <vector>
 
+#include "battlesnake/rules/random.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -56,7 +60,9 @@ using ::testing::ElementsAreArray;
 using ::testing::Eq;
 using ::testing::IsFalse;
 using ::testing::IsTrue;
+using ::testing::Gt;
 using ::testing::Le;
+using ::testing::Lt;
 
 TEST(StringPoolTest, MultipleInserts) {
   StringPool pool;
@@ -68,6 +74,74 @@ TEST(StringPoolTest, MultipleInserts) {
   EXPECT_THAT(a.value, Eq(b.value));
 }
 
+TEST(StringPoolTest, FreeUnusedSince) {
+  StringPool pool;
+  StringWrapper id = pool.Add("id");
+  pool.Add("12");
+  pool.Add("shout");
+  EXPECT_THAT(pool.Generation(), Eq(0));
+
+  const uint64_t generation = pool.NewGeneration();
+  EXPECT_THAT(generation, Eq(1));
+  EXPECT_THAT(pool.Add("id").value, Eq(id.value));
+  pool.Add("37");
+
+  EXPECT_THAT(pool.FreeUnusedSince(generation), Eq(2));
+  EXPECT_THAT(pool.Size(), Eq(2));
+  EXPECT_THAT(pool.FreeUnusedSince(generation), Eq(0));
+  EXPECT_THAT(id, Eq("id"));
+
+  StringPool::Stats stats = pool.GetStats();
+  EXPECT_THAT(stats.adds, Eq(5));
+  EXPECT_THAT(stats.hits, Eq(1));
+  EXPECT_THAT(stats.freed, Eq(2));
+}
+
+TEST(StringPoolTest, MemoryUsage) {
+  StringPool pool;
+  const size_t empty_usage = pool.MemoryUsage();
+
+  pool.Add("short");
+  const size_t short_usage = pool.MemoryUsage();
+  EXPECT_THAT(short_usage, Gt(empty_usage));
+
+  pool.Add(std::string(1000, 'x'));
+  EXPECT_THAT(pool.MemoryUsage(), Gt(short_usage + 1000));
+
+  // Index buckets are not freed, only strings.
+  pool.NewGeneration();
+  pool.FreeUnusedSince(pool.Generation());
+  EXPECT_THAT(pool.Size(), Eq(0));
+  EXPECT_THAT(pool.MemoryUsage(), Lt(empty_usage + 1000));
+}
+
+TEST(StringPoolTest, ConcurrentAdds) {
+  static constexpr int kThreadsCount = 4;
+  static constexpr int kStringsCount = 1000;
+
+  StringPool pool;
+  std::vector<std::vector<StringWrapper>> results(kThreadsCount);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreadsCount; ++t) {
+    threads.emplace_back([&pool, &result = results[t]]() {
+      for (int i = 0; i < kStringsCount; ++i) {
+        result.push_back(pool.Add(std::to_string(i)));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_THAT(pool.Size(), Eq(kStringsCount));
+  for (int t = 1; t < kThreadsCount; ++t) {
+    for (int i = 0; i < kStringsCount; ++i) {
+      ASSERT_THAT(results[t][i].value, Eq(results[0][i].value));
+    }
+  }
+  EXPECT_THAT(results[0][123], Eq("123"));
+}
+
 TEST(PodTest, SnakeIdZeroInitialization) {
   SnakeId snake_id;
   std::memset(&snake_id, 0, sizeof(snake_id));
@@ -86,6 +160,37 @@ TEST(PodTest, EliminatedCauseZeroInitialization) {
 
   EXPECT_THAT(eliminated_cause.cause, Eq(EliminatedCause::NotEliminated));
   EXPECT_THAT(eliminated_cause.by_id, Eq(""));
+  EXPECT_THAT(eliminated_cause.by_handle, Eq(kInvalidSnakeHandle));
+}
+
+TEST(PodTest, EliminatedCauseByHandle) {
+  StringPool pool;
+  EliminatedCause without_handle{
+      .cause = EliminatedCause::Collision,
+      .by_id = pool.Add("one"),
+  };
+  EXPECT_THAT(without_handle.by_handle, Eq(kInvalidSnakeHandle));
+
+  for (SnakeHandle handle : {SnakeHandle{0}, SnakeHandle{7}}) {
+    EliminatedCause with_handle{
+        .cause = EliminatedCause::Collision,
+        .by_handle = handle,
+        .by_id = pool.Add("one"),
+    };
+    EXPECT_THAT(with_handle.by_handle, Eq(handle));
+  }
+}
+
+TEST(PodTest, SnakeHandleWithoutAssignment) {
+  StringPool pool;
+  Snake snake{
+      .id = pool.Add("one"),
+      .body = SnakeBody::Create({{1, 1}}),
+  };
+  EXPECT_THAT(snake.handle, Eq(kInvalidSnakeHandle));
+
+  snake.handle = 0;
+  EXPECT_THAT(snake.handle, Eq(0));
 }
 
 TEST(PodTest, PointZeroInitialization) {
@@ -326,6 +431,58 @@ TEST(SnakeBodyTest, TailWorks) {
   EXPECT_THAT(body.TailPos(), Eq(Point{2, 3}));
 }
 
+TEST(SnakeBodyTest, TailFollowsMoves) {
+  SnakeBody body = SnakeBody::Create({
+      {1, 2},
+      {2, 2},
+      {2, 3},
+  });
+
+  body.MoveTo(Move::Left);
+  EXPECT_THAT(body.TailPos(), Eq(Point{2, 2}));
+  body.MoveTo(Move::Down);
+  EXPECT_THAT(body.TailPos(), Eq(Point{1, 2}));
+}
+
+TEST(SnakeBodyTest, TailStaysWhenStacked) {
+  SnakeBody body = SnakeBody::Create({
+      {1, 2},
+      {2, 2},
+      {2, 3},
+  });
+
+  body.IncreaseLength();
+  body.MoveTo(Move::Left);
+  EXPECT_THAT(body.TailPos(), Eq(Point{2, 3}));
+  body.MoveTo(Move::Left);
+  EXPECT_THAT(body.TailPos(), Eq(Point{2, 2}));
+}
+
+TEST(SnakeBodyTest, TailOfSinglePieceFollowsHead) {
+  SnakeBody body = SnakeBody::Create({
+      {1, 2},
+  });
+
+  body.MoveTo(Move::Up);
+  EXPECT_THAT(body.TailPos(), Eq(Point{1, 3}));
+}
+
+TEST(SnakeBodyTest, TailFollowsMovesWrapped) {
+  Point size{5, 5};
+  SnakeBody body = SnakeBody::Create(
+      {
+          {4, 0},
+          {0, 0},
+          {1, 0},
+      },
+      &size);
+
+  body.MoveTo(Move::Left);
+  EXPECT_THAT(body.TailPos(), Eq(Point{0, 0}));
+  body.MoveTo(Move::Down);
+  EXPECT_THAT(body.TailPos(), Eq(Point{4, 0}));
+}
+
 TEST(SnakeBodyTest, RealData) {
   auto data = {
       Point{.x = 4, .y = 1},   //
@@ -347,6 +504,64 @@ TEST(SnakeBodyTest, RealData) {
   EXPECT_THAT(body, ElementsAreArray(data));
 }
 
+TEST(SnakeBodyTest, RestoreCheckpointWorks) {
+  SnakeBody body = SnakeBody::Create({
+      {1, 2},
+      {2, 2},
+      {2, 3},
+  });
+
+  SnakeBody::Checkpoint checkpoint = body.SaveCheckpoint();
+  body.IncreaseLength();
+  body.MoveTo(Move::Left);
+  body.RestoreCheckpoint(checkpoint);
+
+  EXPECT_THAT(body, ElementsAreArray({
+                        Point{1, 2},
+                        Point{2, 2},
+                        Point{2, 3},
+                    }));
+  EXPECT_THAT(body.TailPos(), Eq(Point{2, 3}));
+}
+
+TEST(SnakeBodyTest, RestoreCheckpointRandomMoves) {
+  RandomGenerator random(1);
+
+  // Different lengths make MoveTo() add and drop blocks at different moves.
+  for (int length = 1; length <= 12; ++length) {
+    std::vector<Point> points;
+    for (int i = 0; i < length; ++i) {
+      points.push_back(Point{static_cast<Coordinate>(i), 0});
+    }
+    SnakeBody body = SnakeBody::Create(points);
+
+    for (int step = 0; step < 50; ++step) {
+      const SnakeBody original = body;
+      std::vector<Point> original_points;
+      for (const Point& p : body) {
+        original_points.push_back(p);
+      }
+      const int growth = random.Uniform(3) == 0 ? random.Uniform(3) : 0;
+      const Move move = static_cast<Move>(random.Uniform(4));
+
+      SnakeBody::Checkpoint checkpoint = body.SaveCheckpoint();
+      body.IncreaseLength(growth);
+      body.MoveTo(move);
+      body.RestoreCheckpoint(checkpoint);
+
+      ASSERT_THAT(body, Eq(original))
+          << "length " << length << " step " << step;
+      ASSERT_THAT(body, ElementsAreArray(original_points));
+      ASSERT_THAT(body.TailPos(), Eq(original.TailPos()));
+      ASSERT_THAT(body.moves.size(), Eq(original.moves.size()));
+
+      // Continue from the changed body.
+      body.IncreaseLength(growth);
+      body.MoveTo(move);
+    }
+  }
+}
+
 TEST(BoardBitsTest, Get) {
   BoardBits bits{
       .data = {1, 2, 3},
@@ -537,6 +752,110 @@ TEST(BoardBitsViewTest, ProdTest1) {
                       }));
 }
 
+TEST(BoardStateTest, RebuildBodies) {
+  StringPool pool;
+  BoardState state{
+      .width = kBoardSizeSmall,
+      .height = kBoardSizeSmall,
+      .snakes = SnakesVector::Create({
+          Snake{
+              .id = pool.Add("one"),
+              .body = SnakeBody::Create({{1, 1}, {1, 2}, {2, 2}}),
+          },
+          Snake{
+              .id = pool.Add("two"),
+              .body = SnakeBody::Create({{5, 5}, {5, 4}}),
+          },
+          Snake{
+              .id = pool.Add("eliminated"),
+              .body = SnakeBody::Create({{3, 3}, {3, 4}}),
+              .eliminated_cause = {.cause = EliminatedCause::Collision},
+          },
+      }),
+  };
+
+  state.RebuildBodies();
+
+  EXPECT_THAT(state.Bodies(), ElementsAreArray({
+                                  Point{1, 2},
+                                  Point{2, 2},
+                                  Point{5, 4},
+                              }));
+}
+
+TEST(BoardStateTest, EnsureBodiesKeepsExistingBodies) {
+  StringPool pool;
+  BoardState state{
+      .width = kBoardSizeSmall,
+      .height = kBoardSizeSmall,
+      .snakes = SnakesVector::Create({
+          Snake{
+              .id = pool.Add("one"),
+              .body = SnakeBody::Create({{1, 1}, {1, 2}, {2, 2}}),
+          },
+      }),
+      .bodies = CreateBoardBits({Point{6, 6}}, kBoardSizeSmall,
+                                kBoardSizeSmall),
+  };
+
+  state.EnsureBodies();
+  EXPECT_THAT(state.Bodies(), ElementsAre(Point{6, 6}));
+
+  state.bodies.clear();
+  state.EnsureBodies();
+  EXPECT_THAT(state.Bodies(), ElementsAre(Point{1, 2}, Point{2, 2}));
+}
+
+TEST(BoardStateTest, ResetDerivedData) {
+  StringPool pool;
+  BoardState state{
+      .width = kBoardSizeSmall,
+      .height = kBoardSizeSmall,
+      .snakes = SnakesVector::Create({
+          Snake{
+              .id = pool.Add("one"),
+              .body = SnakeBody::Create({{1, 1}, {1, 2}, {2, 2}}),
+          },
+      }),
+      .bodies = CreateBoardBits({Point{6, 6}}, kBoardSizeSmall,
+                                kBoardSizeSmall),
+      .hash = 12345,
+  };
+
+  state.ResetDerivedData();
+
+  EXPECT_THAT(state.Bodies(), ElementsAre(Point{1, 2}, Point{2, 2}));
+  EXPECT_THAT(state.hash, Eq(0));
+}
+
+TEST(BoardStateTest, FindSnake) {
+  StringPool pool;
+  BoardState state{
+      .width = kBoardSizeSmall,
+      .height = kBoardSizeSmall,
+      .snakes = SnakesVector::Create({
+          Snake{
+              .id = pool.Add("one"),
+              .body = SnakeBody::Create({{1, 1}}),
+          },
+          Snake{
+              .id = pool.Add("two"),
+              .body = SnakeBody::Create({{5, 5}}),
+          },
+      }),
+  };
+
+  // Hand-built snakes don't have handles yet.
+  EXPECT_THAT(state.FindSnake(0), Eq(nullptr));
+  EXPECT_THAT(state.FindSnake(1), Eq(nullptr));
+
+  state.AssignHandles();
+  ASSERT_THAT(state.FindSnake(0), Eq(&state.snakes[0]));
+  ASSERT_THAT(state.FindSnake(1), Eq(&state.snakes[1]));
+  EXPECT_THAT(state.FindSnake(2), Eq(nullptr));
+  EXPECT_THAT(state.FindSnake(kInvalidSnakeHandle), Eq(nullptr));
+}
+
 TEST(ObjectSizesTest, ObjectSizes) {
   EXPECT_THAT(sizeof(Point), Eq(2));
 
@@ -547,7 +866,7 @@ TEST(ObjectSizesTest, ObjectSizes) {
 
   // This is just for monitoring total size of BoardState. Update as needed.
   BoardState board_state;
-  EXPECT_THAT(sizeof(board_state), Eq(2232));
+  EXPECT_THAT(sizeof(board_state), Eq(2320));
   EXPECT_THAT(sizeof(board_state.food), Eq(80));
 
   EXPECT_THAT(sizeof(BoardBits), Eq(80));
@@ -0,0 +1,156 @@
+#include "battlesnake/rules/decoded_snake_body.h"
+
+#include <vector>
+
+#include "battlesnake/rules/random.h"
+#include "battlesnake/rules/standard_ruleset.h"
+#include "battlesnake/rules/wrapped_ruleset.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ruleset_test_helpers.h"
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+using ::testing::ElementsAreArray;
+using ::testing::Eq;
+
+std::vector<Point> BodyPoints(const DecodedSnakeBody& body) {
+  std::vector<Point> result;
+  for (int i = 0; i < body.Length(); ++i) {
+    result.push_back(body.At(i));
+  }
+  return result;
+}
+
+TEST(DecodedSnakeBodyTest, FromSnakeBody) {
+  DecodedSnakeBody body = DecodedSnakeBody::FromSnakeBody(SnakeBody::Create({
+      Point{1, 1},
+      Point{1, 2},
+      Point{2, 2},
+      Point{2, 3},
+      Point{2, 3},
+  }));
+
+  EXPECT_THAT(body.Length(), Eq(5));
+  EXPECT_THAT(body.HeadPos(), Eq(Point{1, 1}));
+  EXPECT_THAT(body.TailPos(), Eq(Point{2, 3}));
+  EXPECT_THAT(BodyPoints(body), ElementsAreArray({
+                                    Point{1, 1},
+                                    Point{1, 2},
+                                    Point{2, 2},
+                                    Point{2, 3},
+                                    Point{2, 3},
+                                }));
+}
+
+TEST(DecodedSnakeBodyTest, TurnsToVacate) {
+  DecodedSnakeBody body = DecodedSnakeBody::FromSnakeBody(SnakeBody::Create({
+      Point{1, 1},
+      Point{1, 2},
+      Point{2, 2},
+      Point{2, 3},
+  }));
+
+  EXPECT_THAT(body.TurnsToVacate(0), Eq(4));
+  EXPECT_THAT(body.TurnsToVacate(2), Eq(2));
+  EXPECT_THAT(body.TurnsToVacate(3), Eq(1));
+  EXPECT_THAT(body.TailPosAfter(0), Eq(Point{2, 3}));
+  EXPECT_THAT(body.TailPosAfter(1), Eq(Point{2, 2}));
+  EXPECT_THAT(body.TailPosAfter(3), Eq(Point{1, 1}));
+
+  // Stacked pieces stay at the tail until all of them leave.
+  body.IncreaseLength(2);
+  EXPECT_THAT(body.Length(), Eq(6));
+  EXPECT_THAT(body.TurnsToVacate(3), Eq(3));
+  EXPECT_THAT(body.TurnsToVacate(5), Eq(3));
+  EXPECT_THAT(body.TailPosAfter(2), Eq(Point{2, 3}));
+  EXPECT_THAT(body.TailPosAfter(3), Eq(Point{2, 2}));
+
+  body.MoveTo(Move::Left);
+  EXPECT_THAT(BodyPoints(body), ElementsAreArray({
+                                    Point{0, 1},
+                                    Point{1, 1},
+                                    Point{1, 2},
+                                    Point{2, 2},
+                                    Point{2, 3},
+                                    Point{2, 3},
+                                }));
+  EXPECT_THAT(body.TurnsToVacate(4), Eq(2));
+}
+
+// Decoded bodies follow snake bodies through random games, including eating,
+// stacked pieces and wrapping.
+class DecodedSnakeBodyRandomGamesTest : public testing::TestWithParam<bool> {};
+
+TEST_P(DecodedSnakeBodyRandomGamesTest, SameAsSnakeBody) {
+  const bool wrapped = GetParam();
+  StandardRuleset standard_ruleset(StandardRuleset::Config{
+      .food_spawn_chance = 50,
+      .minimum_food = 3,
+  });
+  WrappedRuleset wrapped_ruleset(StandardRuleset::Config{
+      .food_spawn_chance = 50,
+      .minimum_food = 3,
+  });
+  StandardRuleset& ruleset = wrapped ? wrapped_ruleset : standard_ruleset;
+  RandomGenerator random(12345);
+  StringPool pool;
+
+  for (int game = 0; game < 20; ++game) {
+    BoardState state = ruleset.CreateInitialBoardState(
+        kBoardSizeMedium, kBoardSizeMedium,
+        {pool.Add("one"), pool.Add("two"), pool.Add("three")});
+    std::vector<DecodedSnakeBody> bodies;
+    for (const Snake& snake : state.snakes) {
+      bodies.push_back(DecodedSnakeBody::FromSnakeBody(snake.body));
+    }
+
+    for (int turn = 1; !ruleset.IsGameOver(state) && turn < 300; ++turn) {
+      JointMove joint_move = 0;
+      for (int i = 0; i < state.snakes.size(); ++i) {
+        SetSnakeMove(joint_move, i, static_cast<Move>(random.Uniform(4)));
+      }
+
+      BoardState next{};
+      ruleset.CreateNextBoardStateJoint(state, joint_move, turn, next);
+
+      for (int i = 0; i < state.snakes.size(); ++i) {
+        if (state.snakes[i].IsEliminated()) {
+          continue;
+        }
+        bodies[i].MoveTo(GetSnakeMove(joint_move, i));
+        bodies[i].IncreaseLength(next.snakes[i].Length() -
+                                 state.snakes[i].Length());
+
+        const SnakeBody& body = next.snakes[i].body;
+        ASSERT_THAT(bodies[i].Length(), Eq(body.Length()));
+        std::vector<Point> points = BodyPoints(body);
+        ASSERT_THAT(BodyPoints(bodies[i]), ElementsAreArray(points));
+        EXPECT_THAT(bodies[i].TailPos(), Eq(body.TailPos()));
+
+        // First piece of the run of stacked pieces at each index leaves last.
+        for (int index = 0; index < points.size(); ++index) {
+          int first = index;
+          while (first > 0 && points[first - 1] == points[index]) {
+            --first;
+          }
+          EXPECT_THAT(bodies[i].TurnsToVacate(index),
+                      Eq(body.Length() - first));
+        }
+      }
+
+      state = next;
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Wrapped, DecodedSnakeBodyRandomGamesTest,
+                         testing::Values(false, true));
+
+}  // namespace
+
+}  // namespace rules
+}  // namespace battlesnake
@@ -0,0 +1,147 @@
+#include <memory>
+#include <vector>
+
+#include "battlesnake/rules/board_hash.h"
+#include "battlesnake/rules/errors.h"
+#include "battlesnake/rules/random.h"
+#include "battlesnake/rules/standard_ruleset.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ruleset_test_helpers.h"
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+using ::testing::Eq;
+
+// Compares everything a turn can change.
+TEST(MakeUnmakeTest, FailedApplyDoesntChangeState) {
+  StringPool pool;
+  StandardRuleset ruleset;
+  BoardState state = ruleset.CreateInitialBoardState(
+      kBoardSizeSmall, kBoardSizeSmall, {pool.Add("one"), pool.Add("two")});
+  const BoardState original = state;
+
+  // No move for the second snake.
+  EXPECT_THROW(ruleset.Apply(state,
+                             SnakeMovesVector::Create({
+                                 SnakeMove{.snake_id = state.snakes[0].id,
+                                           .move = Move::Up},
+                             }),
+                             1),
+               ErrorNoMoveFound);
+
+  ExpectSameState(state, original);
+}
+
+TEST(MakeUnmakeTest, ApplyComputesMissingHash) {
+  StringPool pool;
+  StandardRuleset ruleset;
+  BoardState state{
+      .width = kBoardSizeSmall,
+      .height = kBoardSizeSmall,
+      .snakes = SnakesVector::Create({
+          Snake{
+              .id = pool.Add("one"),
+              .body = SnakeBody::Create({{1, 1}, {1, 2}, {2, 2}}),
+              .health = 100,
+          },
+      }),
+  };
+
+  ruleset.Apply(state,
+                SnakeMovesVector::Create({
+                    SnakeMove{.snake_id = state.snakes[0].id,
+                              .move = Move::Down},
+                }),
+                1);
+
+  EXPECT_THAT(state.hash, Eq(ComputeBoardHash(state)));
+}
+
+class MakeUnmakeRandomGamesTest
+    : public testing::TestWithParam<RulesetFactory> {};
+
+// Plays random games. Every turn checks that Apply() produces the same state as
+// CreateNextBoardState() and that Undo() restores the previous state exactly.
+TEST_P(MakeUnmakeRandomGamesTest, ApplyAndUndoMatchCopies) {
+  StringPool pool;
+  std::vector<SnakeId> ids{pool.Add("a"), pool.Add("b"), pool.Add("c"),
+                           pool.Add("d")};
+  StringWrapper squads[] = {pool.Add("red"), pool.Add("blue")};
+  RandomGenerator moves_generator(1);
+
+  for (int game = 0; game < 20; ++game) {
+    std::unique_ptr<StandardRuleset> copying_ruleset =
+        GetParam().create(StandardRuleset::Config::Default());
+    std::unique_ptr<StandardRuleset> in_place_ruleset =
+        GetParam().create(StandardRuleset::Config::Default());
+    copying_ruleset->SetRandomSeed(game + 1);
+
+    BoardState state = copying_ruleset->CreateInitialBoardState(
+        kBoardSizeSmall, kBoardSizeSmall, ids);
+    for (int i = 0; i < state.snakes.size(); ++i) {
+      state.snakes[i].squad = squads[i % 2];
+    }
+    BoardState in_place_state = state;
+
+    for (int turn = 1; turn < 200 && !copying_ruleset->IsGameOver(state);
+         ++turn) {
+      SnakeMovesVector moves{};
+      for (const Snake& snake : state.snakes) {
+        moves.push_back(SnakeMove{
+            .snake_id = snake.id,
+            .move = static_cast<Move>(moves_generator.Uniform(4)),
+        });
+      }
+
+      // Both rulesets produce the same random numbers.
+      const uint64_t seed = game * 1000 + turn;
+      copying_ruleset->SetRandomSeed(seed);
+      in_place_ruleset->SetRandomSeed(seed);
+
+      BoardState next_state{};
+      copying_ruleset->CreateNextBoardState(state, moves, turn, next_state);
+
+      // Moves addressed by index must give the same result.
+      UndoRecord undo =
+          turn % 2 == 0
+              ? in_place_ruleset->Apply(in_place_state, moves, turn)
+              : in_place_ruleset->ApplyJoint(
+                    in_place_state, PackJointMove(in_place_state, moves), turn);
+      {
+        SCOPED_TRACE(testing::Message()
+                     << "apply, game " << game << " turn " << turn);
+        ExpectSameState(in_place_state, next_state);
+        ASSERT_THAT(in_place_state.hash, Eq(ComputeBoardHash(in_place_state)));
+      }
+
+      in_place_ruleset->Undo(in_place_state, undo);
+      {
+        SCOPED_TRACE(testing::Message()
+                     << "undo, game " << game << " turn " << turn);
+        ExpectSameState(in_place_state, state);
+      }
+
+      // Continue in place, Undo() must work for any number of moves made.
+      in_place_ruleset->SetRandomSeed(seed);
+      in_place_ruleset->Apply(in_place_state, moves, turn);
+      state = next_state;
+    }
+    {
+      SCOPED_TRACE(testing::Message() << "end of game " << game);
+      ExpectSameState(in_place_state, state);
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(AllRulesets, MakeUnmakeRandomGamesTest,
+                         testing::ValuesIn(AllRulesets()),
+                         RulesetFactoryName);
+
+}  // namespace
+
+}  // namespace rules
+}  // namespace battlesnake
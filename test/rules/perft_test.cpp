@@ -0,0 +1,160 @@
+#include "battlesnake/rules/perft.h"
+
+#include "battlesnake/rules/constrictor_ruleset.h"
+#include "battlesnake/rules/royale_ruleset.h"
+#include "battlesnake/rules/standard_ruleset.h"
+#include "battlesnake/rules/wrapped_ruleset.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+using ::testing::Eq;
+
+// Food spawn is disabled, so counts don't depend on random numbers.
+constexpr StandardRuleset::Config kConfig{
+    .food_spawn_chance = 0,
+    .minimum_food = 0,
+    .random_seed = 1,
+};
+
+// Two snakes close enough to collide and eat within a few turns. The first
+// one is next to the edge.
+BoardState CreateStart(StringPool& pool,
+                       const Point* wrapped_board_size = nullptr) {
+  return BoardState{
+      .width = kBoardSizeSmall,
+      .height = kBoardSizeSmall,
+      .food = CreateBoardBits({Point{3, 3}, Point{0, 6}}, kBoardSizeSmall,
+                              kBoardSizeSmall),
+      .snakes = SnakesVector::Create({
+          Snake{
+              .id = pool.Add("one"),
+              .body = SnakeBody::Create(
+                  {
+                      Point{0, 5},
+                      Point{0, 4},
+                      Point{0, 3},
+                  },
+                  wrapped_board_size),
+              .health = 100,
+          },
+          Snake{
+              .id = pool.Add("two"),
+              .body = SnakeBody::Create(
+                  {
+                      Point{4, 3},
+                      Point{5, 3},
+                      Point{6, 3},
+                  },
+                  wrapped_board_size),
+              .health = 100,
+          },
+      }),
+  };
+}
+
+TEST(PerftTest, ZeroDepth) {
+  StringPool pool;
+  StandardRuleset ruleset(kConfig);
+  EXPECT_THAT(Perft(ruleset, CreateStart(pool), 0), Eq(PerftCounts{}));
+}
+
+TEST(PerftTest, SingleTurn) {
+  StringPool pool;
+  StandardRuleset ruleset(kConfig);
+  EXPECT_THAT(Perft(ruleset, CreateStart(pool), 1),
+              Eq(PerftCounts{
+                  .nodes = 16,
+                  .terminal_nodes = 10,
+                  .leaf_nodes = 6,
+              }));
+}
+
+// Counts nodes with CreateNextBoardStateJoint() instead of ChildrenExpander.
+PerftCounts NaivePerft(StandardRuleset& ruleset, const BoardState& state,
+                       int depth, int turn) {
+  PerftCounts counts;
+  const int joint_moves_count = 1 << (2 * state.snakes.size());
+  for (int joint_move = 0; joint_move < joint_moves_count; ++joint_move) {
+    BoardState child{};
+    ruleset.CreateNextBoardStateJoint(state, static_cast<JointMove>(joint_move),
+                                      turn, child);
+    ++counts.nodes;
+    if (ruleset.IsGameOver(child)) {
+      ++counts.terminal_nodes;
+    } else if (depth == 1) {
+      ++counts.leaf_nodes;
+    } else {
+      PerftCounts child_counts =
+          NaivePerft(ruleset, child, depth - 1, turn + 1);
+      counts.nodes += child_counts.nodes;
+      counts.terminal_nodes += child_counts.terminal_nodes;
+      counts.leaf_nodes += child_counts.leaf_nodes;
+    }
+  }
+  return counts;
+}
+
+TEST(PerftTest, SameAsCreateNextBoardState) {
+  StringPool pool;
+  StandardRuleset ruleset(kConfig);
+  EXPECT_THAT(Perft(ruleset, CreateStart(pool), 4),
+              Eq(NaivePerft(ruleset, CreateStart(pool), 4, 1)));
+}
+
+TEST(PerftTest, Standard) {
+  StringPool pool;
+  StandardRuleset ruleset(kConfig);
+  EXPECT_THAT(Perft(ruleset, CreateStart(pool), 5),
+              Eq(PerftCounts{
+                  .nodes = 30288,
+                  .terminal_nodes = 18543,
+                  .leaf_nodes = 9853,
+              }));
+}
+
+TEST(PerftTest, Wrapped) {
+  StringPool pool;
+  WrappedRuleset ruleset(kConfig);
+  const Point board_size{kBoardSizeSmall, kBoardSizeSmall};
+  EXPECT_THAT(Perft(ruleset, CreateStart(pool, &board_size), 5),
+              Eq(PerftCounts{
+                  .nodes = 108528,
+                  .terminal_nodes = 51560,
+                  .leaf_nodes = 50186,
+              }));
+}
+
+TEST(PerftTest, Royale) {
+  StringPool pool;
+  RoyaleRuleset ruleset(kConfig, RoyaleRuleset::RoyaleConfig{
+                                     .shrink_every_n_turns = 2,
+                                     .extra_damage_per_turn = 100,
+                                 });
+  EXPECT_THAT(Perft(ruleset, CreateStart(pool), 5),
+              Eq(PerftCounts{
+                  .nodes = 23168,
+                  .terminal_nodes = 16358,
+                  .leaf_nodes = 5363,
+              }));
+}
+
+TEST(PerftTest, Constrictor) {
+  StringPool pool;
+  ConstrictorRuleset ruleset(kConfig);
+  EXPECT_THAT(Perft(ruleset, CreateStart(pool), 5),
+              Eq(PerftCounts{
+                  .nodes = 21680,
+                  .terminal_nodes = 15591,
+                  .leaf_nodes = 4735,
+              }));
+}
+
+}  // namespace
+
+}  // namespace rules
+}  // namespace battlesnake
@@ -0,0 +1,133 @@
+#include "battlesnake/rules/random.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "battlesnake/rules/standard_ruleset.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+using ::testing::Each;
+using ::testing::ElementsAreArray;
+using ::testing::Eq;
+using ::testing::Gt;
+using ::testing::Lt;
+using ::testing::Ne;
+using ::testing::UnorderedElementsAreArray;
+
+std::vector<uint64_t> Generate(RandomGenerator& generator, int n) {
+  std::vector<uint64_t> result;
+  for (int i = 0; i < n; ++i) {
+    result.push_back(generator.Next());
+  }
+  return result;
+}
+
+TEST(RandomGeneratorTest, SameSeedSameSequence) {
+  RandomGenerator a(12345);
+  RandomGenerator b(12345);
+
+  EXPECT_THAT(Generate(a, 100), ElementsAreArray(Generate(b, 100)));
+}
+
+TEST(RandomGeneratorTest, DifferentSeedsDifferentSequences) {
+  RandomGenerator a(1);
+  RandomGenerator b(2);
+
+  EXPECT_THAT(Generate(a, 10), Ne(Generate(b, 10)));
+}
+
+TEST(RandomGeneratorTest, ReseedRestartsSequence) {
+  RandomGenerator generator(42);
+  std::vector<uint64_t> first = Generate(generator, 10);
+
+  generator.Seed(42);
+  EXPECT_THAT(Generate(generator, 10), ElementsAreArray(first));
+}
+
+TEST(RandomGeneratorTest, UniformCoversWholeRange) {
+  RandomGenerator generator(7);
+  constexpr int kMaxValue = 11;
+
+  std::vector<int> counts(kMaxValue, 0);
+  for (int i = 0; i < 11000; ++i) {
+    int v = generator.Uniform(kMaxValue);
+    ASSERT_THAT(v, Lt(kMaxValue));
+    ASSERT_THAT(v, Gt(-1));
+    counts[v]++;
+  }
+
+  // Each value is expected ~1000 times.
+  EXPECT_THAT(counts, Each(Gt(800)));
+  EXPECT_THAT(counts, Each(Lt(1200)));
+}
+
+TEST(RandomGeneratorTest, UniformOfOneIsZero) {
+  RandomGenerator generator(7);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_THAT(generator.Uniform(1), Eq(0));
+  }
+}
+
+TEST(RandomGeneratorTest, ShufflePreservesElements) {
+  RandomGenerator generator(3);
+  std::vector<int> data{1, 2, 3, 4, 5, 6, 7, 8};
+  std::vector<int> shuffled = data;
+
+  generator.Shuffle(shuffled.begin(), shuffled.end());
+
+  EXPECT_THAT(shuffled, UnorderedElementsAreArray(data));
+}
+
+TEST(RandomGeneratorTest, WorksWithStandardAlgorithms) {
+  RandomGenerator generator(3);
+  std::vector<int> data{1, 2, 3, 4, 5, 6, 7, 8};
+  std::vector<int> shuffled = data;
+
+  std::shuffle(shuffled.begin(), shuffled.end(), generator);
+
+  EXPECT_THAT(shuffled, UnorderedElementsAreArray(data));
+}
+
+TEST(RulesetRandomSeedTest, SameSeedSameGame) {
+  StringPool pool;
+  std::vector<SnakeId> ids{pool.Add("one"), pool.Add("two")};
+  SnakeMovesVector moves = SnakeMovesVector::Create({
+      {pool.Add("one"), Move::Up},
+      {pool.Add("two"), Move::Down},
+  });
+  StandardRuleset::Config config{
+      .food_spawn_chance = 100,
+      .random_seed = 2022,
+  };
+
+  StandardRuleset ruleset_a(config);
+  StandardRuleset ruleset_b(config);
+
+  BoardState state_a = ruleset_a.CreateInitialBoardState(
+      kBoardSizeMedium, kBoardSizeMedium, ids);
+  BoardState state_b = ruleset_b.CreateInitialBoardState(
+      kBoardSizeMedium, kBoardSizeMedium, ids);
+  for (int turn = 1; turn <= 3; ++turn) {
+    ASSERT_THAT(state_a.food, Eq(state_b.food));
+    ASSERT_THAT(state_a.snakes[0].body, Eq(state_b.snakes[0].body));
+    ASSERT_THAT(state_a.snakes[1].body, Eq(state_b.snakes[1].body));
+
+    BoardState next_a{};
+    BoardState next_b{};
+    ruleset_a.CreateNextBoardState(state_a, moves, turn, next_a);
+    ruleset_b.CreateNextBoardState(state_b, moves, turn, next_b);
+    state_a = next_a;
+    state_b = next_b;
+  }
+}
+
+}  // namespace
+
+}  // namespace rules
+}  // namespace battlesnake
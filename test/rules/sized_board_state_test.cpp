@@ -0,0 +1,410 @@
+#include "battlesnake/rules/sized_board_state.h"
+
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "battlesnake/rules/board_hash.h"
+#include "battlesnake/rules/children_expander.h"
+#include "battlesnake/rules/random.h"
+#include "battlesnake/rules/sized_standard_ruleset.h"
+#include "battlesnake/rules/standard_ruleset.h"
+#include "battlesnake/rules/wrapped_ruleset.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ruleset_test_helpers.h"
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+using ::testing::Eq;
+using ::testing::IsFalse;
+using ::testing::IsTrue;
+using ::testing::Le;
+
+using Dimensions = std::tuple<int, int, int>;
+
+Dimensions Dispatched(Coordinate width, Coordinate height, int snakes_count) {
+  return DispatchBoardSize(width, height, snakes_count,
+                           []<Coordinate W, Coordinate H, int N>() {
+                             return Dimensions{W, H, N};
+                           });
+}
+
+TEST(SizedBoardStateTest, Sizes) {
+  EXPECT_THAT((BoardStateT<kBoardSizeMedium, kBoardSizeMedium,
+                           kSnakesCountStandard>::Bits::kBlocksCount),
+              Eq(2));
+  EXPECT_THAT((BoardStateT<kBoardSizeSmall, kBoardSizeSmall,
+                           kSnakesCountDuel>::Bits::kBlocksCount),
+              Eq(1));
+
+  // This is just for monitoring, update as needed.
+  EXPECT_THAT(sizeof(BoardStateT<kBoardSizeMedium, kBoardSizeMedium,
+                                 kSnakesCountStandard>),
+              Le(sizeof(BoardState) / 4));
+  EXPECT_THAT(sizeof(BoardStateT<kBoardSizeMedium, kBoardSizeMedium,
+                                 kSnakesCountDuel>),
+              Le(sizeof(BoardState) / 8));
+  EXPECT_THAT(sizeof(BoardStateT<kBoardSizeMedium, kBoardSizeMedium,
+                                 kSnakesCountStandard>::UndoRecord),
+              Le(sizeof(UndoRecord) / 2));
+}
+
+// Only values used by rulesets are kept.
+TEST(SizedBoardStateTest, ApiValuesAreDropped) {
+  StringPool pool;
+  BoardState state{
+      .width = kBoardSizeSmall,
+      .height = kBoardSizeSmall,
+      .snakes = SnakesVector::Create({
+          Snake{
+              .id = pool.Add("one"),
+              .body = SnakeBody::Create({Point{1, 1}, Point{1, 2}}),
+              .health = 100,
+              .name = pool.Add("Snake"),
+              .latency = 123,
+              .shout = pool.Add("Hi"),
+              .squad = pool.Add("red"),
+          },
+      }),
+  };
+
+  const BoardState converted =
+      BoardStateT<kBoardSizeSmall, kBoardSizeSmall, kSnakesCountDuel>::
+          FromBoardState(state)
+              .ToBoardState();
+  const Snake& snake = converted.snakes[0];
+  EXPECT_THAT(snake.id, Eq("one"));
+  EXPECT_THAT(snake.squad, Eq("red"));
+  EXPECT_THAT(snake.name, Eq(""));
+  EXPECT_THAT(snake.latency, Eq(0));
+  EXPECT_THAT(snake.shout, Eq(""));
+}
+
+TEST(SizedBoardStateTest, DispatchBoardSize) {
+  EXPECT_THAT(Dispatched(kBoardSizeMedium, kBoardSizeMedium, 4),
+              Eq(Dimensions{11, 11, 4}));
+  EXPECT_THAT(Dispatched(kBoardSizeMedium, kBoardSizeMedium, 3),
+              Eq(Dimensions{11, 11, 4}));
+  EXPECT_THAT(Dispatched(kBoardSizeMedium, kBoardSizeMedium, 2),
+              Eq(Dimensions{11, 11, 2}));
+  EXPECT_THAT(Dispatched(kBoardSizeSmall, kBoardSizeSmall, 1),
+              Eq(Dimensions{7, 7, 2}));
+  EXPECT_THAT(Dispatched(kBoardSizeSmall, kBoardSizeSmall, 4),
+              Eq(Dimensions{7, 7, 4}));
+
+  // Generic fallback.
+  EXPECT_THAT(Dispatched(kBoardSizeMedium, kBoardSizeMedium, 5),
+              Eq(Dimensions{0, 0, 0}));
+  EXPECT_THAT(Dispatched(kBoardSizeLarge, kBoardSizeLarge, 2),
+              Eq(Dimensions{0, 0, 0}));
+  EXPECT_THAT(Dispatched(kBoardSizeMedium, kBoardSizeSmall, 2),
+              Eq(Dimensions{0, 0, 0}));
+}
+
+TEST(SizedBoardStateTest, DispatchBoardState) {
+  StringPool pool;
+  StandardRuleset ruleset;
+  BoardState state = ruleset.CreateInitialBoardState(
+      kBoardSizeMedium, kBoardSizeMedium, {pool.Add("a"), pool.Add("b")});
+
+  int snakes_count = DispatchBoardSize(
+      state, [&state]<Coordinate W, Coordinate H, int N>() {
+        if constexpr (W == kGenericBoardSize) {
+          return -1;
+        } else {
+          return static_cast<int>(
+              BoardStateT<W, H, N>::FromBoardState(state).snakes.size());
+        }
+      });
+  EXPECT_THAT(snakes_count, Eq(2));
+}
+
+TEST(SizedBoardStateTest, Fits) {
+  using State =
+      BoardStateT<kBoardSizeSmall, kBoardSizeSmall, kSnakesCountDuel>;
+  StringPool pool;
+  BoardState state{
+      .width = kBoardSizeSmall,
+      .height = kBoardSizeSmall,
+      .snakes = SnakesVector::Create({
+          Snake{.id = pool.Add("a"), .body = SnakeBody::Create({{1, 1}})},
+      }),
+  };
+  EXPECT_THAT(State::Fits(state), IsTrue());
+
+  state.snakes.push_back(Snake{.id = pool.Add("b")});
+  state.snakes.push_back(Snake{.id = pool.Add("c")});
+  EXPECT_THAT(State::Fits(state), IsFalse());
+
+  state.snakes.resize(1);
+  state.width = kBoardSizeMedium;
+  EXPECT_THAT(State::Fits(state), IsFalse());
+}
+
+struct RoundTripParams {
+  const char* name;
+  Coordinate size;
+  int snakes_count;
+  std::function<std::unique_ptr<StandardRuleset>()> create;
+};
+
+void PrintTo(const RoundTripParams& params, std::ostream* os) {
+  *os << params.name;
+}
+
+class SizedBoardStateRoundTripTest
+    : public testing::TestWithParam<RoundTripParams> {};
+
+// Plays random games, converting the state to the specialization and back
+// every turn. Converted state must be the same and play the same.
+TEST_P(SizedBoardStateRoundTripTest, RandomGames) {
+  const RoundTripParams& params = GetParam();
+  StringPool pool;
+  std::vector<SnakeId> ids;
+  for (int i = 0; i < params.snakes_count; ++i) {
+    ids.push_back(pool.Add("snake" + std::to_string(i)));
+  }
+  StringWrapper squad = pool.Add("squad");
+  RandomGenerator moves_generator(1);
+
+  for (int game = 0; game < 20; ++game) {
+    std::unique_ptr<StandardRuleset> ruleset = params.create();
+    ruleset->SetRandomSeed(game + 1);
+    BoardState state =
+        ruleset->CreateInitialBoardState(params.size, params.size, ids);
+    state.snakes[0].squad = squad;
+
+    for (int turn = 1; turn < 200 && !ruleset->IsGameOver(state); ++turn) {
+      BoardState converted = DispatchBoardSize(
+          state, [&state]<Coordinate W, Coordinate H, int N>() {
+            if constexpr (W == kGenericBoardSize) {
+              ADD_FAILURE() << "not specialized";
+              return state;
+            } else {
+              return BoardStateT<W, H, N>::FromBoardState(state)
+                  .ToBoardState();
+            }
+          });
+      {
+        SCOPED_TRACE(testing::Message() << "game " << game << " turn " << turn);
+        ExpectSameState(converted, state);
+      }
+
+      SnakeMovesVector moves{};
+      for (const Snake& snake : state.snakes) {
+        moves.push_back(SnakeMove{
+            .snake_id = snake.id,
+            .move = static_cast<Move>(moves_generator.Uniform(4)),
+        });
+      }
+
+      const uint64_t seed = game * 1000 + turn;
+      BoardState next_state{};
+      ruleset->SetRandomSeed(seed);
+      ruleset->CreateNextBoardState(state, moves, turn, next_state);
+      BoardState next_converted{};
+      ruleset->SetRandomSeed(seed);
+      ruleset->CreateNextBoardState(converted, moves, turn, next_converted);
+      {
+        SCOPED_TRACE(testing::Message()
+                     << "next, game " << game << " turn " << turn);
+        ExpectSameState(next_converted, next_state);
+      }
+      state = next_state;
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Sizes, SizedBoardStateRoundTripTest,
+    testing::Values(
+        RoundTripParams{"standard_medium_4", kBoardSizeMedium, 4,
+                        []() { return std::make_unique<StandardRuleset>(); }},
+        RoundTripParams{"standard_small_2", kBoardSizeSmall, 2,
+                        []() { return std::make_unique<StandardRuleset>(); }},
+        RoundTripParams{"wrapped_medium_2", kBoardSizeMedium, 2,
+                        []() { return std::make_unique<WrappedRuleset>(); }},
+        RoundTripParams{"wrapped_small_3", kBoardSizeSmall, 3,
+                        []() { return std::make_unique<WrappedRuleset>(); }}),
+    [](const testing::TestParamInfo<RoundTripParams>& info) {
+      return std::string(info.param.name);
+    });
+
+struct SizedRulesParams {
+  const char* name;
+  Coordinate size;
+  int snakes_count;
+  StandardRuleset::TurnPipeline turn_pipeline;
+};
+
+void PrintTo(const SizedRulesParams& params, std::ostream* os) {
+  *os << params.name;
+}
+
+class SizedStandardRulesetTest
+    : public testing::TestWithParam<SizedRulesParams> {
+ protected:
+  // Calls `f.template operator()<W, H, N>()` with the specialization for the
+  // parameters.
+  template <class F>
+  void Dispatch(F&& f) {
+    const SizedRulesParams& params = GetParam();
+    DispatchBoardSize(params.size, params.size, params.snakes_count,
+                      [&f]<Coordinate W, Coordinate H, int N>() {
+                        if constexpr (W == kGenericBoardSize) {
+                          ADD_FAILURE() << "not specialized";
+                        } else {
+                          f.template operator()<W, H, N>();
+                        }
+                      });
+  }
+
+  std::vector<SnakeId> CreateIds(StringPool& pool) {
+    std::vector<SnakeId> ids;
+    for (int i = 0; i < GetParam().snakes_count; ++i) {
+      ids.push_back(pool.Add("snake" + std::to_string(i)));
+    }
+    return ids;
+  }
+
+  StandardRuleset::Config CreateConfig() {
+    return StandardRuleset::Config{.turn_pipeline = GetParam().turn_pipeline};
+  }
+
+  static JointMove RandomJointMove(RandomGenerator& random, int snakes_count) {
+    JointMove result = 0;
+    for (int i = 0; i < snakes_count; ++i) {
+      SetSnakeMove(result, i, static_cast<Move>(random.Uniform(4)));
+    }
+    return result;
+  }
+};
+
+// Sized states must play exactly the same games as BoardState, both with new
+// states and in place.
+TEST_P(SizedStandardRulesetTest, PlaysSameGames) {
+  Dispatch([this]<Coordinate W, Coordinate H, int N>() {
+    using State = BoardStateT<W, H, N>;
+    StringPool pool;
+    const std::vector<SnakeId> ids = CreateIds(pool);
+    RandomGenerator moves_generator(1);
+
+    for (int game = 0; game < 20; ++game) {
+      StandardRuleset ruleset(CreateConfig());
+      StandardRulesetT<W, H, N> sized_ruleset(CreateConfig());
+      ruleset.SetRandomSeed(game + 1);
+      BoardState state = ruleset.CreateInitialBoardState(W, H, ids);
+      State sized_state = State::FromBoardState(state);
+
+      for (int turn = 1; turn < 200 && !ruleset.IsGameOver(state); ++turn) {
+        SCOPED_TRACE(testing::Message() << "game " << game << " turn " << turn);
+        EXPECT_THAT(sized_ruleset.IsGameOver(sized_state), IsFalse());
+        const JointMove joint_move =
+            RandomJointMove(moves_generator, ids.size());
+        const uint64_t seed = game * 1000 + turn;
+
+        BoardState next_state{};
+        ruleset.SetRandomSeed(seed);
+        ruleset.CreateNextBoardStateJoint(state, joint_move, turn, next_state);
+        State sized_next_state{};
+        sized_ruleset.SetRandomSeed(seed);
+        sized_ruleset.CreateNextBoardStateJoint(sized_state, joint_move, turn,
+                                                sized_next_state);
+        ExpectSameState(sized_next_state.ToBoardState(), next_state);
+
+        State applied = sized_state;
+        sized_ruleset.SetRandomSeed(seed);
+        const typename State::UndoRecord undo =
+            sized_ruleset.ApplyJoint(applied, joint_move, turn);
+        ExpectSameState(applied.ToBoardState(), next_state);
+        sized_ruleset.Undo(applied, undo);
+        ExpectSameState(applied.ToBoardState(), state);
+
+        state = next_state;
+        sized_state = sized_next_state;
+      }
+      EXPECT_THAT(sized_ruleset.IsGameOver(sized_state),
+                  Eq(ruleset.IsGameOver(state)));
+    }
+  });
+}
+
+// Children of sized states must be the same as children of BoardState.
+TEST_P(SizedStandardRulesetTest, ExpandsSameChildren) {
+  Dispatch([this]<Coordinate W, Coordinate H, int N>() {
+    using State = BoardStateT<W, H, N>;
+    StringPool pool;
+    const std::vector<SnakeId> ids = CreateIds(pool);
+    RandomGenerator moves_generator(1);
+
+    for (int game = 0; game < 5; ++game) {
+      StandardRuleset ruleset(CreateConfig());
+      StandardRulesetT<W, H, N> sized_ruleset(CreateConfig());
+      ruleset.SetRandomSeed(game + 1);
+      BoardState state = ruleset.CreateInitialBoardState(W, H, ids);
+
+      for (int turn = 1; turn < 100 && !ruleset.IsGameOver(state); ++turn) {
+        SCOPED_TRACE(testing::Message() << "game " << game << " turn " << turn);
+        ChildrenExpander expander =
+            ExpandChildren(ruleset, state, MoveMasksVector{}, turn);
+        auto sized_expander =
+            ExpandChildren(sized_ruleset, State::FromBoardState(state),
+                           MoveMasksVector{}, turn);
+        ASSERT_THAT(sized_expander.ChildrenCount(),
+                    Eq(expander.ChildrenCount()));
+
+        JointMove joint_move = 0;
+        BoardState child{};
+        JointMove sized_joint_move = 0;
+        State sized_child{};
+        for (int i = 0; i < expander.ChildrenCount(); ++i) {
+          const uint64_t seed = (game * 1000 + turn) * 1000 + i;
+          ruleset.SetRandomSeed(seed);
+          ASSERT_THAT(expander.Next(joint_move, child), IsTrue());
+          sized_ruleset.SetRandomSeed(seed);
+          ASSERT_THAT(sized_expander.Next(sized_joint_move, sized_child),
+                      IsTrue());
+          EXPECT_THAT(sized_joint_move, Eq(joint_move));
+          ExpectSameState(sized_child.ToBoardState(), child);
+        }
+        EXPECT_THAT(sized_expander.Next(sized_joint_move, sized_child),
+                    IsFalse());
+
+        BoardState next_state{};
+        ruleset.CreateNextBoardStateJoint(
+            state, RandomJointMove(moves_generator, ids.size()), turn,
+            next_state);
+        state = next_state;
+      }
+    }
+  });
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Sizes, SizedStandardRulesetTest,
+    testing::Values(
+        SizedRulesParams{"medium_4_fused", kBoardSizeMedium, 4,
+                         StandardRuleset::TurnPipeline::Fused},
+        SizedRulesParams{"medium_4_staged", kBoardSizeMedium, 4,
+                         StandardRuleset::TurnPipeline::Staged},
+        SizedRulesParams{"medium_3_fused", kBoardSizeMedium, 3,
+                         StandardRuleset::TurnPipeline::Fused},
+        SizedRulesParams{"medium_2_fused", kBoardSizeMedium, 2,
+                         StandardRuleset::TurnPipeline::Fused},
+        SizedRulesParams{"small_2_fused", kBoardSizeSmall, 2,
+                         StandardRuleset::TurnPipeline::Fused},
+        SizedRulesParams{"small_4_staged", kBoardSizeSmall, 4,
+                         StandardRuleset::TurnPipeline::Staged}),
+    [](const testing::TestParamInfo<SizedRulesParams>& info) {
+      return std::string(info.param.name);
+    });
+
+}  // namespace
+
+}  // namespace rules
+}  // namespace battlesnake
@@ -136,6 +136,11 @@ TEST_F(SquadCreateNextBoardStateTest, SameSquadDontCollide) {
 
   EXPECT_THAT(state.snakes, UnorderedElementsAre(SnakeIsNotEliminated("one"),
                                                  SnakeIsNotEliminated("two")));
+  // Collision causes are cleared entirely.
+  for (const Snake& snake : state.snakes) {
+    EXPECT_THAT(snake.eliminated_cause.by_id, Eq(""));
+    EXPECT_THAT(snake.eliminated_cause.by_handle, Eq(kInvalidSnakeHandle));
+  }
 }
 
 TEST_F(SquadCreateNextBoardStateTest, DifferentSquadCollide) {
@@ -311,6 +316,9 @@ TEST_F(SquadCreateNextBoardStateTest, ShareElimination) {
       state.snakes,
       UnorderedElementsAre(SnakeIs("one", _, _, EliminatedCause::BySquad),
                            SnakeIs("two", _, _, EliminatedCause::OutOfBounds)));
+  for (const Snake& snake : state.snakes) {
+    EXPECT_THAT(snake.eliminated_cause.by_handle, Eq(kInvalidSnakeHandle));
+  }
 }
 
 class SquadIsGameOverTest : public SquadRulesetTest {};
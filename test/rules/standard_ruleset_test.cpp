@@ -120,6 +120,9 @@ class StandardCreateInitialBoardStateTest : public StandardRulesetTest {
     for (const Snake& snake : state.snakes) {
       EXPECT_THAT(snake.body.size(), Eq(3));
     }
+    for (int i = 0; i < state.snakes.size(); ++i) {
+      EXPECT_THAT(state.snakes[i].handle, Eq(i));
+    }
   }
 };
 
@@ -633,6 +636,47 @@ TEST_F(StandardCreateNextBoardStateTest, MovesHeadUnknownContinue) {
               ElementsAre(SnakeBodyIs(ElementsAre(Point{1, 0}, _, _))));
 }
 
+TEST_F(StandardCreateNextBoardStateTest, MovesByJointMove) {
+  StringPool pool;
+  BoardState initial_state{
+      .width = kBoardSizeSmall,
+      .height = kBoardSizeSmall,
+      .snakes = SnakesVector::Create({
+          Snake{
+              .id = pool.Add("one"),
+              .body = SnakeBody::Create({Point{1, 1}, Point{1, 2}}),
+              .health = 100,
+          },
+          Snake{
+              .id = pool.Add("two"),
+              .body = SnakeBody::Create({Point{5, 5}, Point{5, 4}}),
+              .health = 100,
+              .eliminated_cause = {.cause = EliminatedCause::OutOfHealth},
+          },
+          Snake{
+              .id = pool.Add("three"),
+              .body = SnakeBody::Create({Point{4, 1}, Point{4, 2}}),
+              .health = 100,
+          },
+      }),
+  };
+
+  JointMove joint_move = 0;
+  SetSnakeMove(joint_move, 0, Move::Left);
+  // Ignored for the eliminated snake.
+  SetSnakeMove(joint_move, 1, Move::Right);
+  SetSnakeMove(joint_move, 2, Move::Down);
+
+  StandardRuleset ruleset(StandardRuleset::Config{.food_spawn_chance = 0});
+  BoardState state{};
+  ruleset.CreateNextBoardStateJoint(initial_state, joint_move, 0, state);
+
+  EXPECT_THAT(state.snakes,
+              ElementsAre(SnakeBodyIs(ElementsAre(Point{0, 1}, Point{1, 1})),
+                          SnakeBodyIs(ElementsAre(Point{5, 5}, Point{5, 4})),
+                          SnakeBodyIs(ElementsAre(Point{4, 0}, Point{4, 1}))));
+}
+
 TEST_F(StandardCreateNextBoardStateTest, MovesHeadUnknownUp) {
   StringPool pool;
   BoardState initial_state{
@@ -990,6 +1034,43 @@ TEST_F(StandardCreateNextBoardStateTest, SpawnFoodMinimum) {
   EXPECT_THAT(state.Food().Count(), Eq(7));
 }
 
+TEST_F(StandardCreateNextBoardStateTest, SpawnFoodOnlyInFreeCells) {
+  StringPool pool;
+  BoardState initial_state{
+      .width = 3,
+      .height = 3,
+      .snakes = SnakesVector::Create({
+          Snake{
+              .id = pool.Add("one"),
+              .body = SnakeBody::Create({
+                  Point{0, 2},
+                  Point{0, 1},
+                  Point{1, 1},
+                  Point{2, 1},
+                  Point{2, 0},
+                  Point{1, 0},
+                  Point{0, 0},
+              }),
+              .health = 100,
+          },
+      }),
+  };
+
+  // More food than there is room for.
+  StandardRuleset ruleset(StandardRuleset::Config{
+      .minimum_food = 5,
+  });
+  BoardState state{};
+  ruleset.CreateNextBoardState(
+      initial_state, SnakeMovesVector::Create({{pool.Add("one"), Move::Right}}),
+      0, state);
+
+  // Tail has left {0, 0}, head took {1, 2}.
+  EXPECT_THAT(state.Food().Count(), Eq(2));
+  EXPECT_THAT(state.Food().Get(Point{0, 0}), IsTrue());
+  EXPECT_THAT(state.Food().Get(Point{2, 2}), IsTrue());
+}
+
 TEST_F(StandardCreateNextBoardStateTest, EatingOnLastMove) {
   // We want to specifically ensure that snakes eating food on their last turn
   // survive.
@@ -1410,6 +1491,58 @@ TEST_F(StandardEliminateSnakesTest, OtherBodyCollision) {
                   pool.Add("one"))));
 }
 
+TEST_F(StandardEliminateSnakesTest, EliminatedByHandle) {
+  StringPool pool;
+  BoardState initial_state{
+      .width = kBoardSizeSmall,
+      .height = kBoardSizeSmall,
+      .snakes = SnakesVector::Create({
+          Snake{
+              .id = pool.Add("zero"),
+              .body = SnakeBody::Create({
+                  Point{5, 5},
+                  Point{5, 6},
+                  Point{5, 6},
+              }),
+              .health = 100,
+          },
+          Snake{
+              .id = pool.Add("one"),
+              .body = SnakeBody::Create({
+                  Point{1, 1},
+                  Point{1, 2},
+                  Point{1, 3},
+              }),
+              .health = 100,
+          },
+          Snake{
+              .id = pool.Add("two"),
+              .body = SnakeBody::Create({
+                  Point{2, 1},
+                  Point{2, 2},
+                  Point{2, 3},
+              }),
+              .health = 100,
+          },
+      }),
+  };
+
+  StandardRuleset ruleset;
+  BoardState state{};
+  ruleset.CreateNextBoardState(initial_state,
+                               SnakeMovesVector::Create({
+                                   {pool.Add("zero"), Move::Down},
+                                   {pool.Add("one"), Move::Down},
+                                   {pool.Add("two"), Move::Left},
+                               }),
+                               0, state);
+
+  ASSERT_THAT(state.snakes[2].eliminated_cause.cause,
+              Eq(EliminatedCause::Collision));
+  EXPECT_THAT(state.snakes[2].eliminated_cause.by_handle, Eq(1));
+  EXPECT_THAT(state.snakes[2].eliminated_cause.by_id, Eq(pool.Add("one")));
+}
+
 TEST_F(StandardEliminateSnakesTest, OtherTailChase) {
   StringPool pool;
   BoardState initial_state{
@@ -1543,6 +1676,77 @@ TEST_F(StandardEliminateSnakesTest, HeadToHeadEqualLength) {
                   pool.Add("one"))));
 }
 
+TEST_F(StandardEliminateSnakesTest, HeadToHeadThreeSnakes) {
+  StringPool pool;
+  BoardState initial_state{
+      .width = kBoardSizeSmall,
+      .height = kBoardSizeSmall,
+      .snakes = SnakesVector::Create({
+          Snake{
+              .id = pool.Add("one"),
+              .body = SnakeBody::Create({
+                  Point{1, 3},
+                  Point{1, 2},
+                  Point{1, 1},
+              }),
+              .health = 100,
+          },
+          Snake{
+              .id = pool.Add("two"),
+              .body = SnakeBody::Create({
+                  Point{2, 4},
+                  Point{3, 4},
+                  Point{4, 4},
+                  Point{5, 4},
+              }),
+              .health = 100,
+          },
+          Snake{
+              .id = pool.Add("three"),
+              .body = SnakeBody::Create({
+                  Point{1, 5},
+                  Point{1, 6},
+                  Point{1, 6},
+              }),
+              .health = 100,
+          },
+          Snake{
+              .id = pool.Add("four"),
+              .body = SnakeBody::Create({
+                  Point{5, 1},
+                  Point{5, 0},
+                  Point{6, 0},
+              }),
+              .health = 100,
+          },
+      }),
+  };
+
+  StandardRuleset ruleset;
+  BoardState state{};
+  ruleset.CreateNextBoardState(initial_state,
+                               SnakeMovesVector::Create({
+                                   {pool.Add("one"), Move::Up},
+                                   {pool.Add("two"), Move::Left},
+                                   {pool.Add("three"), Move::Down},
+                                   {pool.Add("four"), Move::Up},
+                               }),
+                               0, state);
+
+  // Both shorter snakes lose to the longest one.
+  EXPECT_THAT(
+      state.snakes,
+      ElementsAre(
+          SnakeIs(pool.Add("one"), _, _, EliminatedCause::HeadToHeadCollision,
+                  pool.Add("two")),
+          SnakeIs(pool.Add("two"), _, _, EliminatedCause::NotEliminated),
+          SnakeIs(pool.Add("three"), _, _,
+                  EliminatedCause::HeadToHeadCollision, pool.Add("two")),
+          SnakeIs(pool.Add("four"), _, _, EliminatedCause::NotEliminated)));
+  EXPECT_THAT(state.snakes[0].eliminated_cause.by_handle, Eq(1));
+  EXPECT_THAT(state.snakes[2].eliminated_cause.by_handle, Eq(1));
+}
+
 TEST_F(StandardEliminateSnakesTest, PriorityOutOfHealthOutOfBounds) {
   StringPool pool;
   BoardState initial_state{
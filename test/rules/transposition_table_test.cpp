@@ -0,0 +1,274 @@
+#include "battlesnake/rules/transposition_table.h"
+
+#include <thread>
+#include <vector>
+
+#include "battlesnake/rules/random.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::Ge;
+using ::testing::IsFalse;
+using ::testing::IsTrue;
+using ::testing::Le;
+
+using Entry = TranspositionTable::Entry;
+using Bound = TranspositionTable::Bound;
+
+// Hash that lands into the given bucket of the table.
+uint64_t HashInBucket(const TranspositionTable& table, uint64_t bucket,
+                      uint64_t n) {
+  return bucket + (n + 1) * table.BucketsCount();
+}
+
+TEST(JointMoveTest, SetAndGet) {
+  JointMove joint_move = 0;
+  SetSnakeMove(joint_move, 0, Move::Down);
+  SetSnakeMove(joint_move, 3, Move::Left);
+  SetSnakeMove(joint_move, 7, Move::Right);
+
+  EXPECT_THAT(GetSnakeMove(joint_move, 0), Eq(Move::Down));
+  EXPECT_THAT(GetSnakeMove(joint_move, 1), Eq(Move::Up));
+  EXPECT_THAT(GetSnakeMove(joint_move, 3), Eq(Move::Left));
+  EXPECT_THAT(GetSnakeMove(joint_move, 7), Eq(Move::Right));
+
+  SetSnakeMove(joint_move, 3, Move::Up);
+  EXPECT_THAT(GetSnakeMove(joint_move, 3), Eq(Move::Up));
+  EXPECT_THAT(GetSnakeMove(joint_move, 0), Eq(Move::Down));
+}
+
+TEST(JointMoveTest, PackAndUnpack) {
+  StringPool pool;
+  BoardState state{
+      .width = kBoardSizeSmall,
+      .height = kBoardSizeSmall,
+      .snakes = SnakesVector::Create({
+          Snake{.id = pool.Add("one")},
+          Snake{.id = pool.Add("two")},
+          Snake{.id = pool.Add("three")},
+      }),
+  };
+
+  JointMove joint_move = PackJointMove(
+      state, SnakeMovesVector::Create({
+                 SnakeMove{.snake_id = pool.Add("three"), .move = Move::Left},
+                 SnakeMove{.snake_id = pool.Add("one"), .move = Move::Down},
+             }));
+  SnakeMovesVector moves = UnpackJointMove(state, joint_move);
+
+  ASSERT_THAT(moves.size(), Eq(3));
+  EXPECT_THAT(moves[0].snake_id, Eq(state.snakes[0].id));
+  EXPECT_THAT(moves[0].move, Eq(Move::Down));
+  EXPECT_THAT(moves[1].snake_id, Eq(state.snakes[1].id));
+  EXPECT_THAT(moves[1].move, Eq(Move::Up));
+  EXPECT_THAT(moves[2].snake_id, Eq(state.snakes[2].id));
+  EXPECT_THAT(moves[2].move, Eq(Move::Left));
+}
+
+TEST(TranspositionTableTest, MemoryBudget) {
+  TranspositionTable table(1 << 20);
+  EXPECT_THAT(table.MemoryUsage(), Eq(1 << 20));
+  EXPECT_THAT(table.Capacity(), Eq((1 << 20) / 16));
+
+  TranspositionTable odd_size_table(3000);
+  EXPECT_THAT(odd_size_table.MemoryUsage(), Le(3000));
+  EXPECT_THAT(odd_size_table.BucketsCount(), Eq(32));
+
+  TranspositionTable tiny_table(0);
+  EXPECT_THAT(tiny_table.BucketsCount(), Eq(1));
+}
+
+TEST(TranspositionTableTest, StoreAndProbe) {
+  TranspositionTable table(1 << 16);
+  Entry entry{};
+
+  EXPECT_THAT(table.Probe(12345, entry), IsFalse());
+
+  table.Store(12345, Entry{
+                         .value = -1234,
+                         .depth = 7,
+                         .bound = Bound::Lower,
+                         .best_move = 0xABCD,
+                     });
+  ASSERT_THAT(table.Probe(12345, entry), IsTrue());
+  EXPECT_THAT(entry.value, Eq(-1234));
+  EXPECT_THAT(entry.depth, Eq(7));
+  EXPECT_THAT(entry.bound, Eq(Bound::Lower));
+  EXPECT_THAT(entry.best_move, Eq(0xABCD));
+
+  // Same bucket, different key.
+  EXPECT_THAT(table.Probe(HashInBucket(table, 12345 % table.BucketsCount(),
+                                       100),
+                          entry),
+              IsFalse());
+
+  TranspositionTable::Stats stats = table.GetStats();
+  EXPECT_THAT(stats.probes, Eq(3));
+  EXPECT_THAT(stats.hits, Eq(1));
+  EXPECT_THAT(stats.misses, Eq(2));
+  EXPECT_THAT(stats.stores, Eq(1));
+  EXPECT_THAT(stats.collisions, Eq(0));
+
+  table.ResetStats();
+  EXPECT_THAT(table.GetStats().probes, Eq(0));
+}
+
+TEST(TranspositionTableTest, ValuesAreClamped) {
+  TranspositionTable table(1 << 16);
+  Entry entry{};
+
+  table.Store(1, Entry{.value = 1000000, .depth = 1000, .bound = Bound::Exact});
+  ASSERT_THAT(table.Probe(1, entry), IsTrue());
+  EXPECT_THAT(entry.value, Eq(32767));
+  EXPECT_THAT(entry.depth, Eq(255));
+
+  table.Store(2, Entry{.value = -1000000, .depth = -5, .bound = Bound::Exact});
+  ASSERT_THAT(table.Probe(2, entry), IsTrue());
+  EXPECT_THAT(entry.value, Eq(-32768));
+  EXPECT_THAT(entry.depth, Eq(0));
+}
+
+TEST(TranspositionTableTest, EntriesWithoutBoundAreNotStored) {
+  TranspositionTable table(1 << 16);
+  Entry entry{};
+
+  table.Store(1, Entry{.value = 1, .depth = 1, .bound = Bound::None});
+  EXPECT_THAT(table.Probe(1, entry), IsFalse());
+}
+
+TEST(TranspositionTableTest, ShallowEntryIsReplacedWhenBucketIsFull) {
+  TranspositionTable table(1 << 16);
+  Entry entry{};
+
+  for (int i = 0; i < TranspositionTable::kEntriesPerBucket; ++i) {
+    table.Store(HashInBucket(table, 5, i),
+                Entry{.value = i, .depth = 10 - i, .bound = Bound::Exact});
+  }
+  table.Store(HashInBucket(table, 5, 100),
+              Entry{.value = 100, .depth = 1, .bound = Bound::Exact});
+
+  // Shallowest entry is gone.
+  EXPECT_THAT(
+      table.Probe(
+          HashInBucket(table, 5, TranspositionTable::kEntriesPerBucket - 1),
+          entry),
+      IsFalse());
+  for (int i = 0; i < TranspositionTable::kEntriesPerBucket - 1; ++i) {
+    EXPECT_THAT(table.Probe(HashInBucket(table, 5, i), entry), IsTrue());
+  }
+  EXPECT_THAT(table.Probe(HashInBucket(table, 5, 100), entry), IsTrue());
+  EXPECT_THAT(table.GetStats().collisions, Eq(1));
+}
+
+TEST(TranspositionTableTest, OldEntriesAreReplacedFirst) {
+  TranspositionTable table(1 << 16);
+  Entry entry{};
+
+  for (int i = 0; i < TranspositionTable::kEntriesPerBucket; ++i) {
+    table.Store(HashInBucket(table, 5, i),
+                Entry{.value = i, .depth = 20, .bound = Bound::Exact});
+    table.NewSearch();
+  }
+  table.Store(HashInBucket(table, 5, 100),
+              Entry{.value = 100, .depth = 1, .bound = Bound::Exact});
+
+  // The oldest entry is gone even though it's deeper.
+  EXPECT_THAT(table.Probe(HashInBucket(table, 5, 0), entry), IsFalse());
+  EXPECT_THAT(table.Probe(HashInBucket(table, 5, 100), entry), IsTrue());
+}
+
+TEST(TranspositionTableTest, SameStateReplacement) {
+  TranspositionTable table(1 << 16);
+  Entry entry{};
+
+  table.Store(7, Entry{.value = 1, .depth = 10, .bound = Bound::Lower});
+
+  // Shallower inexact result of the same search is ignored.
+  table.Store(7, Entry{.value = 2, .depth = 5, .bound = Bound::Upper});
+  ASSERT_THAT(table.Probe(7, entry), IsTrue());
+  EXPECT_THAT(entry.value, Eq(1));
+
+  // Exact result replaces.
+  table.Store(7, Entry{.value = 3, .depth = 5, .bound = Bound::Exact});
+  ASSERT_THAT(table.Probe(7, entry), IsTrue());
+  EXPECT_THAT(entry.value, Eq(3));
+
+  // Anything from a new search replaces.
+  table.NewSearch();
+  table.Store(7, Entry{.value = 4, .depth = 1, .bound = Bound::Upper});
+  ASSERT_THAT(table.Probe(7, entry), IsTrue());
+  EXPECT_THAT(entry.value, Eq(4));
+  EXPECT_THAT(table.GetStats().collisions, Eq(0));
+}
+
+TEST(TranspositionTableTest, Clear) {
+  TranspositionTable table(1 << 16);
+  Entry entry{};
+
+  table.Store(7, Entry{.value = 1, .depth = 10, .bound = Bound::Exact});
+  table.Clear();
+
+  EXPECT_THAT(table.Probe(7, entry), IsFalse());
+}
+
+// Many threads write and read entries, whose content is derived from the key.
+// Any entry returned must match its key.
+TEST(TranspositionTableTest, ConcurrentAccess) {
+  static constexpr int kThreads = 4;
+  static constexpr int kOperations = 200000;
+  // Small table to make threads fight for the same buckets.
+  TranspositionTable table(4096);
+
+  auto value_for = [](uint64_t hash) {
+    return static_cast<int>(hash % 30000);
+  };
+  auto move_for = [](uint64_t hash) {
+    return static_cast<JointMove>(hash >> 48);
+  };
+
+  std::vector<std::thread> threads;
+  std::vector<int> bad_entries(kThreads, 0);
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      RandomGenerator random(t + 1);
+      for (int i = 0; i < kOperations; ++i) {
+        // Small set of keys, so that probes hit often.
+        uint64_t hash = (random.Next() % 1000) * 0x9e3779b97f4a7c15ull + 1;
+        if (random.Uniform(2) == 0) {
+          table.Store(hash, Entry{
+                                .value = value_for(hash),
+                                .depth = random.Uniform(100),
+                                .bound = Bound::Exact,
+                                .best_move = move_for(hash),
+                            });
+        } else {
+          Entry entry{};
+          if (table.Probe(hash, entry) && (entry.value != value_for(hash) ||
+                                           entry.best_move != move_for(hash))) {
+            bad_entries[t]++;
+          }
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_THAT(bad_entries, ElementsAre(0, 0, 0, 0));
+  TranspositionTable::Stats stats = table.GetStats();
+  EXPECT_THAT(stats.hits, Ge(1));
+  EXPECT_THAT(stats.probes + stats.stores, Eq(kThreads * kOperations));
+}
+
+}  // namespace
+
+}  // namespace rules
+}  // namespace battlesnake
@@ -0,0 +1,82 @@
+#include <memory>
+#include <vector>
+
+#include "battlesnake/rules/random.h"
+#include "battlesnake/rules/standard_ruleset.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ruleset_test_helpers.h"
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+using Config = StandardRuleset::Config;
+using TurnPipeline = StandardRuleset::TurnPipeline;
+
+class TurnPipelineTest : public testing::TestWithParam<RulesetFactory> {};
+
+// Plays random games with both pipelines and compares states every turn.
+TEST_P(TurnPipelineTest, FusedSameAsStaged) {
+  StringPool pool;
+  std::vector<SnakeId> ids{pool.Add("a"), pool.Add("b"), pool.Add("c"),
+                           pool.Add("d")};
+  StringWrapper squads[] = {pool.Add("red"), pool.Add("blue")};
+  RandomGenerator moves_generator(1);
+
+  for (int game = 0; game < 40; ++game) {
+    // Lots of food and single piece snakes, so that snakes often eat,
+    // including several snakes eating the same food.
+    Config config{
+        .food_spawn_chance = 50,
+        .minimum_food = 3,
+        .snake_start_size = game % 2 == 0 ? 1 : 3,
+        .random_seed = static_cast<uint64_t>(game + 1),
+    };
+    config.turn_pipeline = TurnPipeline::Staged;
+    std::unique_ptr<StandardRuleset> staged_ruleset = GetParam().create(config);
+    config.turn_pipeline = TurnPipeline::Fused;
+    std::unique_ptr<StandardRuleset> fused_ruleset = GetParam().create(config);
+
+    BoardState staged_state = staged_ruleset->CreateInitialBoardState(
+        kBoardSizeSmall, kBoardSizeSmall, ids);
+    BoardState fused_state = fused_ruleset->CreateInitialBoardState(
+        kBoardSizeSmall, kBoardSizeSmall, ids);
+    for (int i = 0; i < staged_state.snakes.size(); ++i) {
+      staged_state.snakes[i].squad = squads[i % 2];
+      fused_state.snakes[i].squad = squads[i % 2];
+    }
+    ExpectSameState(fused_state, staged_state);
+
+    for (int turn = 1;
+         turn < 200 && !staged_ruleset->IsGameOver(staged_state); ++turn) {
+      JointMove joint_move = 0;
+      for (int i = 0; i < staged_state.snakes.size(); ++i) {
+        SetSnakeMove(joint_move, i,
+                     static_cast<Move>(moves_generator.Uniform(4)));
+      }
+
+      BoardState next_state{};
+      staged_ruleset->CreateNextBoardStateJoint(staged_state, joint_move, turn,
+                                                next_state);
+      staged_state = next_state;
+      fused_ruleset->ApplyJoint(fused_state, joint_move, turn);
+
+      SCOPED_TRACE(testing::Message() << "game " << game << " turn " << turn);
+      ExpectSameState(fused_state, staged_state);
+      if (testing::Test::HasFailure()) {
+        return;
+      }
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(AllRulesets, TurnPipelineTest,
+                         testing::ValuesIn(AllRulesets()),
+                         RulesetFactoryName);
+
+}  // namespace
+
+}  // namespace rules
+}  // namespace battlesnake
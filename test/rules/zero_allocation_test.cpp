@@ -0,0 +1,338 @@
+#include <iterator>
+#include <memory>
+#include <thread>
+
+#include "allocation_scope.h"
+#include "battlesnake/rules/board_analysis.h"
+#include "battlesnake/rules/board_bits_ops.h"
+#include "battlesnake/rules/children_expander.h"
+#include "battlesnake/rules/constrictor_ruleset.h"
+#include "battlesnake/rules/royale_ruleset.h"
+#include "battlesnake/rules/sized_board_state.h"
+#include "battlesnake/rules/sized_standard_ruleset.h"
+#include "battlesnake/rules/solo_ruleset.h"
+#include "battlesnake/rules/squad_ruleset.h"
+#include "battlesnake/rules/standard_ruleset.h"
+#include "battlesnake/rules/wrapped_ruleset.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace battlesnake {
+namespace rules {
+
+namespace {
+
+using ::battlesnake::allocations::AllocationScope;
+using ::testing::Eq;
+using ::testing::Gt;
+
+class ZeroAllocationTest : public testing::Test {
+ protected:
+  std::vector<SnakeId> CreateSnakeIds(int n) {
+    std::vector<SnakeId> result;
+    result.reserve(n);
+    for (int i = 0; i < n; ++i) {
+      result.push_back(pool_.Add("Snake" + std::to_string(i)));
+    }
+    return result;
+  }
+
+  static constexpr Move kMovesCycle[] = {
+      Move::Up,   Move::Up,   Move::Left,  Move::Left,
+      Move::Down, Move::Down, Move::Right, Move::Right,
+  };
+
+  static Move CycleMove(int snake_index, int turn) {
+    return kMovesCycle[(turn + snake_index) % std::size(kMovesCycle)];
+  }
+
+  // Plays the game for the given number of turns and returns number of heap
+  // allocations made by CreateNextBoardState and IsGameOver calls.
+  int CountAllocations(Ruleset& ruleset, const BoardState& initial_state,
+                       int turns) {
+    BoardState state = initial_state;
+    BoardState next_state{};
+
+    AllocationScope scope;
+    for (int turn = 1; turn <= turns; ++turn) {
+      SnakeMovesVector moves{};
+      for (int i = 0; i < state.snakes.size(); ++i) {
+        moves.push_back(SnakeMove{
+            .snake_id = state.snakes[i].id,
+            .move = CycleMove(i, turn),
+        });
+      }
+
+      ruleset.CreateNextBoardState(state, moves, turn, next_state);
+      state = next_state;
+      if (ruleset.IsGameOver(state)) {
+        break;
+      }
+    }
+
+    return scope.Count();
+  }
+
+  // Same, but each turn is applied by `apply_turn(state, joint_move, turn)`,
+  // which changes the state in place.
+  template <class RulesetT, class StateT, class ApplyTurn>
+  int CountJointAllocations(RulesetT& ruleset, const StateT& initial_state,
+                            int turns, ApplyTurn apply_turn) {
+    StateT state = initial_state;
+
+    AllocationScope scope;
+    for (int turn = 1; turn <= turns; ++turn) {
+      JointMove joint_move = 0;
+      for (int i = 0; i < state.snakes.size(); ++i) {
+        SetSnakeMove(joint_move, i, CycleMove(i, turn));
+      }
+
+      apply_turn(state, joint_move, turn);
+      if (ruleset.IsGameOver(state)) {
+        break;
+      }
+    }
+
+    return scope.Count();
+  }
+
+  // Moves the state to a child of the joint move, after generating all other
+  // children of the state.
+  template <class RulesetT, class StateT>
+  static void ExpandAllChildren(RulesetT& ruleset, StateT& state,
+                                JointMove joint_move, int turn) {
+    ChildrenExpanderT<RulesetT> expander(ruleset, state, MoveMasksVector{},
+                                         turn);
+    JointMove child_joint_move = 0;
+    StateT child{};
+    StateT next_state = state;
+    while (expander.Next(child_joint_move, child)) {
+      if (child_joint_move == joint_move) {
+        next_state = child;
+      }
+    }
+    state = next_state;
+  }
+
+  StringPool pool_;
+};
+
+TEST_F(ZeroAllocationTest, AllocationsAreDetected) {
+  AllocationScope scope;
+  auto data = std::make_unique<int>(1);
+
+  EXPECT_THAT(scope.Count(), Eq(1));
+  EXPECT_THAT(scope.Bytes(), Eq(sizeof(int)));
+}
+
+TEST_F(ZeroAllocationTest, OtherThreadsAreDetected) {
+  std::unique_ptr<int64_t> data;
+  AllocationScope scope;
+  std::thread thread([&data]() { data = std::make_unique<int64_t>(1); });
+  thread.join();
+
+  EXPECT_THAT(scope.OtherThreadsCount(), Eq(1));
+  EXPECT_THAT(scope.OtherThreadsBytes(), Eq(sizeof(int64_t)));
+  // Starting the thread allocates on this thread.
+  EXPECT_THAT(scope.Count(), Gt(1));
+}
+
+TEST_F(ZeroAllocationTest, Standard) {
+  StandardRuleset ruleset(StandardRuleset::Config{
+      .food_spawn_chance = 50,
+      .minimum_food = 3,
+  });
+  BoardState state = ruleset.CreateInitialBoardState(
+      kBoardSizeMedium, kBoardSizeMedium, CreateSnakeIds(4));
+
+  EXPECT_THAT(CountAllocations(ruleset, state, 50), Eq(0));
+}
+
+TEST_F(ZeroAllocationTest, StandardUnknownBoardSize) {
+  StandardRuleset ruleset(StandardRuleset::Config{
+      .food_spawn_chance = 50,
+      .minimum_food = 3,
+  });
+  BoardState state =
+      ruleset.CreateInitialBoardState(kBoardSizeMax, 13, CreateSnakeIds(8));
+
+  EXPECT_THAT(CountAllocations(ruleset, state, 50), Eq(0));
+}
+
+TEST_F(ZeroAllocationTest, Solo) {
+  SoloRuleset ruleset(StandardRuleset::Config{
+      .food_spawn_chance = 50,
+      .minimum_food = 3,
+  });
+  BoardState state = ruleset.CreateInitialBoardState(
+      kBoardSizeSmall, kBoardSizeSmall, CreateSnakeIds(1));
+
+  EXPECT_THAT(CountAllocations(ruleset, state, 50), Eq(0));
+}
+
+TEST_F(ZeroAllocationTest, Royale) {
+  RoyaleRuleset ruleset(StandardRuleset::Config::Default(),
+                        RoyaleRuleset::RoyaleConfig{
+                            .shrink_every_n_turns = 5,
+                        });
+  BoardState state = ruleset.CreateInitialBoardState(
+      kBoardSizeMedium, kBoardSizeMedium, CreateSnakeIds(4));
+
+  EXPECT_THAT(CountAllocations(ruleset, state, 50), Eq(0));
+}
+
+TEST_F(ZeroAllocationTest, Wrapped) {
+  WrappedRuleset ruleset;
+  BoardState state = ruleset.CreateInitialBoardState(
+      kBoardSizeMedium, kBoardSizeMedium, CreateSnakeIds(4));
+  state.Hazard().Set(Point{5, 5}, true);
+
+  EXPECT_THAT(CountAllocations(ruleset, state, 50), Eq(0));
+}
+
+TEST_F(ZeroAllocationTest, Squad) {
+  SquadRuleset ruleset;
+  BoardState state = ruleset.CreateInitialBoardState(
+      kBoardSizeMedium, kBoardSizeMedium, CreateSnakeIds(4));
+  StringWrapper squads[] = {pool_.Add("red"), pool_.Add("blue")};
+  for (int i = 0; i < state.snakes.size(); ++i) {
+    state.snakes[i].squad = squads[i % 2];
+  }
+
+  EXPECT_THAT(CountAllocations(ruleset, state, 50), Eq(0));
+}
+
+TEST_F(ZeroAllocationTest, Constrictor) {
+  ConstrictorRuleset ruleset;
+  BoardState state = ruleset.CreateInitialBoardState(
+      kBoardSizeMedium, kBoardSizeMedium, CreateSnakeIds(4));
+
+  EXPECT_THAT(CountAllocations(ruleset, state, 50), Eq(0));
+}
+
+TEST_F(ZeroAllocationTest, StandardJoint) {
+  StandardRuleset ruleset(StandardRuleset::Config{
+      .food_spawn_chance = 50,
+      .minimum_food = 3,
+  });
+  BoardState state = ruleset.CreateInitialBoardState(
+      kBoardSizeMedium, kBoardSizeMedium, CreateSnakeIds(4));
+
+  BoardState next_state{};
+  EXPECT_THAT(CountJointAllocations(
+                  ruleset, state, 50,
+                  [&](BoardState& state, JointMove joint_move, int turn) {
+                    ruleset.CreateNextBoardStateJoint(state, joint_move, turn,
+                                                      next_state);
+                    state = next_state;
+                  }),
+              Eq(0));
+}
+
+TEST_F(ZeroAllocationTest, StandardApplyUndo) {
+  StandardRuleset ruleset(StandardRuleset::Config{
+      .food_spawn_chance = 50,
+      .minimum_food = 3,
+  });
+  BoardState state = ruleset.CreateInitialBoardState(
+      kBoardSizeMedium, kBoardSizeMedium, CreateSnakeIds(4));
+
+  EXPECT_THAT(CountJointAllocations(
+                  ruleset, state, 50,
+                  [&](BoardState& state, JointMove joint_move, int turn) {
+                    UndoRecord undo = ruleset.ApplyJoint(state, joint_move,
+                                                         turn);
+                    ruleset.Undo(state, undo);
+                    ruleset.ApplyJoint(state, joint_move, turn);
+                  }),
+              Eq(0));
+}
+
+TEST_F(ZeroAllocationTest, StandardChildrenExpander) {
+  StandardRuleset ruleset(StandardRuleset::Config{
+      .food_spawn_chance = 50,
+      .minimum_food = 3,
+  });
+  BoardState state = ruleset.CreateInitialBoardState(
+      kBoardSizeMedium, kBoardSizeMedium, CreateSnakeIds(4));
+
+  EXPECT_THAT(CountJointAllocations(
+                  ruleset, state, 20,
+                  [&](BoardState& state, JointMove joint_move, int turn) {
+                    ExpandAllChildren(ruleset, state, joint_move, turn);
+                  }),
+              Eq(0));
+}
+
+class SizedZeroAllocationTest : public ZeroAllocationTest {
+ protected:
+  using SizedRuleset = StandardRulesetT<kBoardSizeMedium, kBoardSizeMedium,
+                                        kSnakesCountStandard>;
+  using SizedState = SizedRuleset::State;
+
+  SizedState CreateInitialState() {
+    return SizedState::FromBoardState(ruleset_.CreateInitialBoardState(
+        kBoardSizeMedium, kBoardSizeMedium, CreateSnakeIds(4)));
+  }
+
+  SizedRuleset ruleset_{StandardRuleset::Config{
+      .food_spawn_chance = 50,
+      .minimum_food = 3,
+  }};
+};
+
+TEST_F(SizedZeroAllocationTest, CreateNextBoardStateJoint) {
+  SizedState next_state{};
+  EXPECT_THAT(CountJointAllocations(
+                  ruleset_, CreateInitialState(), 50,
+                  [&](SizedState& state, JointMove joint_move, int turn) {
+                    ruleset_.CreateNextBoardStateJoint(state, joint_move, turn,
+                                                       next_state);
+                    state = next_state;
+                  }),
+              Eq(0));
+}
+
+TEST_F(SizedZeroAllocationTest, ApplyUndo) {
+  EXPECT_THAT(CountJointAllocations(
+                  ruleset_, CreateInitialState(), 50,
+                  [&](SizedState& state, JointMove joint_move, int turn) {
+                    SizedState::UndoRecord undo =
+                        ruleset_.ApplyJoint(state, joint_move, turn);
+                    ruleset_.Undo(state, undo);
+                    ruleset_.ApplyJoint(state, joint_move, turn);
+                  }),
+              Eq(0));
+}
+
+TEST_F(SizedZeroAllocationTest, ChildrenExpander) {
+  EXPECT_THAT(CountJointAllocations(
+                  ruleset_, CreateInitialState(), 20,
+                  [&](SizedState& state, JointMove joint_move, int turn) {
+                    ExpandAllChildren(ruleset_, state, joint_move, turn);
+                  }),
+              Eq(0));
+}
+
+TEST_F(ZeroAllocationTest, ComputeTerritory) {
+  StandardRuleset ruleset;
+  BoardState state = ruleset.CreateInitialBoardState(
+      kBoardSizeMedium, kBoardSizeMedium, CreateSnakeIds(8));
+  const BoardBitsShifter shifter(state.width, state.height);
+
+  AllocationScope scope;
+  Territory territory = ComputeTerritory(state, shifter);
+
+  EXPECT_THAT(scope.Count(), Eq(0));
+  // Fixed start positions may be shared, so some snakes may get no area.
+  int total_area = 0;
+  for (int i = 0; i < state.snakes.size(); ++i) {
+    total_area += territory.area[i];
+  }
+  EXPECT_THAT(total_area, Gt(0));
+}
+
+}  // namespace
+
+}  // namespace rules
+}  // namespace battlesnake
@@ -4,8 +4,10 @@
 #include <memory>
 #include <thread>
 
+#include "allocation_scope.h"
 #include "battlesnake/interface/battlesnake.h"
 #include "battlesnake/json/converter.h"
+#include "battlesnake/server/move_handler.h"
 #include "client_http.hpp"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -21,8 +23,12 @@ using ::testing::Eq;
 using ::testing::Ge;
 using ::testing::IsFalse;
 using ::testing::IsNull;
+using ::testing::IsTrue;
+using ::testing::Le;
 using ::testing::Lt;
+using ::testing::Ne;
 using ::testing::NiceMock;
+using ::testing::NotNull;
 using ::testing::Pointee;
 using ::testing::Return;
 
@@ -30,11 +36,19 @@ using namespace battlesnake::rules;
 using namespace battlesnake::interface;
 using namespace battlesnake::json;
 
+using ::battlesnake::allocations::AllocationScope;
+
 using HttpClient = SimpleWeb::Client<SimpleWeb::HTTP>;
 
 constexpr int kPortNumber = 18888;
 constexpr int kThreadsCount = 2;
 
+// Budget of heap allocations made by HandleMove(): parsing a /move request
+// into a new string pool, the default move and the JSON response. Measured at
+// 135, the rest leaves room for other versions of nlohmann::json. Lower it when
+// allocations are removed.
+constexpr int kMoveAllocationsBudget = 150;
+
 class TestBattlesnakeSync : public Battlesnake {
  public:
   MOCK_METHOD(Customization, GetCustomization, ());
@@ -94,7 +108,7 @@ GameState CreateGameState(StringPool& pool) {
           }),
           .health = 75,
           .name = pool.Add("Test Caterpillar"),
-          .latency = pool.Add("123"),
+          .latency = 123,
           .shout = pool.Add("Why are we shouting???"),
           .squad = pool.Add("The Suicide Squad"),
       },
@@ -221,6 +235,22 @@ TEST_F(ServerTestSync, Move) {
   EXPECT_THAT(response["shout"], Eq("Why are we shouting???"));
 }
 
+TEST(MoveHandlerTest, Allocations) {
+  // Default implementation, mocks allocate on every call.
+  Battlesnake battlesnake;
+  StringPool pool;
+  const std::string request = CreateJson(CreateGameState(pool)).dump();
+
+  std::string body;
+  AllocationScope scope;
+  HandleMove(battlesnake, request,
+             [&body](const std::string& response) { body = response; });
+  const int64_t allocations = scope.Count();
+
+  EXPECT_THAT(allocations, Le(kMoveAllocationsBudget));
+  EXPECT_THAT(nlohmann::json::parse(body)["move"], Eq("up"));
+}
+
 // -----------------------------------------------------------------------------
 
 class ServerTestAsync : public testing::Test {
@@ -431,6 +461,55 @@ TEST_F(ServerTestAsync, Move) {
   EXPECT_THAT(response["shout"], Eq("Why am I so slow???"));
 }
 
+TEST_F(ServerTestAsync, StringPoolPerRequest) {
+  testing::NiceMock<TestBattlesnakeAsync> battlesnake;
+  BattlesnakeServer server(&battlesnake, kPortNumber, kThreadsCount);
+  auto server_thread = server.RunOnNewThread();
+
+  StringPool pool;
+  auto game = CreateGameState(pool);
+
+  // The first pool is held until the second request is handled, so both are
+  // alive at once and their addresses can be compared.
+  std::shared_ptr<StringPool> held_first_pool;
+  const StringPool* first_pool_ptr = nullptr;
+  const StringPool* second_pool_ptr = nullptr;
+  std::weak_ptr<StringPool> first_pool;
+  std::weak_ptr<StringPool> second_pool;
+  EXPECT_CALL(battlesnake, Move(_, _, _))
+      .WillOnce([&](std::shared_ptr<StringPool> string_pool,
+                    const GameState& game_state,
+                    std::function<void(const Battlesnake::MoveResponse& result)>
+                        respond) -> void {
+        held_first_pool = string_pool;
+        first_pool_ptr = string_pool.get();
+        first_pool = string_pool;
+        respond(Battlesnake::MoveResponse{});
+      })
+      .WillOnce([&](std::shared_ptr<StringPool> string_pool,
+                    const GameState& game_state,
+                    std::function<void(const Battlesnake::MoveResponse& result)>
+                        respond) -> void {
+        second_pool_ptr = string_pool.get();
+        second_pool = string_pool;
+        respond(Battlesnake::MoveResponse{});
+      });
+
+  Post("/move", CreateJson(game).dump());
+  Post("/move", CreateJson(game).dump());
+
+  server.Stop();
+  server_thread->join();
+
+  EXPECT_THAT(first_pool_ptr, NotNull());
+  EXPECT_THAT(second_pool_ptr, NotNull());
+  EXPECT_THAT(second_pool_ptr, Ne(first_pool_ptr));
+  // Freed after the requests, nothing else holds them.
+  held_first_pool.reset();
+  EXPECT_THAT(first_pool.expired(), IsTrue());
+  EXPECT_THAT(second_pool.expired(), IsTrue());
+}
+
 }  // namespace
 }  // namespace server
 }  // namespace battlesnake